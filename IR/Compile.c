@@ -7,7 +7,7 @@
 #define STACK_MAX_NUM 20
 
 #define COMPILE(root, part) \
-  compile##part(getChildByName(root, #part))
+  compile##part(getChildByKind(root, S_##part))
 
 #define CODE_ASSIGN(left_, right_) (Code){\
     .kind = C_ASSIGN,\
@@ -37,23 +37,22 @@
   .kind = O_CONSTANT, .value = value_\
 }
 
-int label_cnt = 0;
-int tmp_cnt = 0;
+// the state of `compile`, each thread translates its own file
+static _Thread_local int label_cnt = 0;
+static _Thread_local int tmp_cnt = 0;
 
-const SymbolTable *symbolTable;
-Chunk *sentinelChunk = NULL;
+static _Thread_local const SymbolTable *symbolTable;
+static _Thread_local CodeList *codeList = NULL;
 
 // a handy way to get parameters' information while inside `CompSt`
-struct {
+static _Thread_local struct {
   int argc;
   // pointing to the function type
-  Type **argv;
+  const Type **argv;
   // a list of parameter name
-  char *param_s[MAX_DIMENSION];
+  InternId param_s[MAX_DIMENSION];
 } funcParamInfo;
 
-static unsigned arrayTypeSize(const char *name, int depth);
-
 static void compileArgs(const ParseTNode *node, Operand *stack, int *top);
 
 // helper function of `compileExp`
@@ -67,16 +66,16 @@ static Operand evalFuncInvocation(const ParseTNode *node) {
   if (strcmp(func_name, "read") == 0) {
     assert(i == 1);
     const Operand tmp = OP_TEMP();
-    addCode(sentinelChunk, CODE_UNARY(READ, tmp));
+    addCode(codeList, CODE_UNARY(READ, tmp));
     return tmp;
   }
   if (i == 0) {
     Operand stack[STACK_MAX_NUM]; // maximum 20 arguments
     int top = 0;
-    compileArgs(getChildByName(node, "Args"), stack, &top);
+    compileArgs(getChildByKind(node, S_Args), stack, &top);
     if (strcmp(func_name, "write") == 0) {
       assert(top == 1);
-      addCode(sentinelChunk, CODE_UNARY(WRITE, stack[0]));
+      addCode(codeList, CODE_UNARY(WRITE, stack[0]));
       return OP_CONSTANT(0);
     }
     /** add this in proj4
@@ -85,15 +84,15 @@ static Operand evalFuncInvocation(const ParseTNode *node) {
     if (top >= 6)
       reverseArray(stack + 4, top - 4, sizeof(Operand));
     for (int j = 0; j < top; ++j)
-      addCode(sentinelChunk, CODE_UNARY(ARG, stack[j]));
+      addCode(codeList, CODE_UNARY(ARG, stack[j]));
   }
   // i == 0 or i == 1
   const Operand tmp = OP_TEMP();
   const Operand func_op = (Operand){
     .kind = O_INVOKE,
-    .value_s = my_strdup(func_name)
+    .name = getIdFrom(node, ID)
   };
-  addCode(sentinelChunk, CODE_ASSIGN(tmp, func_op));
+  addCode(codeList, CODE_ASSIGN(tmp, func_op));
   return tmp;
 }
 
@@ -102,7 +101,6 @@ static Operand compileExp(const ParseTNode *node);
 // helper function of `evalRelation` and `compileBranch`
 static void compileCondition(const ParseTNode *node,
                              const Operand *T_label, const Operand *F_label) {
-#define names_equal(i) nodeChildrenNamesEqual(node, expressions[i])
 #define CODE_IFGOTO(x_, y_, label_, relation_) (Code){\
   .kind = C_IFGOTO,\
   .as.ternary = {\
@@ -111,58 +109,54 @@ static void compileCondition(const ParseTNode *node,
     .relation = relation_\
     }\
   }
-  const char *expressions[] = {
-    "NOT Exp",
-    "Exp AND Exp",
-    "Exp OR Exp",
-    "Exp RELOP Exp",
-  };
-  if (names_equal(0))
-    return compileCondition(getChild(node, 1), F_label, T_label);
-  if (names_equal(1)) {
-    const Operand label = OP_LABEL();
-    compileCondition(getChild(node, 0), &label, F_label);
-    addCode(sentinelChunk, CODE_UNARY(LABEL, label));
-    compileCondition(getChild(node, 2), T_label, F_label);
-    return;
-  }
-  if (names_equal(2)) {
-    const Operand label = OP_LABEL();
-    compileCondition(getChild(node, 0), T_label, &label);
-    addCode(sentinelChunk, CODE_UNARY(LABEL, label));
-    compileCondition(getChild(node, 2), T_label, F_label);
-    return;
-  }
-  if (names_equal(3)) {
-    // notice here: use `compileExp` rather than `compileCondition`
-    const Operand o1 = compileExp(getChild(node, 0));
-    const Operand o2 = compileExp(getChild(node, 2));
-    addCode(sentinelChunk,
-            CODE_IFGOTO(o1, o2, *T_label,
-                        my_strdup(getStrFrom(node, RELOP))));
-    addCode(sentinelChunk, CODE_UNARY(GOTO, *F_label));
-    return;
+  switch (node->production) {
+    case P_Exp_NOT:
+      return compileCondition(getChild(node, 1), F_label, T_label);
+    case P_Exp_AND: {
+      const Operand label = OP_LABEL();
+      compileCondition(getChild(node, 0), &label, F_label);
+      addCode(codeList, CODE_UNARY(LABEL, label));
+      compileCondition(getChild(node, 2), T_label, F_label);
+      return;
+    }
+    case P_Exp_OR: {
+      const Operand label = OP_LABEL();
+      compileCondition(getChild(node, 0), T_label, &label);
+      addCode(codeList, CODE_UNARY(LABEL, label));
+      compileCondition(getChild(node, 2), T_label, F_label);
+      return;
+    }
+    case P_Exp_RELOP: {
+      // notice here: use `compileExp` rather than `compileCondition`
+      const Operand o1 = compileExp(getChild(node, 0));
+      const Operand o2 = compileExp(getChild(node, 2));
+      addCode(codeList,
+              CODE_IFGOTO(o1, o2, *T_label, getRelopFrom(node)));
+      addCode(codeList, CODE_UNARY(GOTO, *F_label));
+      return;
+    }
+    default:
+      break;
   }
   // single expression condition
   // e.g. if(a), if(a[0])...
   // note: pass the same node to `compileExp`
-  addCode(sentinelChunk,
+  addCode(codeList,
           CODE_IFGOTO(compileExp(node), OP_CONSTANT(0),
-                      *T_label, my_strdup("!=")));
-  addCode(sentinelChunk, CODE_UNARY(GOTO, *F_label));
-#undef names_equal
+                      *T_label, REL_NE));
+  addCode(codeList, CODE_UNARY(GOTO, *F_label));
 #undef CODE_IFGOTO
 }
 
 // helper function of `compileExp`
 static Operand evalRelation(const ParseTNode *node) {
   const Operand result = OP_TEMP();
-  addCode(sentinelChunk, CODE_ASSIGN(result, OP_CONSTANT(0)));
+  addCode(codeList, CODE_ASSIGN(result, OP_CONSTANT(0)));
   const Operand T_label = OP_LABEL(), F_label = OP_LABEL();
   compileCondition(node, &T_label, &F_label);
-  addCode(sentinelChunk, CODE_UNARY(LABEL, T_label));
-  addCode(sentinelChunk, CODE_ASSIGN(result, OP_CONSTANT(1)));
-  addCode(sentinelChunk, CODE_UNARY(LABEL, F_label));
+  addCode(codeList, CODE_UNARY(LABEL, T_label));
+  addCode(codeList, CODE_ASSIGN(result, OP_CONSTANT(1)));
+  addCode(codeList, CODE_UNARY(LABEL, F_label));
   return result;
 }
 
@@ -181,7 +175,7 @@ static Operand evalArithmatic(const ParseTNode *node) {
     const Operand op1 = compileExp(getChild(node, 0)); \
     const Operand op2 = compileExp(getChild(node, 2)); \
     const Operand result = OP_TEMP(); \
-    addCode(sentinelChunk, CODE_BINARY(T, result, op1, op2)); \
+    addCode(codeList, CODE_BINARY(T, result, op1, op2)); \
     return result; \
   }
   CODE_BINARY_CASE(ADD);
@@ -195,9 +189,9 @@ static Operand evalArithmatic(const ParseTNode *node) {
 /**
  *  helper function of `derefArray`
  *  memorize those index value from right to left.
- *  @return a pointer directly pointing to string value, no copy.
+ *  @return the expression being indexed, which is not an index itself.
  */
-static const char* gatherArrayInfo(const ParseTNode *node, Operand stack[], int *top) {
+static const ParseTNode* gatherArrayInfo(const ParseTNode *node, Operand stack[], int *top) {
   if (*top >= STACK_MAX_NUM) {
     DEBUG_INFO("Too much dimension. Only support %d.\n", STACK_MAX_NUM);
     exit(EXIT_FAILURE);
@@ -205,93 +199,132 @@ static const char* gatherArrayInfo(const ParseTNode *node, Operand stack[], int
 
   stack[(*top)++] = compileExp(getChild(node, 2));
   const ParseTNode *exp = getChild(node, 0);
-  if (nodeChildrenNamesEqual(exp, "ID")) {
-    return getStrFrom(exp, ID);
-  }
+  if (exp->production != P_Exp_Index) return exp;
   return gatherArrayInfo(exp, stack, top);
 }
 
-// helper function of `derefArray` and `compileExp`
-static Operand evalVariable(const char *name) {
-  const char *name_copy = my_strdup(name);
+// the type of variable, parameters come first
+static const Type* variableType(const InternId name) {
+  for (int i = 0; i < funcParamInfo.argc; ++i) {
+    if (name == funcParamInfo.param_s[i]) return funcParamInfo.argv[i];
+  }
+  return searchWithName(symbolTable->vars, internedStr(name))->variable.type;
+}
+
+// helper function of `evalAddress` and `compileExp`
+static Operand evalVariable(const InternId name) {
   // search in funcParamInfo
   for (int i = 0; i < funcParamInfo.argc; ++i) {
-    if (strcmp(name, funcParamInfo.param_s[i]) != 0) continue;
-    // always return name, whether it is array or basic type.
-    return (Operand){.kind = O_VARIABLE, .value_s = name_copy};
+    if (name != funcParamInfo.param_s[i]) continue;
+    // always return name, arrays and structs are passed in by address.
+    return (Operand){.kind = O_VARIABLE, .name = name};
   }
-  const Type *type = searchWithName(symbolTable->vars, name)->variable.type;
+  const Type *type = searchWithName(symbolTable->vars, internedStr(name))->variable.type;
   assert(type->kind != ERROR);
   // search in symbolTable
-  if (type->kind == STRUCT) {
-    DEBUG_INFO("Not implement yet.\n");
-    exit(EXIT_FAILURE);
-  }
-  if (type->kind == ARRAY) {
-    Operand *var_op = malloc(sizeof(Operand));
-    var_op->kind = O_VARIABLE;
-    var_op->value_s = name_copy;
-    return (Operand){.kind = O_REFER, .address = var_op};
+  if (either(type->kind, ARRAY, STRUCT)) {
+    const Operand var_op = {.kind = O_VARIABLE, .name = name};
+    return address_op(O_REFER, var_op);
   }
   // basic type
-  return (Operand){.kind = O_VARIABLE, .value_s = name_copy};
+  return (Operand){.kind = O_VARIABLE, .name = name};
+}
+
+static Operand dereference(const ParseTNode *node, const Type **type);
+
+/**
+ *  helper function of `derefArray` and `derefStruct`
+ *  @param type set to the type of the array or struct
+ *  @return the operand holding the address of an array or struct
+ */
+static Operand evalAddress(const ParseTNode *node, const Type **type) {
+  if (node->production == P_Exp_ID) {
+    const InternId name = getIdFrom(node, ID);
+    *type = variableType(name);
+    return evalVariable(name);
+  }
+  const Operand addr_op = dereference(node, type);
+  assert(either((*type)->kind, ARRAY, STRUCT));
+  return addr_op;
+}
+
+// an element of array or a field of struct is read through its address, unless it is still an aggregate.
+static Operand derefAddress(const Operand *addr_op, const Type *type) {
+  if (either(type->kind, ARRAY, STRUCT)) return *addr_op;
+  assert(addr_op->kind == O_TEM_VAR);
+  return address_op(O_DEREF, *addr_op);
 }
 
 // helper function of `dereference`
-static Operand derefArray(const ParseTNode *node) {
+static Operand derefArray(const ParseTNode *node, const Type **type) {
   const char *expressions[] = {"Exp LB Exp RB"};
   assert(EXPRESSION_INDEX(node, expressions) == 0);
 
   Operand stack[STACK_MAX_NUM];
   int top = 0;
-  const char *name = gatherArrayInfo(node, stack, &top);
-  const Operand base_addr_op = evalVariable(name);
+  const ParseTNode *base = gatherArrayInfo(node, stack, &top);
+  const Type *base_type = NULL;
+  const Operand base_addr_op = evalAddress(base, &base_type);
+  // elem_types[j] is the type after indexing j + 1 times
+  const Type *elem_types[STACK_MAX_NUM];
+  for (int j = 0; j < top; ++j) {
+    assert(base_type->kind == ARRAY);
+    base_type = elem_types[j] = base_type->array.elemType;
+  }
 
   const Operand offset_op = OP_TEMP();
-  addCode(sentinelChunk, CODE_ASSIGN(offset_op, OP_CONSTANT(0)));
+  addCode(codeList, CODE_ASSIGN(offset_op, OP_CONSTANT(0)));
   const Operand tmp = OP_TEMP();  // no need to create a new temp variable each loop
   for (int i = 0; i < top; ++i) { // sum all offsets
-    addCode(sentinelChunk,
+    addCode(codeList,
             CODE_BINARY(MUL, tmp, stack[i],
-                        OP_CONSTANT(arrayTypeSize(name, top - i))));
-    addCode(sentinelChunk, CODE_BINARY(ADD, offset_op, offset_op, tmp));
+                        OP_CONSTANT(elem_types[top - i - 1]->bytes)));
+    addCode(codeList, CODE_BINARY(ADD, offset_op, offset_op, tmp));
   }
 
   const Operand result_addr_op = OP_TEMP();
-  addCode(sentinelChunk, CODE_BINARY(ADD, result_addr_op, base_addr_op, offset_op));
-
-  Operand *deref_op = malloc(sizeof(Operand));
-  *deref_op = result_addr_op; // get a copy of result_addr in heap.
-  return (Operand){.kind = O_DEREF, .address = deref_op};
+  addCode(codeList, CODE_BINARY(ADD, result_addr_op, base_addr_op, offset_op));
+  *type = elem_types[top - 1];
+  return derefAddress(&result_addr_op, *type);
 }
 
-// helper function of `dereference`
-static Operand derefStruct(const ParseTNode *node) {
+// helper function of `dereference`, the offset of field comes from the layout of struct
+static Operand derefStruct(const ParseTNode *node, const Type **type) {
   const char *expressions[] = {"Exp DOT ID"};
   assert(EXPRESSION_INDEX(node, expressions) == 0);
 
-  DEBUG_INFO("Not implement yet.\n");
-  exit(EXIT_FAILURE);
+  const Type *struct_type = NULL;
+  const Operand base_addr_op = evalAddress(getChildByKind(node, S_Exp), &struct_type);
+  assert(struct_type->kind == STRUCT);
+  const structFieldElement *field = findStructField(struct_type, getStrFrom(node, ID));
+  assert(field != NULL);
+
+  const Operand result_addr_op = OP_TEMP();
+  addCode(codeList,
+          CODE_BINARY(ADD, result_addr_op, base_addr_op, OP_CONSTANT(field->offset)));
+  *type = field->elemType;
+  return derefAddress(&result_addr_op, *type);
 }
 
-// helper function of `evalExp`
-static Operand dereference(const ParseTNode *node) {
+/**
+ * helper function of `evalExp`
+ * @param type set to the type of the element or field
+ */
+static Operand dereference(const ParseTNode *node, const Type **type) {
   const char *expressions[] = {
     "Exp LB Exp RB",
     "Exp DOT ID",
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  if (i == 0) return derefArray(node);
-  if (i == 1) return derefStruct(node);
+  if (i == 0) return derefArray(node, type);
+  if (i == 1) return derefStruct(node, type);
   DEBUG_INFO("Shouldn't reach this place.\n");
   exit(EXIT_FAILURE);
 }
 
-// todo check every receiver of this function, and make it free.
-// remember to free returned operand
 static Operand compileExp(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Exp") == 0);
+  assert(node->kind == S_Exp);
   // Notice: remove AND, OR, RELOP, NOT. They are now inside compileCondition.
   const char *expressions[] = {
     [0] = "Exp ASSIGNOP Exp",
@@ -317,9 +350,8 @@ static Operand compileExp(const ParseTNode *node) {
   if (i == 0) {
     const Operand right = compileExp(getChild(node, 2));
     const Operand left = compileExp(getChild(node, 0));
-    addCode(sentinelChunk, CODE_ASSIGN(left, right));
-    // if return right_op, this may cause double free error.
-    return copyOperand(&right);
+    addCode(codeList, CODE_ASSIGN(left, right));
+    return right;
   }
   if (1 <= i && i <= 4)
     return evalArithmatic(node);
@@ -328,16 +360,18 @@ static Operand compileExp(const ParseTNode *node) {
   if (i == 6) {
     const Operand right = COMPILE(node, Exp);
     const Operand result = OP_TEMP();
-    addCode(sentinelChunk,
+    addCode(codeList,
             CODE_BINARY(SUB, result, OP_CONSTANT(0), right));
     return result;
   }
   if (i == 7 || i == 8)
     return evalFuncInvocation(node);
-  if (i == 9 || i == 10)
-    return dereference(node);
+  if (i == 9 || i == 10) {
+    const Type *type = NULL;
+    return dereference(node, &type);
+  }
   if (i == 11)
-    return evalVariable(getStrFrom(node, ID));
+    return evalVariable(getIdFrom(node, ID));
   if (i == 12)
     return OP_CONSTANT(getValFromINT(node));
   if (i == 13) {
@@ -352,7 +386,7 @@ static Operand compileExp(const ParseTNode *node) {
 
 static void compileArgs(const ParseTNode *node, Operand *stack, int *top) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Args") == 0);
+  assert(node->kind == S_Args);
   const char *expressions[] = {
     "Exp",
     "Exp COMMA Args"
@@ -364,69 +398,69 @@ static void compileArgs(const ParseTNode *node, Operand *stack, int *top) {
   }
   stack[(*top)++] = COMPILE(node, Exp);
   if (i == 1)
-    compileArgs(getChildByName(node, "Args"), stack, top);
+    compileArgs(getChildByKind(node, S_Args), stack, top);
 }
 
 /**
  *  helper function of `compileVarDec`
- *  @note not the copy, directly pointing to the original value.
+ *  @return the interned name of the variable.
  */
-const char* getVariableName(const ParseTNode *node) {
+InternId getVariableName(const ParseTNode *node) {
   const char *expressions[] = {
     "ID",
     "VarDec LB INT RB"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  if (i == 0) return getStrFrom(node, ID);
-  return getVariableName(getChildByName(node, "VarDec"));
+  if (i == 0) return getIdFrom(node, ID);
+  return getVariableName(getChildByKind(node, S_VarDec));
 }
 
 static Operand compileVarDec(const ParseTNode *node, const bool is_param) {
   assert(node != NULL);
-  assert(strcmp(node->name,"VarDec") == 0);
+  assert(node->kind == S_VarDec);
   const char *expressions[] = {
     "ID",
     "VarDec LB INT RB"
   };
-  const int i = EXPRESSION_INDEX(node, expressions);
-  const char *name_copy = my_strdup(getVariableName(node));
-  const Operand var_op = (Operand){.kind = O_VARIABLE, .value_s = name_copy};
-
-  if (i == 0 || is_param) return var_op;
-  addCode(sentinelChunk, (Code){
+  EXPRESSION_INDEX(node, expressions);
+  const Operand var_op = (Operand){.kind = O_VARIABLE, .name = getVariableName(node)};
+
+  if (is_param) return var_op;
+  // arrays and structs need their space
+  const Type *type = variableType(var_op.name);
+  if (!either(type->kind, ARRAY, STRUCT)) return var_op;
+  addCode(codeList, (Code){
             .kind = C_DEC,
             .as.dec = {
               .target = var_op,
-              .size = arrayTypeSize(name_copy, 0)
+              .size = type->bytes
             }
           });
-  return copyOperand(&var_op);
+  return var_op;
 }
 
 static void compileDec(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Dec") == 0);
+  assert(node->kind == S_Dec);
   const char *expressions[] = {
     "VarDec",
     "VarDec ASSIGNOP Exp"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 0) {
-    const Operand tmp =
-        compileVarDec(getChildByName(node, "VarDec"),false);
-    cleanOp(&tmp);
+    compileVarDec(getChildByKind(node, S_VarDec), false);
     return;
   }
   // right first
   const Operand right = COMPILE(node, Exp);
   const Operand left =
-      compileVarDec(getChildByName(node, "VarDec"),false);
-  addCode(sentinelChunk, CODE_ASSIGN(left, right));
+      compileVarDec(getChildByKind(node, S_VarDec),false);
+  addCode(codeList, CODE_ASSIGN(left, right));
 }
 
 static void compileDecList(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"DecList") == 0);
+  assert(node->kind == S_DecList);
   const char *expressions[] = {
     "Dec",
     "Dec COMMA DecList"
@@ -439,7 +473,7 @@ static void compileDecList(const ParseTNode *node) {
 
 static void compileDef(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Def") == 0);
+  assert(node->kind == S_Def);
   const char *expressions[] = {
     "Specifier DecList SEMI"
   };
@@ -449,7 +483,7 @@ static void compileDef(const ParseTNode *node) {
 
 static void compileDefList(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"DefList") == 0);
+  assert(node->kind == S_DefList);
   const char *expressions[] = {
     "",
     "Def DefList"
@@ -467,10 +501,10 @@ static void compileIfStmt(const ParseTNode *node) {
   assert(EXPRESSION_INDEX(node, expressions) == 0);
   const Operand T_label = OP_LABEL();
   const Operand F_label = OP_LABEL();
-  compileCondition(getChildByName(node, "Exp"), &T_label, &F_label);
-  addCode(sentinelChunk, CODE_UNARY(LABEL, T_label));
+  compileCondition(getChildByKind(node, S_Exp), &T_label, &F_label);
+  addCode(codeList, CODE_UNARY(LABEL, T_label));
   COMPILE(node, Stmt);
-  addCode(sentinelChunk, CODE_UNARY(LABEL, F_label));
+  addCode(codeList, CODE_UNARY(LABEL, F_label));
 }
 
 // helper function of `compileBranches`
@@ -479,14 +513,14 @@ static void compileIfElseStmt(const ParseTNode *node) {
   assert(EXPRESSION_INDEX(node, expressions) == 0);
   const Operand T_label = OP_LABEL();
   const Operand F_label = OP_LABEL();
-  compileCondition(getChildByName(node, "Exp"), &T_label, &F_label);
-  addCode(sentinelChunk, CODE_UNARY(LABEL, T_label));
+  compileCondition(getChildByKind(node, S_Exp), &T_label, &F_label);
+  addCode(codeList, CODE_UNARY(LABEL, T_label));
   compileStmt(getChild(node, 4));
   const Operand jump = OP_LABEL();
-  addCode(sentinelChunk, CODE_UNARY(GOTO, jump));
-  addCode(sentinelChunk, CODE_UNARY(LABEL, F_label));
+  addCode(codeList, CODE_UNARY(GOTO, jump));
+  addCode(codeList, CODE_UNARY(LABEL, F_label));
   compileStmt(getChild(node, 6));
-  addCode(sentinelChunk, CODE_UNARY(LABEL, jump));
+  addCode(codeList, CODE_UNARY(LABEL, jump));
 }
 
 // helper function of `compileBranches`
@@ -494,14 +528,14 @@ static void compileWhileStmt(const ParseTNode *node) {
   const char *expressions[] = {"WHILE LP Exp RP Stmt"};
   assert(EXPRESSION_INDEX(node, expressions) == 0);
   const Operand start = OP_LABEL();
-  addCode(sentinelChunk, CODE_UNARY(LABEL, start));
+  addCode(codeList, CODE_UNARY(LABEL, start));
   const Operand T_label = OP_LABEL();
   const Operand F_label = OP_LABEL();
-  compileCondition(getChildByName(node, "Exp"), &T_label, &F_label);
-  addCode(sentinelChunk, CODE_UNARY(LABEL, T_label));
+  compileCondition(getChildByKind(node, S_Exp), &T_label, &F_label);
+  addCode(codeList, CODE_UNARY(LABEL, T_label));
   COMPILE(node, Stmt);
-  addCode(sentinelChunk, CODE_UNARY(GOTO, start));
-  addCode(sentinelChunk, CODE_UNARY(LABEL, F_label));
+  addCode(codeList, CODE_UNARY(GOTO, start));
+  addCode(codeList, CODE_UNARY(LABEL, F_label));
 }
 
 // helper function of `compileStmt`
@@ -521,7 +555,7 @@ static void compileCompSt(const ParseTNode *node);
 
 static void compileStmt(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Stmt") == 0);
+  assert(node->kind == S_Stmt);
   const char *expressions[] = {
     "CompSt",                      // 0
     "IF LP Exp RP Stmt",           // 1
@@ -536,17 +570,16 @@ static void compileStmt(const ParseTNode *node) {
   if (1 <= i && i <= 3)
     return compileBranches(node);
   if (i == 4) {
-    const Operand tmp = COMPILE(node, Exp);
-    cleanOp(&tmp); // may contain val_s and address in it
+    COMPILE(node, Exp);
     return;
   }
   const Operand tmp = COMPILE(node, Exp);
-  addCode(sentinelChunk, CODE_UNARY(RETURN, tmp));
+  addCode(codeList, CODE_UNARY(RETURN, tmp));
 }
 
 static void compileStmtList(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"StmtList") == 0);
+  assert(node->kind == S_StmtList);
   const char *expressions[] = {
     "",
     "Stmt StmtList"
@@ -558,7 +591,7 @@ static void compileStmtList(const ParseTNode *node) {
 
 static void compileCompSt(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"CompSt") == 0);
+  assert(node->kind == S_CompSt);
   const char *expressions[] = {
     "LC DefList StmtList RC"
   };
@@ -569,16 +602,16 @@ static void compileCompSt(const ParseTNode *node) {
 
 static Operand compileParamDec(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name, "ParamDec") == 0);
+  assert(node->kind == S_ParamDec);
   const char *expressions[] = {"Specifier VarDec"};
   assert(EXPRESSION_INDEX(node, expressions) == 0);
-  return compileVarDec(getChildByName(node, "VarDec"), true);
+  return compileVarDec(getChildByKind(node, S_VarDec), true);
 }
 
 // helper function of `compileFunDec`
 static void compileVarList(const ParseTNode *node, Operand *stack, int *top) {
   assert(node != NULL);
-  assert(strcmp(node->name,"VarList") == 0);
+  assert(node->kind == S_VarList);
   const char *expressions[] = {
     "ParamDec",
     "ParamDec COMMA VarList"
@@ -590,12 +623,12 @@ static void compileVarList(const ParseTNode *node, Operand *stack, int *top) {
   }
   stack[(*top)++] = COMPILE(node, ParamDec);
   if (i == 1)
-    compileVarList(getChildByName(node, "VarList"), stack, top);
+    compileVarList(getChildByKind(node, S_VarList), stack, top);
 }
 
 static void compileFunDec(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"FunDec") == 0);
+  assert(node->kind == S_FunDec);
   const char *expressions[] = {
     "ID LP VarList RP",
     "ID LP RP"
@@ -603,14 +636,14 @@ static void compileFunDec(const ParseTNode *node) {
   const int i = EXPRESSION_INDEX(node, expressions);
   const char *name = getStrFrom(node, ID);
   const Operand func_op = {
-    .kind = O_VARIABLE, .value_s = my_strdup(name)
+    .kind = O_VARIABLE, .name = getIdFrom(node, ID)
   };
-  addCode(sentinelChunk, CODE_UNARY(FUNCTION, func_op));
+  addCode(codeList, CODE_UNARY(FUNCTION, func_op));
   if (i == 1) return;
 
   Operand stack[STACK_MAX_NUM];
   int top = 0;
-  compileVarList(getChildByName(node, "VarList"), stack, &top);
+  compileVarList(getChildByKind(node, S_VarList), stack, &top);
   assert(top != 0);
   // update funcParamInfo
   const Data *data = searchWithName(symbolTable->funcs, name);
@@ -618,14 +651,14 @@ static void compileFunDec(const ParseTNode *node) {
   funcParamInfo.argv = data->function.argvTypes;
   for (int j = 0; j < top; ++j) {
     const Operand var_op = stack[j];
-    addCode(sentinelChunk, CODE_UNARY(PARAM, var_op));
-    funcParamInfo.param_s[j] = my_strdup(var_op.value_s);
+    addCode(codeList, CODE_UNARY(PARAM, var_op));
+    funcParamInfo.param_s[j] = var_op.name;
   }
 }
 
 static void compileExtDef(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"ExtDef") == 0);
+  assert(node->kind == S_ExtDef);
   const char *expressions[] = {
     "Specifier SEMI",
     "Specifier ExtDecList SEMI",
@@ -635,14 +668,12 @@ static void compileExtDef(const ParseTNode *node) {
   COMPILE(node, FunDec);
   COMPILE(node, CompSt);
   // clear funcParamInfo
-  for (int i = 0; i < funcParamInfo.argc; ++i)
-    free(funcParamInfo.param_s[i]);
   memset(&funcParamInfo, 0, sizeof(funcParamInfo));
 }
 
 static void compileExtDefList(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"ExtDefList") == 0);
+  assert(node->kind == S_ExtDefList);
   const char *expressions[] = {
     "",
     "ExtDef ExtDefList"
@@ -653,17 +684,22 @@ static void compileExtDefList(const ParseTNode *node) {
   COMPILE(node, ExtDefList);
 }
 
-const Chunk* compile(const ParseTNode *root, const SymbolTable *table) {
+CodeList* compile(CompilerContext *ctx, const ParseTNode *root, const SymbolTable *table) {
   assert(root != NULL);
-  assert(strcmp(root->name, "Program") == 0);
-  char *expressions[] = {
+  bindContext(ctx);
+  assert(root->kind == S_Program);
+  const char *expressions[] = {
     "ExtDefList"
   };
   assert(EXPRESSION_INDEX(root, expressions) == 0);
   symbolTable = table;
-  initChunk(&sentinelChunk);
+  label_cnt = tmp_cnt = 0;
+  codeList = createCodeList();
   COMPILE(root, ExtDefList);
-  return sentinelChunk;
+  CodeList *list = codeList;
+  codeList = NULL;
+  symbolTable = NULL;
+  return list;
 }
 
 #undef STACK_MAX_NUM
@@ -674,35 +710,3 @@ const Chunk* compile(const ParseTNode *root, const SymbolTable *table) {
 #undef OP_TEMP
 #undef OP_LABEL
 #undef OP_CONSTANT
-
-/**
- *  helper function of `arrayTypeSize`
- *  @note no need to worry about alignment.
- */
-static unsigned typeSizeHelper(const Type *type) {
-  assert(type != NULL && type->kind != ERROR);
-  if (type->kind == INT || type->kind == FLOAT) {
-    return 4;
-  }
-  if (type->kind == ARRAY)
-    return type->array.size * typeSizeHelper(type->array.elemType);
-
-  // struct
-  const structFieldElement *f = type->structure.fields;
-  unsigned size = 0;
-  while (f != NULL) {
-    size += typeSizeHelper(f->elemType);
-    f = f->next;
-  }
-  return size;
-}
-
-// return the size to be allocated
-static unsigned arrayTypeSize(const char *name, const int depth) {
-  const Type *type = searchWithName(symbolTable->vars, name)->variable.type;
-  for (int i = 0; i < depth; ++i) {
-    assert(type->kind == ARRAY);
-    type = type->array.elemType;
-  }
-  return typeSizeHelper(type);
-}
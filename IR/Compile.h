@@ -9,6 +9,6 @@
 #include "IR.h"
 #endif
 
-const Chunk* compile(const ParseTNode *root, const SymbolTable *table);
+CodeList* compile(CompilerContext *ctx, const ParseTNode *root, const SymbolTable *table);
 
 #endif
@@ -4,6 +4,14 @@
 #include "IR.h"
 #endif
 
+#include <sys/mman.h>
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
 // a list contains the number of operands for each kind of code
 const uint8_t operand_count_per_code[] = {
   [C_READ] = 1, [C_WRITE] = 1, [C_FUNCTION] = 1, [C_PARAM] = 1,
@@ -13,68 +21,90 @@ const uint8_t operand_count_per_code[] = {
   [C_DEC] = 1,
 };
 
-// note: o1 and o2 both are double pointer to operand
-int cmp_operand(const void *o1, const void *o2) {
+/**
+ * @brief order operands by kind, then by the kind of base, then by id.
+ * the three are packed into one integer, so comparing is a single compare.
+ */
+static uint64_t operandKey(const Operand *op) {
 #define allowed_op 5, O_TEM_VAR, O_VARIABLE, O_CONSTANT, O_REFER, O_DEREF
   //the order of different operands
-  const uint8_t order[] = {
+  static const uint8_t order[] = {
     [O_TEM_VAR] = 0, [O_VARIABLE] = 1, [O_CONSTANT] = 2, [O_REFER] = 3, [O_DEREF] = 4
   };
-
-  const Operand *op1 = *(Operand **) o1, *op2 = *(Operand **) o2;
-  // no constant
-  assert(op1 != NULL && in(op1->kind, allowed_op));
-  assert(op2 != NULL && in(op2->kind, allowed_op));
-  const int kind1 = op1->kind, kind2 = op2->kind;
-
-  if (kind1 != kind2) return order[kind1] - order[kind2];
-  if (kind1 == O_TEM_VAR) return op1->var_no - op2->var_no;
-  if (kind1 == O_VARIABLE) return strcmp(op1->value_s, op2->value_s);
-  if (kind1 == O_CONSTANT) return op1->value - op2->value;
-  if (either(kind1, O_REFER, O_DEREF)) return cmp_operand(&op1->address, &op2->address);
-  assert(false);
+  assert(op != NULL && in(op->kind, allowed_op));
+  // flip the sign bit, so that negative constants still come first
+  const uint32_t id = (uint32_t) op->value ^ 0x80000000u;
+  return (uint64_t) order[op->kind] << 36 | (uint64_t) order[op->base] << 32 | id;
 #undef allowed_op
 }
 
-void initChunk(Chunk **sentinel) {
-  assert(*sentinel == NULL); // sentinel should be NULL at first
-  *sentinel = malloc(sizeof(Chunk));
-  (*sentinel)->next = (*sentinel)->prev = *sentinel;
+// note: o1 and o2 both are pointers to operand
+int cmp_operand(const void *o1, const void *o2) {
+  const uint64_t key1 = operandKey(o1), key2 = operandKey(o2);
+  return (key1 > key2) - (key1 < key2);
 }
 
-void addCode(Chunk *sentinel, const Code code) {
-  Chunk *chunk = malloc(sizeof(Chunk));
-  chunk->code = code;
-  chunk->next = sentinel;
-  chunk->prev = sentinel->prev;
-  sentinel->prev->next = chunk;
-  sentinel->prev = chunk;
+#define CODE_INIT_CAPACITY 256
+
+CodeList* createCodeList() {
+  CodeList *list = malloc(sizeof(CodeList));
+  list->mapping = NULL;
+  list->capacity = CODE_INIT_CAPACITY;
+  list->nodes = malloc(sizeof(Chunk) * list->capacity);
+  assert(list->nodes != NULL);
+  // the sentinel holds no code, peeking at it matches no kind
+  memset(&list->nodes[CODE_SENTINEL], 0, sizeof(Chunk));
+  list->nodes[CODE_SENTINEL].code.kind = -1;
+  list->cnt = 1;
+  return list;
+}
+
+#undef CODE_INIT_CAPACITY
+
+// nodes mapped from an IR file can't be resized, move them to the heap first
+static void unmapCodeList(CodeList *list) {
+  Chunk *nodes = malloc(sizeof(Chunk) * list->capacity);
+  assert(nodes != NULL);
+  memcpy(nodes, list->nodes, sizeof(Chunk) * list->cnt);
+  munmap(list->mapping, list->mapping_len);
+  list->mapping = NULL;
+  list->nodes = nodes;
 }
 
-// todo add comment and check every return and value
-// deep copy an operand, especially those pointer value.
-Operand copyOperand(const Operand *src) {
-  Operand tmp = *src;
-  if (either(src->kind, O_VARIABLE, O_INVOKE)) {
-    tmp.value_s = my_strdup(src->value_s);
-  } else if (either(src->kind, O_REFER, O_DEREF)) {
-    Operand *addr_op = malloc(sizeof(Operand));
-    *addr_op = copyOperand(src->address);
-    tmp.address = addr_op;
+// @return the index of the new code, which is linked before the code at `before`
+CodeIndex insertCode(CodeList *list, const CodeIndex before, const Code code) {
+  assert(before < list->cnt);
+  if (list->cnt >= list->capacity) {
+    assert(list->capacity <= UINT32_MAX / 2);
+    list->capacity *= 2;
+    if (list->mapping != NULL) unmapCodeList(list);
+    else list->nodes = realloc(list->nodes, sizeof(Chunk) * list->capacity);
+    assert(list->nodes != NULL);
   }
-  return tmp;
+  const CodeIndex i = list->cnt++;
+  Chunk *chunk = &list->nodes[i];
+  chunk->code = code;
+  chunk->next = before;
+  chunk->prev = list->nodes[before].prev;
+  list->nodes[chunk->prev].next = i;
+  list->nodes[before].prev = i;
+  return i;
+}
+
+CodeIndex addCode(CodeList *list, const Code code) {
+  return insertCode(list, CODE_SENTINEL, code);
 }
 
 void printOp(FILE *f, const Operand *op) {
   switch (op->kind) {
     case O_VARIABLE:
-      fprintf(f, "%s ", op->value_s);
+      fprintf(f, "%s ", internedStr(op->name));
       break;
     case O_CONSTANT:
       fprintf(f, "#%d ", op->value);
       break;
     case O_INVOKE:
-      fprintf(f, "CALL %s ", op->value_s);
+      fprintf(f, "CALL %s ", internedStr(op->name));
       break;
     case O_TEM_VAR:
       fprintf(f, "t%d ", op->var_no);
@@ -83,13 +113,12 @@ void printOp(FILE *f, const Operand *op) {
       fprintf(f, "label%d ", op->var_no);
       break;
     case O_REFER:
-      fprintf(f, "&");
-      printOp(f, op->address);
-      break;
-    case O_DEREF:
-      fprintf(f, "*");
-      printOp(f, op->address);
+    case O_DEREF: {
+      const Operand base = base_op(op);
+      fprintf(f, op->kind == O_REFER ? "&" : "*");
+      printOp(f, &base);
       break;
+    }
     default:
       break;
   }
@@ -151,7 +180,7 @@ void printCode(FILE *f, const Code *c) {
     case C_IFGOTO:
       fprintf(f, "IF ");
       printOp(f, &c->as.ternary.x);
-      fprintf(f, "%s ", c->as.ternary.relation);
+      fprintf(f, "%s ", relopNames[c->as.ternary.relation]);
       printOp(f, &c->as.ternary.y);
       fprintf(f, "GOTO ");
       printOp(f, &c->as.ternary.label);
@@ -172,55 +201,23 @@ void printCode(FILE *f, const Code *c) {
 #undef CASES
 }
 
-void printChunk(const char *file_name, const Chunk *sentinel) {
-  FILE *f = fopen(file_name, "w");
-  if (f == NULL) {
-    DEBUG_INFO("Can't open file.\n");
-    exit(EXIT_FAILURE);
-  }
-  const Chunk *c = sentinel->next;
-  while (c != sentinel) {
-    printCode(f, &c->code);
-    c = c->next;
-  }
-  fclose(f);
+void printCodeList(FILE *f, const CodeList *list) {
+  for (CodeIndex i = firstCode(list); i != CODE_SENTINEL; i = nextCode(list, i))
+    printCode(f, codeAt(list, i));
 }
 
-void cleanOp(const Operand *op) {
-  if (either(op->kind, O_VARIABLE, O_INVOKE))
-    return free((char *) op->value_s);
-
-  if (either(op->kind, O_REFER, O_DEREF)) {
-    cleanOp(op->address);
-    free(op->address);
-  }
+// the slot of code is left unused until the list is released
+void removeCode(CodeList *list, const CodeIndex index) {
+  assert(index != CODE_SENTINEL && index < list->cnt);
+  Chunk *chunk = &list->nodes[index];
+  list->nodes[chunk->prev].next = chunk->next;
+  list->nodes[chunk->next].prev = chunk->prev;
+  chunk->prev = chunk->next = index;
 }
 
-static void cleanCode(const Code *code) {
-  for (int i = 0; i < operand_count_per_code[code->kind]; ++i)
-    cleanOp((Operand *) &code->as + i);
-
-  if (code->kind == C_IFGOTO)
-    free(code->as.ternary.relation);
-}
-
-void removeCode(Chunk *chunk) {
-  // can't be the sentinel node
-  assert(chunk->prev != chunk && chunk != chunk->next);
-  Chunk *prev = chunk->prev;
-  Chunk *next = chunk->next;
-  prev->next = next;
-  next->prev = prev;
-  cleanCode(&chunk->code);
-  free(chunk);
-}
-
-void freeChunk(const Chunk *sentinel) {
-  assert(sentinel != NULL);
-  Chunk *c = sentinel->next;
-  while (c != sentinel) {
-    c = c->next;
-    removeCode(c->prev);
-  }
-  free(c);
+void freeCodeList(CodeList *list) {
+  assert(list != NULL);
+  if (list->mapping != NULL) munmap(list->mapping, list->mapping_len);
+  else free(list->nodes);
+  free(list);
 }
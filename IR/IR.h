@@ -7,24 +7,32 @@
 #include "utils.h"
 #endif
 
-#define distill_op(op) (op) = (op)->address
+enum { // total 7
+  O_TEM_VAR, O_LABEL,
+  O_CONSTANT,
+  O_VARIABLE, O_INVOKE,
+  O_DEREF, O_REFER,
+};
 
+/* an operand is a plain value of 8 bytes, copied and compared as is.
+ * DEREF(dereference) and REFER(reference) are address modes over a base operand,
+ * whose kind is kept in `base` and whose id shares the union. */
 typedef struct Operand {
-  enum { // total 7
-    O_TEM_VAR, O_LABEL,
-    O_CONSTANT,
-    O_VARIABLE, O_INVOKE,
-    O_DEREF, O_REFER,
-  } kind;
-
+  uint16_t kind;
+  uint16_t base; // O_TEM_VAR(0) unless kind is O_DEREF or O_REFER
   union {
-    int var_no;              // TMP_VAR, LABEL
-    int value;               // CONSTANT
-    const char *value_s;     // VARIABLE, INVOKE
-    struct Operand *address; // DEREF(dereference), REFER(reference)
+    int var_no;    // TMP_VAR, LABEL
+    int value;     // CONSTANT
+    InternId name; // VARIABLE, INVOKE
   };
 } Operand;
 
+// apply an address mode to a temporary or variable
+#define address_op(mode, op) \
+  ((Operand){.kind = (mode), .base = (op).kind, .var_no = (op).var_no})
+// the operand that O_DEREF and O_REFER address
+#define base_op(op) ((Operand){.kind = (op)->base, .var_no = (op)->var_no})
+
 // a single line of code
 typedef struct {
   enum { // total 15
@@ -50,7 +58,7 @@ typedef struct {
       Operand x;
       Operand y;
       Operand label;
-      char *relation;
+      Relop relation;
     } ternary;
 
     struct {
@@ -60,20 +68,41 @@ typedef struct {
   } as;
 } Code;
 
-// a doubly linked list of codes
+typedef uint32_t CodeIndex;
+
+// a node of the code list
 typedef struct Chunk {
   Code code;
-  struct Chunk *prev, *next;
+  CodeIndex prev, next;
 } Chunk;
 
+#define CODE_SENTINEL 0 // both the head and the end of the circular list
+
+/* the codes of a program live in one array, linked by indices. codes are appended
+ * in order, so walking the list mostly runs through memory in order; inserting and
+ * removing a code stay O(1), a removed code only leaves its slot unused.
+ * @note an insertion may move the array, only indices stay valid across it. */
+typedef struct {
+  Chunk *nodes; // nodes[CODE_SENTINEL] holds no code
+  CodeIndex cnt, capacity;
+  void *mapping; // the IR file that nodes point into, NULL if nodes are on the heap
+  size_t mapping_len;
+} CodeList;
+
+#define codeAt(list, i) (&(list)->nodes[i].code)
+#define nextCode(list, i) ((list)->nodes[i].next)
+#define prevCode(list, i) ((list)->nodes[i].prev)
+#define firstCode(list) nextCode(list, CODE_SENTINEL)
+#define lastCode(list) prevCode(list, CODE_SENTINEL)
+
 int cmp_operand(const void *o1, const void *o2);
 
-void initChunk(Chunk **sentinel);
-Operand copyOperand(const Operand *src);
-void addCode(Chunk *sentinel, Code code);
-void cleanOp(const Operand *op);
-void removeCode(Chunk *chunk);
-void freeChunk(const Chunk *sentinel);
+CodeList* createCodeList();
+CodeIndex addCode(CodeList *list, Code code);
+CodeIndex insertCode(CodeList *list, CodeIndex before, Code code);
+void removeCode(CodeList *list, CodeIndex index);
+void freeCodeList(CodeList *list);
+void printCodeList(FILE *f, const CodeList *list);
 
 #ifdef LOCAL
 void printOp(FILE *f, const Operand *op);
@@ -0,0 +1,603 @@
+#ifdef LOCAL
+#include <IRFile.h>
+#else
+#include "IRFile.h"
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+extern const uint8_t operand_count_per_code[];
+
+// the bytes of `as` used by the kind of code, the others are written as zeros
+static size_t usedBytes(const Code *code) {
+  if (code->kind == C_IFGOTO) return sizeof(code->as.ternary);
+  if (code->kind == C_DEC) return sizeof(code->as.dec);
+  return operand_count_per_code[code->kind] * sizeof(Operand);
+}
+
+/**
+ * @brief write list with the strings of ctx, removed codes are left out and the others
+ * are renumbered in order, so that the same program always gives the same file.
+ * @return 0 if succeeded
+ */
+int writeCodeList(CompilerContext *ctx, FILE *file, const CodeList *list) {
+  bindContext(ctx);
+  CodeIndex cnt = 0;
+  for (CodeIndex i = firstCode(list); i != CODE_SENTINEL; i = nextCode(list, i)) cnt++;
+  const int str_cnt = internedCount();
+  uint32_t str_bytes = 0;
+  for (InternId id = 0; id < str_cnt; ++id) str_bytes += strlen(internedStr(id)) + 1;
+
+  IRFileHeader header = {
+    .version = IR_FILE_VERSION,
+    .chunk_size = sizeof(Chunk),
+    .node_cnt = cnt + 1,
+    .str_cnt = str_cnt,
+    .str_bytes = str_bytes,
+  };
+  memcpy(header.magic, IR_FILE_MAGIC, sizeof(header.magic));
+  size_t written = fwrite(&header, sizeof(header), 1, file);
+
+  Chunk node;
+  memset(&node, 0, sizeof(Chunk));
+  node.code.kind = -1;
+  node.prev = cnt;
+  node.next = cnt == 0 ? CODE_SENTINEL : 1;
+  written += fwrite(&node, sizeof(Chunk), 1, file);
+  CodeIndex n = 0;
+  for (CodeIndex i = firstCode(list); i != CODE_SENTINEL; i = nextCode(list, i)) {
+    const Code *code = codeAt(list, i);
+    memset(&node, 0, sizeof(Chunk));
+    node.code.kind = code->kind;
+    memcpy(&node.code.as, &code->as, usedBytes(code));
+    node.prev = n++;
+    node.next = n == cnt ? CODE_SENTINEL : n + 1;
+    written += fwrite(&node, sizeof(Chunk), 1, file);
+  }
+
+  for (InternId id = 0; id < str_cnt; ++id) {
+    const char *str = internedStr(id);
+    written += fwrite(str, strlen(str) + 1, 1, file);
+  }
+  return written != 2 + cnt + (size_t) str_cnt;
+}
+
+/* a label only where a code jumps to or marks one, an address mode only over a temporary
+ * or a variable, no negative number of a temporary or label, and the names of variables
+ * and functions in the string table */
+static bool isValidOperand(const Operand *op, const bool is_label, const uint32_t str_cnt) {
+  if (op->kind > O_REFER || (op->kind == O_LABEL) != is_label) return false;
+  const bool address = either(op->kind, O_REFER, O_DEREF);
+  if (address && !either(op->base, O_TEM_VAR, O_VARIABLE)) return false;
+  if (!address && op->base != O_TEM_VAR) return false;
+  const int kind = address ? op->base : op->kind;
+  if (either(kind, O_TEM_VAR, O_LABEL)) return op->var_no >= 0;
+  return !either(kind, O_VARIABLE, O_INVOKE) || (uint32_t) op->name < str_cnt;
+}
+
+// whether the slot of code holds a label
+static bool isLabelSlot(const Code *code, const int slot) {
+  if (either(code->kind, C_LABEL, C_GOTO)) return true;
+  return code->kind == C_IFGOTO && slot == 2;
+}
+
+/**
+ * @brief check the file without copying anything, so that reading and walking it stays
+ * within the file: the header, the string table, a single list through the nodes from the
+ * sentinel back to it, starting with a function, and the kind and operands of every code.
+ * the codes must still make up a valid program, as those of the front end do.
+ * @return the reason why file isn't a valid IR file, NULL if it is
+ */
+static const char* checkFile(const void *file, const size_t len) {
+  const IRFileHeader *header = file;
+  if (len < sizeof(IRFileHeader) || memcmp(header->magic, IR_FILE_MAGIC, sizeof(header->magic)) != 0)
+    return "not an IR file";
+  if (header->version != IR_FILE_VERSION || header->chunk_size != sizeof(Chunk))
+    return "IR file of another version";
+  const size_t nodes_len = (size_t) header->node_cnt * sizeof(Chunk);
+  if (header->node_cnt == 0 || len != sizeof(IRFileHeader) + nodes_len + header->str_bytes)
+    return "truncated IR file";
+
+  const char *str = (const char *) file + sizeof(IRFileHeader) + nodes_len;
+  const char *end = str + header->str_bytes;
+  for (uint32_t i = 0; i < header->str_cnt; ++i) {
+    const char *zero = memchr(str, '\0', end - str);
+    if (zero == NULL) return "corrupted string table";
+    str = zero + 1;
+  }
+  if (str != end) return "corrupted string table";
+
+  const Chunk *nodes = (const Chunk *) ((const char *) file + sizeof(IRFileHeader));
+  for (CodeIndex i = 0; i < header->node_cnt; ++i) {
+    const Chunk *node = &nodes[i];
+    if (node->prev >= header->node_cnt || node->next >= header->node_cnt)
+      return "corrupted code list";
+    if (i == CODE_SENTINEL) continue;
+    const Code *code = &node->code;
+    if ((unsigned) code->kind > C_DEC) return "corrupted code";
+    if (code->kind == C_IFGOTO && (unsigned) code->as.ternary.relation > REL_GE)
+      return "corrupted code";
+    for (int j = 0; j < operand_count_per_code[code->kind]; ++j) {
+      if (!isValidOperand((const Operand *) &code->as + j, isLabelSlot(code, j), header->str_cnt))
+        return "corrupted code";
+    }
+  }
+  // each step goes to a node whose prev leads back, and the sentinel comes back in time
+  CodeIndex i = CODE_SENTINEL;
+  for (CodeIndex steps = 0; steps < header->node_cnt; ++steps) {
+    const CodeIndex next = nodes[i].next;
+    if (nodes[next].prev != i) return "corrupted code list";
+    if (next == CODE_SENTINEL) break;
+    i = next;
+  }
+  if (nodes[i].next != CODE_SENTINEL) return "corrupted code list";
+  const CodeIndex first = nodes[CODE_SENTINEL].next;
+  if (first != CODE_SENTINEL && nodes[first].code.kind != C_FUNCTION)
+    return "code outside of any function";
+  return NULL;
+}
+
+// the label a code jumps to, -1 if it doesn't jump
+static int jumpTarget(const Code *code) {
+  if (code->kind == C_GOTO) return code->as.unary.var_no;
+  if (code->kind == C_IFGOTO) return code->as.ternary.label.var_no;
+  return -1;
+}
+
+/**
+ * @brief whether each label is defined once, and each jump goes to a label of its own function.
+ * the optimizer and the control flow graph take both for granted.
+ * @param label the label at fault, if any
+ * @return the reason why the labels aren't valid, NULL if they are
+ */
+static const char* checkLabels(const CodeList *list, int *label) {
+  int *labels = malloc(sizeof(int) * list->cnt);
+  const char *reason = NULL;
+  CodeIndex i = firstCode(list);
+  while (reason == NULL && i != CODE_SENTINEL) {
+    // the labels of the function starting at i, sorted
+    int cnt = 0;
+    CodeIndex end = i;
+    do {
+      const Code *code = codeAt(list, end);
+      if (code->kind == C_LABEL) labels[cnt++] = code->as.unary.var_no;
+      end = nextCode(list, end);
+    } while (end != CODE_SENTINEL && codeAt(list, end)->kind != C_FUNCTION);
+    qsort(labels, cnt, sizeof(int), cmp_int);
+    for (int j = 1; reason == NULL && j < cnt; ++j) {
+      if (labels[j] == labels[j - 1]) {
+        reason = "label defined twice:";
+        *label = labels[j];
+      }
+    }
+    for (; reason == NULL && i != end; i = nextCode(list, i)) {
+      const int target = jumpTarget(codeAt(list, i));
+      if (target != -1 && bsearch(&target, labels, cnt, sizeof(int), cmp_int) == NULL) {
+        reason = "jump to a label not in its function:";
+        *label = target;
+      }
+    }
+    i = end;
+  }
+  free(labels);
+  return reason;
+}
+
+static bool isCall(const Code *code) {
+  return code->kind == C_ASSIGN && code->as.assign.right.kind == O_INVOKE;
+}
+
+/**
+ * @brief whether the arguments of each call come right before it, and each call goes to a
+ * function of the list. the backend pushes the arguments until the call takes them.
+ * @param at the code at fault, if any
+ * @param callee the function called by it, -1 if it is an argument
+ * @return the reason why the calls aren't valid, NULL if they are
+ */
+static const char* checkCalls(const CodeList *list, CodeIndex *at, InternId *callee) {
+  InternId *functions = malloc(sizeof(InternId) * list->cnt);
+  int cnt = 0;
+  for (CodeIndex i = firstCode(list); i != CODE_SENTINEL; i = nextCode(list, i)) {
+    const Code *code = codeAt(list, i);
+    if (code->kind == C_FUNCTION) functions[cnt++] = code->as.unary.name;
+  }
+  qsort(functions, cnt, sizeof(InternId), cmp_int);
+  const char *reason = NULL;
+  for (CodeIndex i = firstCode(list); reason == NULL && i != CODE_SENTINEL; i = nextCode(list, i)) {
+    const Code *code = codeAt(list, i);
+    // the sentinel after the last code is of no kind
+    const Code *next = codeAt(list, nextCode(list, i));
+    if (code->kind == C_ARG && next->kind != C_ARG && !isCall(next)) {
+      reason = "ARG not followed by a CALL";
+      *callee = -1;
+    } else if (isCall(code)
+               && bsearch(&code->as.assign.right.name, functions, cnt, sizeof(InternId), cmp_int) == NULL) {
+      reason = "call to a function not in the list:";
+      *callee = code->as.assign.right.name;
+    }
+    *at = i;
+  }
+  free(functions);
+  return reason;
+}
+
+/**
+ * @brief map the IR file at path, the list points into the file rather than a copy of it.
+ * the file is mapped privately, so the optimizer may rewrite codes in place.
+ * a file without the magic is read as text IR by `parseCodeList`.
+ * @param ctx a new context, whose interner gives every string the id it was written with
+ * @return NULL if the file can't be read, the reason goes to the diagnostics of ctx
+ */
+CodeList* loadCodeList(CompilerContext *ctx, const char *path) {
+  bindContext(ctx);
+  const int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    fprintf(ctx->diagnostics, "%s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  struct stat st = {.st_size = 0};
+  void *mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  const int mmap_errno = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    fprintf(ctx->diagnostics, "%s: %s\n", path, st.st_size == 0 ? "not an IR file" : strerror(mmap_errno));
+    return NULL;
+  }
+
+  const IRFileHeader *header = mapping;
+  if ((size_t) st.st_size < sizeof(header->magic)
+      || memcmp(header->magic, IR_FILE_MAGIC, sizeof(header->magic)) != 0) {
+    CodeList *list = parseCodeList(ctx, mapping, st.st_size, path);
+    munmap(mapping, st.st_size);
+    return list;
+  }
+  const char *reason = checkFile(mapping, st.st_size);
+  if (reason == NULL) {
+    const char *str = (const char *) mapping + sizeof(IRFileHeader) + sizeof(Chunk) * header->node_cnt;
+    for (uint32_t i = 0; reason == NULL && i < header->str_cnt; ++i) {
+      if (intern(str) != (InternId) i) reason = "duplicated strings";
+      str += strlen(str) + 1;
+    }
+  }
+  if (reason != NULL) {
+    fprintf(ctx->diagnostics, "%s: %s\n", path, reason);
+    munmap(mapping, st.st_size);
+    return NULL;
+  }
+
+  CodeList *list = malloc(sizeof(CodeList));
+  list->nodes = (Chunk *) ((char *) mapping + sizeof(IRFileHeader));
+  list->cnt = list->capacity = header->node_cnt;
+  list->mapping = mapping;
+  list->mapping_len = st.st_size;
+  int label;
+  reason = checkLabels(list, &label);
+  if (reason != NULL) {
+    fprintf(ctx->diagnostics, "%s: %s label%d\n", path, reason, label);
+    freeCodeList(list);
+    return NULL;
+  }
+  CodeIndex at;
+  InternId callee;
+  reason = checkCalls(list, &at, &callee);
+  if (reason != NULL) {
+    if (callee == -1) fprintf(ctx->diagnostics, "%s: %s\n", path, reason);
+    else fprintf(ctx->diagnostics, "%s: %s %s\n", path, reason, internedStr(callee));
+    freeCodeList(list);
+    return NULL;
+  }
+  return list;
+}
+
+///// Text IR ////////////////////////////////////////////////
+
+#define MAX_WORD_NUM 6 // IF x < y GOTO label
+
+typedef struct {
+  const char *s;
+  int len;
+} Word;
+
+static bool isWord(const Word w, const char *str) {
+  return (size_t) w.len == strlen(str) && memcmp(w.s, str, w.len) == 0;
+}
+
+// @return false if w isn't a number that fits in int, a sign is only allowed if is_signed
+static bool parseNumber(const Word w, const bool is_signed, int *value) {
+  int i = is_signed && w.len > 0 && w.s[0] == '-';
+  if (i == w.len) return false;
+  long long n = 0;
+  for (; i < w.len; ++i) {
+    if (!isdigit((unsigned char) w.s[i])) return false;
+    n = n * 10 + (w.s[i] - '0');
+    if (n > (long long) INT_MAX + 1) return false;
+  }
+  if (w.s[0] == '-') n = -n;
+  if (n > INT_MAX) return false;
+  *value = (int) n;
+  return true;
+}
+
+static InternId internWord(const Word w) {
+  char buf[64];
+  char *str = (size_t) w.len < sizeof(buf) ? buf : malloc(w.len + 1);
+  memcpy(str, w.s, w.len);
+  str[w.len] = '\0';
+  const InternId id = intern(str);
+  if (str != buf) free(str);
+  return id;
+}
+
+static bool isIdentifier(const Word w) {
+  if (w.len == 0 || (!isalpha((unsigned char) w.s[0]) && w.s[0] != '_')) return false;
+  for (int i = 1; i < w.len; ++i)
+    if (!isalnum((unsigned char) w.s[i]) && w.s[i] != '_') return false;
+  return true;
+}
+
+/* the labels of the function being parsed, known by the ids of their names. a name only
+ * stands for a label within its function, and gets a number unique in the whole list. */
+typedef struct {
+  int *number;    // of each name, -1 if the function hasn't used it
+  int *line;      // where each name is first used
+  bool *defined;
+  int capacity;
+  InternId *used; // the names the function has used, in order
+  int used_cnt, used_capacity;
+  int next;       // the number of the next name
+} Labels;
+
+static void initLabels(Labels *labels) {
+  *labels = (Labels){.capacity = 16, .used_capacity = 16};
+  labels->number = malloc(sizeof(int) * labels->capacity);
+  labels->line = malloc(sizeof(int) * labels->capacity);
+  labels->defined = malloc(sizeof(bool) * labels->capacity);
+  labels->used = malloc(sizeof(InternId) * labels->used_capacity);
+  for (int i = 0; i < labels->capacity; ++i) labels->number[i] = -1;
+}
+
+static void freeLabels(Labels *labels) {
+  free(labels->number);
+  free(labels->line);
+  free(labels->defined);
+  free(labels->used);
+}
+
+// any identifier names a label, @return the reason why w can't be used here, NULL if it can
+static const char* parseLabel(Labels *labels, const Word w, const bool defines,
+                              const int line, Operand *op) {
+  if (!isIdentifier(w)) return "bad label";
+  const InternId id = internWord(w);
+  if (id >= labels->capacity) {
+    const int old = labels->capacity;
+    while (labels->capacity <= id) RESIZE(labels->capacity);
+    labels->number = realloc(labels->number, sizeof(int) * labels->capacity);
+    labels->line = realloc(labels->line, sizeof(int) * labels->capacity);
+    labels->defined = realloc(labels->defined, sizeof(bool) * labels->capacity);
+    for (int i = old; i < labels->capacity; ++i) labels->number[i] = -1;
+  }
+  if (labels->number[id] == -1) {
+    if (labels->used_cnt >= labels->used_capacity) {
+      RESIZE(labels->used_capacity);
+      labels->used = realloc(labels->used, sizeof(InternId) * labels->used_capacity);
+    }
+    labels->used[labels->used_cnt++] = id;
+    labels->number[id] = labels->next++;
+    labels->line[id] = line;
+    labels->defined[id] = false;
+  }
+  if (defines && labels->defined[id]) return "label defined twice";
+  labels->defined[id] |= defines;
+  *op = (Operand){.kind = O_LABEL, .var_no = labels->number[id]};
+  return NULL;
+}
+
+/**
+ * @brief forget the labels of the function parsed so far.
+ * @return a label it jumps to but doesn't define, -1 if none
+ */
+static InternId endFunction(Labels *labels) {
+  InternId undefined = -1;
+  for (int i = 0; i < labels->used_cnt; ++i) {
+    const InternId id = labels->used[i];
+    // the names are in the order of the lines first using them
+    if (!labels->defined[id] && undefined == -1) undefined = id;
+    labels->number[id] = -1;
+  }
+  labels->used_cnt = 0;
+  return undefined;
+}
+
+/**
+ * @brief `#N`, `tN`, a name, or `&` and `*` before one of the last two.
+ * as in the output of `printOp`, a variable named like `t1` is taken as a temporary,
+ * so a generator must give its variables other names.
+ */
+static bool parseOperand(const Word w, Operand *op) {
+  if (w.len < 2 && !isIdentifier(w)) return false;
+  if (w.s[0] == '#') {
+    *op = (Operand){.kind = O_CONSTANT};
+    return parseNumber((Word){w.s + 1, w.len - 1}, true, &op->value);
+  }
+  if (w.s[0] == '&' || w.s[0] == '*') {
+    Operand base;
+    if (!parseOperand((Word){w.s + 1, w.len - 1}, &base) || !either(base.kind, O_TEM_VAR, O_VARIABLE))
+      return false;
+    *op = address_op(w.s[0] == '&' ? O_REFER : O_DEREF, base);
+    return true;
+  }
+  *op = (Operand){.kind = O_TEM_VAR};
+  if (w.s[0] == 't' && parseNumber((Word){w.s + 1, w.len - 1}, false, &op->var_no)) return true;
+  if (!isIdentifier(w)) return false;
+  *op = (Operand){.kind = O_VARIABLE, .name = internWord(w)};
+  return true;
+}
+
+// the operands that a code may assign to
+static bool isDestination(const Operand *op) {
+  return op->kind == O_TEM_VAR || op->kind == O_VARIABLE || op->kind == O_DEREF;
+}
+
+/**
+ * @brief turn the words of a line into a code, the reverse of `printCode`.
+ * @return the reason why the words aren't a code, NULL if they are
+ */
+static const char* parseCode(const Word *w, const int n, Labels *labels, const int line, Code *code) {
+  static const char *const unary_names[] = {
+    [C_READ] = "READ", [C_WRITE] = "WRITE", [C_PARAM] = "PARAM",
+    [C_ARG] = "ARG", [C_RETURN] = "RETURN",
+  };
+  static const char binary_ops[] = {[C_ADD] = '+', [C_SUB] = '-', [C_MUL] = '*', [C_DIV] = '/'};
+
+  if (isWord(w[0], "FUNCTION") || isWord(w[0], "LABEL")) {
+    const bool is_func = w[0].s[0] == 'F';
+    code->kind = is_func ? C_FUNCTION : C_LABEL;
+    if (n != 3 || !isWord(w[2], ":")) return "expect `:` at the end";
+    if (!is_func) return parseLabel(labels, w[1], true, line, &code->as.unary);
+    if (!isIdentifier(w[1])) return "bad function name";
+    code->as.unary = (Operand){.kind = O_VARIABLE, .name = internWord(w[1])};
+    return NULL;
+  }
+  if (isWord(w[0], "GOTO")) {
+    code->kind = C_GOTO;
+    if (n != 2) return "bad label";
+    return parseLabel(labels, w[1], false, line, &code->as.unary);
+  }
+  if (isWord(w[0], "IF")) {
+    code->kind = C_IFGOTO;
+    if (n != 6 || !isWord(w[4], "GOTO")) return "expect `IF x relop y GOTO label`";
+    if (!parseOperand(w[1], &code->as.ternary.x) || !parseOperand(w[3], &code->as.ternary.y))
+      return "bad operand";
+    int r = REL_EQ;
+    while (r <= REL_GE && !isWord(w[2], relopNames[r])) r++;
+    if (r > REL_GE) return "bad relational operator";
+    code->as.ternary.relation = r;
+    return parseLabel(labels, w[5], false, line, &code->as.ternary.label);
+  }
+  if (isWord(w[0], "DEC")) {
+    code->kind = C_DEC;
+    int size;
+    if (n != 3 || !isIdentifier(w[1]) || !parseNumber(w[2], false, &size) || size == 0)
+      return "expect `DEC name size`";
+    code->as.dec.target = (Operand){.kind = O_VARIABLE, .name = internWord(w[1])};
+    code->as.dec.size = size;
+    return NULL;
+  }
+  for (int kind = C_READ; kind <= C_RETURN; ++kind) {
+    if (unary_names[kind] == NULL || !isWord(w[0], unary_names[kind])) continue;
+    code->kind = kind;
+    if (n != 2 || !parseOperand(w[1], &code->as.unary)) return "bad operand";
+    if (kind == C_READ && !isDestination(&code->as.unary)) return "can't read into an operand like this";
+    if (kind == C_PARAM && code->as.unary.kind != O_VARIABLE) return "a parameter must be a variable";
+    return NULL;
+  }
+
+  if (n < 3 || !isWord(w[1], ":=")) return "unknown code";
+  Operand left;
+  if (!parseOperand(w[0], &left) || !isDestination(&left)) return "can't assign to an operand like this";
+  if (n == 3 || (n == 4 && isWord(w[2], "CALL"))) {
+    code->kind = C_ASSIGN;
+    code->as.assign.left = left;
+    if (n == 3) return parseOperand(w[2], &code->as.assign.right) ? NULL : "bad operand";
+    if (!isIdentifier(w[3])) return "bad function name";
+    code->as.assign.right = (Operand){.kind = O_INVOKE, .name = internWord(w[3])};
+    return NULL;
+  }
+  if (n != 5 || w[3].len != 1) return "unknown code";
+  for (int kind = C_ADD; kind <= C_DIV; ++kind) {
+    if (w[3].s[0] != binary_ops[kind]) continue;
+    code->kind = kind;
+    code->as.binary.result = left;
+    return parseOperand(w[2], &code->as.binary.op1) && parseOperand(w[4], &code->as.binary.op2)
+             ? NULL : "bad operand";
+  }
+  return "unknown arithmetic operator";
+}
+
+/**
+ * @brief build the list from len bytes of text IR in the format of `printCode`, one code a line.
+ * only the syntax, the labels and the calls are checked, so the codes must come from a valid
+ * program, e.g. of another compiler.
+ * @param name the name of the text in diagnostics
+ * @return NULL if there is an error, which goes to the diagnostics of ctx
+ */
+CodeList* parseCodeList(CompilerContext *ctx, const char *text, const size_t len, const char *name) {
+  bindContext(ctx);
+  CodeList *list = createCodeList();
+  Labels labels;
+  initLabels(&labels);
+  int line_capacity = 64;
+  int *lines = malloc(sizeof(int) * line_capacity); // of each code, by its index
+  const char *p = text, *end = text + len;
+  const char *reason = NULL;
+  InternId undefined = -1; // a label jumped to but not defined in its function
+  int line = 1;
+  for (; p < end && undefined == -1; ++line) {
+    Word words[MAX_WORD_NUM];
+    int n = 0;
+    while (p < end && *p != '\n') {
+      if (isspace((unsigned char) *p)) {
+        p++;
+        continue;
+      }
+      const char *s = p;
+      while (p < end && !isspace((unsigned char) *p)) p++;
+      if (n == MAX_WORD_NUM) reason = "too many words";
+      else words[n++] = (Word){s, (int) (p - s)};
+    }
+    p++; // '\n'
+    if (n == 0) continue;
+
+    Code code;
+    if (reason == NULL) reason = parseCode(words, n, &labels, line, &code);
+    if (reason == NULL && code.kind != C_FUNCTION && firstCode(list) == CODE_SENTINEL)
+      reason = "code outside of any function";
+    if (reason != NULL) break;
+    if (code.kind == C_FUNCTION) undefined = endFunction(&labels);
+    const CodeIndex i = addCode(list, code);
+    if (i >= (CodeIndex) line_capacity) {
+      RESIZE(line_capacity);
+      lines = realloc(lines, sizeof(int) * line_capacity);
+    }
+    lines[i] = line;
+  }
+  if (reason == NULL && undefined == -1) undefined = endFunction(&labels);
+  if (reason != NULL) {
+    fprintf(ctx->diagnostics, "%s:%d: %s\n", name, line, reason);
+  } else if (undefined != -1) {
+    fprintf(ctx->diagnostics, "%s:%d: undefined label %s\n",
+            name, labels.line[undefined], internedStr(undefined));
+  } else if (firstCode(list) == CODE_SENTINEL) {
+    fprintf(ctx->diagnostics, "%s: no code\n", name);
+  } else {
+    CodeIndex at;
+    InternId callee;
+    reason = checkCalls(list, &at, &callee);
+    if (reason != NULL && callee == -1) fprintf(ctx->diagnostics, "%s:%d: %s\n", name, lines[at], reason);
+    else if (reason != NULL)
+      fprintf(ctx->diagnostics, "%s:%d: %s %s\n", name, lines[at], reason, internedStr(callee));
+  }
+  freeLabels(&labels);
+  free(lines);
+  if (reason != NULL || undefined != -1 || firstCode(list) == CODE_SENTINEL) {
+    freeCodeList(list);
+    return NULL;
+  }
+  return list;
+}
+
+#undef MAX_WORD_NUM
@@ -0,0 +1,31 @@
+#ifndef IR_FILE__H
+#define IR_FILE__H
+
+#ifdef LOCAL
+#include <IR.h>
+#else
+#include "IR.h"
+#endif
+
+/* the binary IR file, in the byte order of the host:
+ *   header     IRFileHeader
+ *   nodes      node_cnt Chunks, in the order of the list, nodes[0] is the sentinel
+ *   strings    str_cnt strings ending with '\0', the string of InternId i is the i-th
+ * nodes are stored as they are laid out in memory, so a loaded list points into the file.
+ * bump IR_FILE_VERSION whenever Code, Operand or an enum they use changes. */
+#define IR_FILE_MAGIC "CMIR"
+#define IR_FILE_VERSION 1
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t chunk_size; // sizeof(Chunk) of the writer
+  uint32_t node_cnt;
+  uint32_t str_cnt, str_bytes;
+} IRFileHeader;
+
+int writeCodeList(CompilerContext *ctx, FILE *file, const CodeList *list);
+CodeList* loadCodeList(CompilerContext *ctx, const char *path);
+CodeList* parseCodeList(CompilerContext *ctx, const char *text, size_t len, const char *name);
+
+#endif
@@ -0,0 +1,551 @@
+#ifdef LOCAL
+#include <LinearScan.h>
+#else
+#include "LinearScan.h"
+#endif
+
+#include <limits.h>
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+/* every code of a function has two positions in the order they are laid out, the first
+ * for what it reads and the second for what it defines, so a value read for the last time
+ * may leave its register to the one the same code defines. the interval of a variable
+ * runs from the first position it is live or referred at to the last one, the holes
+ * between are kept. registers go to the intervals in the order they start, as
+ * in "Linear Scan Register Allocation" by Poletto and Sarkar. when none is free, the
+ * interval least worth a register from there on gives it up: it keeps the register up to
+ * the block before, waits in memory, and comes back at the next block referring to it,
+ * where it may get another one, like the second chance of Traub, Holloway and Smith.
+ * a reference weighs 10 to the power of the loops around it, a call it is live across
+ * twice that for the store and the load around the call. */
+
+#define MAX_WEIGHTED_DEPTH 6 // deeper loops weigh as much as this one
+
+typedef struct {
+  int start, end; // positions, end is -1 if the variable is never seen
+  double cost;    // the weight of its references
+  double call_cost;
+  int reg;        // the register held now, -1 if none
+  int opened;     // the block it has held the register since
+  bool param;
+} Interval;
+
+typedef struct {
+  int var;
+  Segment segment;
+} VarSegment;
+
+typedef struct {
+  const Block *block;
+  int entry, block_cnt, var_cnt, reg_cnt;
+  int *block_start;  // the first position of each block, and the number of positions
+  int *block_of;     // the block of each position, counted from entry
+  Interval *intervals;
+  int *refs;         // the positions each variable is referred at, variable after variable
+  double *ref_after; // the weight of the references from each one on
+  int *var_refs;     // the first reference of each variable, and the end of the last
+  int *call_block, call_cnt; // the block of each call
+  int *across, across_cnt, across_capacity; // the call and a variable live across it, in pairs
+  int *heap, heap_cnt; // the variables waiting for a register, by the position they start at
+  int *starts;
+  int *active;         // the variable in each register, -1 if free
+  VarSegment *segments;
+  int segment_cnt, segment_capacity;
+} Scan;
+
+static bool isCall(const Code *code) {
+  return code->kind == C_ASSIGN && code->as.assign.right.kind == O_INVOKE;
+}
+
+// the first variable in set from var on, -1 if none
+static int nextVar(const uint64_t *set, const int cnt, int var) {
+  while (var < cnt) {
+    const uint64_t word = set[var >> 6] >> (var & 63);
+    if (word != 0) {
+      var += __builtin_ctzll(word);
+      return var < cnt ? var : -1;
+    }
+    var = (var | 63) + 1;
+  }
+  return -1;
+}
+
+#define FOR_EACH_VAR(var, set, cnt) \
+  for (int var = nextVar(set, cnt, 0); var != -1; var = nextVar(set, cnt, var + 1))
+
+static double weightOf(const BasicBlock *basic) {
+  double weight = 1;
+  for (int d = 0; d < basic->loop_depth && d < MAX_WEIGHTED_DEPTH; ++d) weight *= 10;
+  return weight;
+}
+
+///// Intervals //////////////////////////////////////////////
+
+static void numberPositions(Scan *s) {
+  const CodeList *list = s->block->list;
+  s->block_start = malloc(sizeof(int) * (s->block_cnt + 1));
+  int pos = 0;
+  for (int b = 0; b < s->block_cnt; ++b) {
+    const BasicBlock *basic = &s->block->container[s->entry + b];
+    s->block_start[b] = pos;
+    const CodeIndex stop = nextCode(list, basic->end);
+    for (CodeIndex i = basic->begin; i != stop; i = nextCode(list, i)) pos += 2;
+  }
+  s->block_start[s->block_cnt] = pos;
+  s->block_of = malloc(sizeof(int) * (pos + 1));
+  for (int b = 0; b < s->block_cnt; ++b) {
+    for (int p = s->block_start[b]; p < s->block_start[b + 1]; ++p) s->block_of[p] = b;
+  }
+}
+
+// the positions and weights of every reference, then the hull of each interval
+static void findReferences(Scan *s) {
+  const Block *block = s->block;
+  const CodeList *list = block->list;
+  s->var_refs = calloc(s->var_cnt + 1, sizeof(int));
+  for (int v = 0; v < s->var_cnt; ++v)
+    s->intervals[v] = (Interval){.start = INT_MAX, .end = -1, .reg = -1};
+  s->call_cnt = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    int pos = 0;
+    for (int b = 0; b < s->block_cnt; ++b) {
+      const BasicBlock *basic = &block->container[s->entry + b];
+      const double weight = weightOf(basic);
+      const CodeIndex stop = nextCode(list, basic->end);
+      for (CodeIndex i = basic->begin; i != stop; i = nextCode(list, i), ++pos) {
+        const Code *code = codeAt(list, i);
+        if (pass == 0 && isCall(code)) s->call_cnt++;
+        bool defines;
+        const int used = variableSlots(code, &defines);
+        // the slots read come first, so the references of a variable stay in order
+        for (int n = 1; n <= 3; ++n) {
+          const int slot = n % 3;
+          if (!(used >> slot & 1)) continue;
+          const int var = block->numbers[3 * i + slot];
+          if (pass == 0) {
+            s->var_refs[var + 1]++;
+            if (code->kind == C_PARAM) s->intervals[var].param = true;
+            continue;
+          }
+          // var_refs holds where the next reference of each variable goes
+          const int at = s->var_refs[var]++;
+          s->refs[at] = 2 * pos + (slot == 0 && defines);
+          s->ref_after[at] = weight;
+        }
+      }
+    }
+    if (pass == 1) break;
+    for (int v = 0; v < s->var_cnt; ++v) s->var_refs[v + 1] += s->var_refs[v];
+    s->refs = malloc(sizeof(int) * (s->var_refs[s->var_cnt] + 1));
+    s->ref_after = malloc(sizeof(double) * (s->var_refs[s->var_cnt] + 1));
+  }
+  // the filling pass has moved every start to the next one
+  for (int v = s->var_cnt; v > 0; --v) s->var_refs[v] = s->var_refs[v - 1];
+  s->var_refs[0] = 0;
+  s->call_block = malloc(sizeof(int) * (s->call_cnt + 1));
+
+  for (int v = 0; v < s->var_cnt; ++v) {
+    Interval *interval = &s->intervals[v];
+    const int first = s->var_refs[v], last = s->var_refs[v + 1] - 1;
+    if (first > last) continue;
+    interval->start = s->refs[first];
+    interval->end = s->refs[last];
+    for (int r = last - 1; r >= first; --r) s->ref_after[r] += s->ref_after[r + 1];
+    interval->cost = s->ref_after[first];
+  }
+  const int cnt = s->var_cnt;
+  for (int b = 0; b < s->block_cnt; ++b) {
+    const BasicBlock *basic = &block->container[s->entry + b];
+    FOR_EACH_VAR(v, basic->live_in, cnt) {
+      if (s->block_start[b] < s->intervals[v].start) s->intervals[v].start = s->block_start[b];
+    }
+    FOR_EACH_VAR(v, basic->live_out, cnt) {
+      if (s->block_start[b + 1] - 1 > s->intervals[v].end) s->intervals[v].end = s->block_start[b + 1] - 1;
+    }
+  }
+}
+
+// the variables live across each call, going backwards from the end of each block
+static void findCallsAcross(Scan *s) {
+  const Block *block = s->block;
+  const CodeList *list = block->list;
+  const int words = BIT_WORDS(s->var_cnt);
+  uint64_t *live = malloc(sizeof(uint64_t) * (words + 1));
+  s->across_capacity = 16;
+  s->across = malloc(sizeof(int) * s->across_capacity);
+  s->across_cnt = 0;
+
+  int call = 0;
+  for (int b = 0; b < s->block_cnt; ++b) {
+    const BasicBlock *basic = &block->container[s->entry + b];
+    const double weight = 2 * weightOf(basic);
+    const CodeIndex stop = nextCode(list, basic->end);
+    int block_calls = 0;
+    for (CodeIndex i = basic->begin; i != stop; i = nextCode(list, i))
+      block_calls += isCall(codeAt(list, i));
+    if (block_calls == 0) continue;
+
+    memcpy(live, basic->live_out, sizeof(uint64_t) * words);
+    int next = call + block_calls; // the calls are numbered in the order of code
+    call = next;
+    const CodeIndex head = prevCode(list, basic->begin);
+    for (CodeIndex i = basic->end; i != head; i = prevCode(list, i)) {
+      const Code *code = codeAt(list, i);
+      bool defines;
+      const int used = variableSlots(code, &defines);
+      if (defines) CLEAR_BIT(live, block->numbers[3 * i]);
+      if (isCall(code)) {
+        s->call_block[--next] = s->entry + b;
+        FOR_EACH_VAR(v, live, s->var_cnt) {
+          if (s->across_cnt + 2 > s->across_capacity) {
+            RESIZE(s->across_capacity);
+            s->across = realloc(s->across, sizeof(int) * s->across_capacity);
+          }
+          s->across[s->across_cnt++] = next;
+          s->across[s->across_cnt++] = v;
+          s->intervals[v].call_cost += weight;
+        }
+      }
+      for (int slot = defines; slot < 3; ++slot) {
+        if (used >> slot & 1) SET_BIT(live, block->numbers[3 * i + slot]);
+      }
+    }
+  }
+  free(live);
+}
+
+///// Scan ///////////////////////////////////////////////////
+
+static bool startsBefore(const Scan *s, const int a, const int b) {
+  return s->starts[a] < s->starts[b] || (s->starts[a] == s->starts[b] && a < b);
+}
+
+static void push(Scan *s, const int var) {
+  int i = s->heap_cnt++;
+  while (i > 0 && startsBefore(s, var, s->heap[(i - 1) / 2])) {
+    s->heap[i] = s->heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  s->heap[i] = var;
+}
+
+static int pop(Scan *s) {
+  const int top = s->heap[0], last = s->heap[--s->heap_cnt];
+  int i = 0;
+  while (2 * i + 1 < s->heap_cnt) {
+    int child = 2 * i + 1;
+    if (child + 1 < s->heap_cnt && startsBefore(s, s->heap[child + 1], s->heap[child])) child++;
+    if (!startsBefore(s, s->heap[child], last)) break;
+    s->heap[i] = s->heap[child];
+    i = child;
+  }
+  s->heap[i] = last;
+  return top;
+}
+
+// the first reference of var at pos or after, the end of its references if none
+static int firstRefFrom(const Scan *s, const int var, const int pos) {
+  int lo = s->var_refs[var], hi = s->var_refs[var + 1];
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (s->refs[mid] < pos) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// what keeping var in a register saves from pos on
+static double costFrom(const Scan *s, const int var, const int pos) {
+  const int r = firstRefFrom(s, var, pos);
+  return r < s->var_refs[var + 1] ? s->ref_after[r] : 0;
+}
+
+static void take(Scan *s, const int var, const int reg, const int pos) {
+  s->active[reg] = var;
+  s->intervals[var].reg = reg;
+  s->intervals[var].opened = s->block_of[pos];
+}
+
+// var leaves its register after the block to, which may come before the one it was taken in
+static void release(Scan *s, const int var, const int to) {
+  Interval *interval = &s->intervals[var];
+  if (to >= interval->opened) {
+    if (s->segment_cnt >= s->segment_capacity) {
+      RESIZE(s->segment_capacity);
+      s->segments = realloc(s->segments, sizeof(VarSegment) * s->segment_capacity);
+    }
+    s->segments[s->segment_cnt++] = (VarSegment){
+      var, {s->entry + interval->opened, s->entry + to, interval->reg}
+    };
+  }
+  s->active[interval->reg] = -1;
+  interval->reg = -1;
+}
+
+// var stays in memory up to the next block referring to it, where it waits for a register again
+static void postpone(Scan *s, const int var, const int pos) {
+  const int r = firstRefFrom(s, var, s->block_start[s->block_of[pos] + 1]);
+  if (r == s->var_refs[var + 1]) return;
+  s->starts[var] = s->block_start[s->block_of[s->refs[r]]];
+  push(s, var);
+}
+
+static void scan(Scan *s) {
+  s->heap = malloc(sizeof(int) * (s->var_cnt + 1));
+  s->starts = malloc(sizeof(int) * (s->var_cnt + 1));
+  s->heap_cnt = 0;
+  for (int v = 0; v < s->var_cnt; ++v) {
+    const Interval *interval = &s->intervals[v];
+    // a variable live across calls worth more than its references is left in memory
+    if (interval->end == -1 || interval->cost <= interval->call_cost) continue;
+    // so is a parameter not leaving the first block, it may stay in the register passing it
+    if (interval->param && interval->call_cost == 0 && interval->end < s->block_start[1]) continue;
+    s->starts[v] = interval->start;
+    push(s, v);
+  }
+  s->active = malloc(sizeof(int) * s->reg_cnt);
+  for (int r = 0; r < s->reg_cnt; ++r) s->active[r] = -1;
+  s->segment_capacity = 16;
+  s->segments = malloc(sizeof(VarSegment) * s->segment_capacity);
+  s->segment_cnt = 0;
+
+  while (s->heap_cnt > 0) {
+    const int var = pop(s), pos = s->starts[var];
+    int reg = -1;
+    for (int r = 0; r < s->reg_cnt; ++r) {
+      const int held = s->active[r];
+      if (held != -1 && s->intervals[held].end < pos)
+        release(s, held, s->block_of[s->intervals[held].end]);
+      if (s->active[r] == -1 && reg == -1) reg = r;
+    }
+    if (reg == -1) {
+      int victim = var;
+      double least = costFrom(s, var, pos);
+      for (int r = 0; r < s->reg_cnt; ++r) {
+        const int held = s->active[r];
+        const double cost = costFrom(s, held, pos);
+        if (cost < least || (cost == least && s->intervals[held].end > s->intervals[victim].end)) {
+          victim = held;
+          least = cost;
+        }
+      }
+      if (victim == var) {
+        postpone(s, var, pos);
+        continue;
+      }
+      reg = s->intervals[victim].reg;
+      release(s, victim, s->block_of[pos] - 1);
+      postpone(s, victim, pos);
+    }
+    take(s, var, reg, pos);
+  }
+  for (int r = 0; r < s->reg_cnt; ++r) {
+    const int held = s->active[r];
+    if (held != -1) release(s, held, s->block_of[s->intervals[held].end]);
+  }
+}
+
+///// Placement //////////////////////////////////////////////
+
+// the register of var throughout the block, -1 if it is in memory
+int placeOf(const Allocation *allocation, const int var, const int block) {
+  assert(0 <= var && var < allocation->var_cnt);
+  for (int i = allocation->var_segments[var]; i < allocation->var_segments[var + 1]; ++i) {
+    const Segment *segment = &allocation->segments[i];
+    if (segment->from <= block && block <= segment->to) return segment->reg;
+  }
+  return -1;
+}
+
+// whether a block ends by falling or jumping to a single successor, after which it may load
+static bool leavesAlone(const Block *block, const int index) {
+  const BasicBlock *basic = &block->container[index];
+  return basic->succ_cnt == 1 && codeAt(block->list, basic->end)->kind != C_IFGOTO;
+}
+
+/* whether the block loads var on entry: it wants var in a register, which is somewhere else
+ * at the end of a predecessor that also leads elsewhere, so the load can't be left to it. */
+static bool loadsOnEntry(const Allocation *allocation, const Block *block,
+                         const int var, const int index) {
+  const int reg = placeOf(allocation, var, index);
+  if (reg == -1) return false;
+  const BasicBlock *basic = &block->container[index];
+  for (int p = 0; p < basic->pred_cnt; ++p) {
+    const int pred = basic->pred[p];
+    if (placeOf(allocation, var, pred) != reg && !leavesAlone(block, pred)) return true;
+  }
+  return false;
+}
+
+// whether var, live into succ, goes there from pred through memory
+static bool passesInMemory(const Allocation *allocation, const Block *block,
+                           const int var, const int pred, const int succ) {
+  const int reg = placeOf(allocation, var, succ);
+  return reg == -1 || reg != placeOf(allocation, var, pred) ||
+         loadsOnEntry(allocation, block, var, succ);
+}
+
+typedef struct {
+  Allocation *allocation;
+  int cnt, capacity;
+} Moves;
+
+static void addMove(Moves *moves, const int var, const int reg) {
+  Allocation *allocation = moves->allocation;
+  if (moves->cnt >= moves->capacity) {
+    RESIZE(moves->capacity);
+    allocation->moves = realloc(allocation->moves, sizeof(Placement) * moves->capacity);
+  }
+  allocation->moves[moves->cnt++] = (Placement){var, reg};
+}
+
+static void findMoves(Allocation *allocation, const Block *block) {
+  const int cnt = allocation->var_cnt, block_cnt = allocation->block_cnt;
+  allocation->loads = malloc(sizeof(int) * (block_cnt + 1));
+  allocation->stores = malloc(sizeof(int) * (block_cnt + 1));
+  allocation->exit_loads = malloc(sizeof(int) * (block_cnt + 1));
+  Moves moves = {allocation, 0, 16};
+  allocation->moves = malloc(sizeof(Placement) * moves.capacity);
+  for (int b = 0; b < block_cnt; ++b) {
+    const int index = allocation->entry + b;
+    allocation->loads[b] = moves.cnt;
+    FOR_EACH_VAR(v, block->container[index].live_in, cnt) {
+      if (loadsOnEntry(allocation, block, v, index)) addMove(&moves, v, placeOf(allocation, v, index));
+    }
+  }
+  allocation->loads[block_cnt] = moves.cnt;
+
+  for (int b = 0; b < block_cnt; ++b) {
+    const int index = allocation->entry + b;
+    const BasicBlock *basic = &block->container[index];
+    allocation->stores[b] = moves.cnt;
+    FOR_EACH_VAR(v, basic->live_out, cnt) {
+      const int reg = placeOf(allocation, v, index);
+      if (reg == -1) continue;
+      for (int i = 0; i < basic->succ_cnt; ++i) {
+        const int succ = basic->succ[i];
+        if (TEST_BIT(block->container[succ].live_in, v) &&
+            passesInMemory(allocation, block, v, index, succ)) {
+          addMove(&moves, v, reg);
+          break;
+        }
+      }
+    }
+  }
+  allocation->stores[block_cnt] = moves.cnt;
+
+  for (int b = 0; b < block_cnt; ++b) {
+    const int index = allocation->entry + b;
+    const BasicBlock *basic = &block->container[index];
+    allocation->exit_loads[b] = moves.cnt;
+    if (!leavesAlone(block, index)) continue;
+    const int succ = basic->succ[0];
+    FOR_EACH_VAR(v, block->container[succ].live_in, cnt) {
+      const int reg = placeOf(allocation, v, succ);
+      if (reg != -1 && reg != placeOf(allocation, v, index) && !loadsOnEntry(allocation, block, v, succ))
+        addMove(&moves, v, reg);
+    }
+  }
+  allocation->exit_loads[block_cnt] = moves.cnt;
+}
+
+// the registers held across each call, out of the variables live across it
+static void findSaves(Allocation *allocation, const Scan *s) {
+  allocation->call_saves = calloc(allocation->call_cnt + 1, sizeof(int));
+  allocation->saves = malloc(sizeof(Placement) * (s->across_cnt / 2 + 1));
+  for (int i = 0; i < s->across_cnt; i += 2) allocation->call_saves[s->across[i] + 1]++;
+  for (int c = 0; c < allocation->call_cnt; ++c)
+    allocation->call_saves[c + 1] += allocation->call_saves[c];
+  int *next = malloc(sizeof(int) * (allocation->call_cnt + 1));
+  memcpy(next, allocation->call_saves, sizeof(int) * (allocation->call_cnt + 1));
+  for (int i = 0; i < s->across_cnt; i += 2) {
+    const int call = s->across[i], var = s->across[i + 1];
+    allocation->saves[next[call]++] = (Placement){var, placeOf(allocation, var, s->call_block[call])};
+  }
+  free(next);
+  // keep those in registers only
+  int cnt = 0;
+  for (int c = 0; c < allocation->call_cnt; ++c) {
+    const int begin = allocation->call_saves[c], end = allocation->call_saves[c + 1];
+    allocation->call_saves[c] = cnt;
+    for (int i = begin; i < end; ++i) {
+      if (allocation->saves[i].reg != -1) allocation->saves[cnt++] = allocation->saves[i];
+    }
+  }
+  allocation->call_saves[allocation->call_cnt] = cnt;
+}
+
+/**
+ * @brief allocate reg_cnt registers to the variables of a function.
+ * @return where each variable is in each block, and what is moved around blocks and calls.
+ * @note release it with `freeAllocation`.
+ */
+Allocation* allocateRegisters(const Block *block, const int function, const int reg_cnt) {
+  assert(0 <= function && function < block->function_cnt && reg_cnt > 0);
+  const Function *f = &block->functions[function];
+  const int end = function + 1 < block->function_cnt
+                    ? block->functions[function + 1].entry
+                    : block->cnt;
+  Scan s = {
+    .block = block, .entry = f->entry, .block_cnt = end - f->entry,
+    .var_cnt = f->cnt, .reg_cnt = reg_cnt,
+  };
+  s.intervals = malloc(sizeof(Interval) * (s.var_cnt + 1));
+  numberPositions(&s);
+  findReferences(&s);
+  findCallsAcross(&s);
+  scan(&s);
+
+  Allocation *allocation = malloc(sizeof(Allocation));
+  *allocation = (Allocation){
+    .entry = s.entry, .block_cnt = s.block_cnt, .var_cnt = s.var_cnt, .call_cnt = s.call_cnt,
+  };
+  // the segments of a variable are released in the order of blocks
+  allocation->var_segments = calloc(s.var_cnt + 1, sizeof(int));
+  allocation->segments = malloc(sizeof(Segment) * (s.segment_cnt + 1));
+  for (int i = 0; i < s.segment_cnt; ++i) allocation->var_segments[s.segments[i].var + 1]++;
+  for (int v = 0; v < s.var_cnt; ++v) allocation->var_segments[v + 1] += allocation->var_segments[v];
+  int *next = malloc(sizeof(int) * (s.var_cnt + 1));
+  memcpy(next, allocation->var_segments, sizeof(int) * (s.var_cnt + 1));
+  for (int i = 0; i < s.segment_cnt; ++i)
+    allocation->segments[next[s.segments[i].var]++] = s.segments[i].segment;
+  free(next);
+
+  findMoves(allocation, block);
+  findSaves(allocation, &s);
+
+  free(s.block_start);
+  free(s.block_of);
+  free(s.intervals);
+  free(s.refs);
+  free(s.ref_after);
+  free(s.var_refs);
+  free(s.call_block);
+  free(s.across);
+  free(s.heap);
+  free(s.starts);
+  free(s.active);
+  free(s.segments);
+  return allocation;
+}
+
+void freeAllocation(Allocation *allocation) {
+  assert(allocation != NULL);
+  free(allocation->segments);
+  free(allocation->var_segments);
+  free(allocation->moves);
+  free(allocation->loads);
+  free(allocation->stores);
+  free(allocation->exit_loads);
+  free(allocation->saves);
+  free(allocation->call_saves);
+  free(allocation);
+}
+
+#undef FOR_EACH_VAR
+#undef MAX_WEIGHTED_DEPTH
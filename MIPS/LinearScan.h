@@ -0,0 +1,42 @@
+#ifndef LINEAR_SCAN__H
+#define LINEAR_SCAN__H
+
+#ifdef LOCAL
+#include <Optimize.h>
+#else
+#include "Optimize.h"
+#endif
+
+/* the registers of one function, allocated by a linear scan over the live intervals
+ * of its variables. a variable has one place all over a basic block, either a register
+ * or its slot in the frame, so an interval is only split between blocks. where the
+ * place changes along an edge the value goes through memory: the source block stores it
+ * before it leaves, and loads it for the target if that is its only successor, or else
+ * the target loads it on entry, after every predecessor has stored it. */
+
+typedef struct {
+  int var, reg; // a variable and its register, which is known by its number below reg_cnt
+} Placement;
+
+typedef struct {
+  int from, to; // the blocks a variable stays in a register, inclusive
+  int reg;
+} Segment;
+
+typedef struct {
+  int entry, block_cnt;      // the blocks of the function, from entry on
+  int var_cnt;
+  Segment *segments;         // variable after variable, in the order of blocks
+  int *var_segments;         // the first segment of each variable, and the end of the last
+  Placement *moves;
+  int *loads, *stores;       // the first move of each block, loaded on entry or stored on exit
+  int *exit_loads;           // loaded on exit after the stores, for the only successor
+  Placement *saves;
+  int *call_saves, call_cnt; // the first register held across each call, in the order of code
+} Allocation;
+
+Allocation* allocateRegisters(const Block *block, int function, int reg_cnt);
+int placeOf(const Allocation *allocation, int var, int block);
+void freeAllocation(Allocation *allocation);
+
+#endif
@@ -1,64 +1,208 @@
 #ifdef LOCAL
 #include <IR.h>
+#include <LinearScan.h>
 #include <Morph.h>
 #define PRINT_INFO(op, message...) \
-  long _back_fill_pos = -1;\
+  size_t _back_fill_pos = SIZE_MAX;\
   do {\
-    fprintf(f, "%*s#++ '%-20s' ", INDENT, "", __FUNCTION__);\
+    emitFormat("%*s#++ '%-20s' ", INDENT, "", __FUNCTION__);\
     if (op) {\
-      fprintf(f," (");\
-      printOp(f, op);\
-      fseek(f, -1, SEEK_CUR);\
-      fprintf(f,") <->    ");\
-      _back_fill_pos = ftell(f) - 3;\
+      emit(" (");\
+      emitOperand(op);\
+      out.len--; /* the trailing space of printOp */\
+      emit(") <->    ");\
+      _back_fill_pos = out.len - 3;\
       }\
-    fprintf(f, message);\
-    fprintf(f, "\n");\
+    emitFormat(message);\
+    emitChar('\n');\
   } while(false)
 
+// the placeholder is in memory still, overwrite it with the register
 #define BACK_FILL(reg) do {\
-    assert(_back_fill_pos != -1);\
-    fseek(f, _back_fill_pos, SEEK_SET);\
-    fprintf(f, "%s", reg);\
-    fseek(f, 0, SEEK_END);\
+    assert(_back_fill_pos != SIZE_MAX && strlen(reg) <= 3);\
+    memcpy(out.data + _back_fill_pos, reg, strlen(reg));\
   } while(false)
 
 #else
 #include "IR.h"
+#include "LinearScan.h"
 #include "Morph.h"
 #define PRINT_INFO(op, message...)
 #define BACK_FILL(reg)
 #endif
 
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
 #define ELEM_SIZE 4
 
 typedef void (*FuncPtr)(const Code *);
 typedef const char *RegType;
 
-static FILE *f = NULL;
-static use_info *USE_INFO = NULL;
+// the state of `printMIPS`, each thread emits its own file
+static _Thread_local use_info *USE_INFO = NULL;
+// the blocks being emitted
+static _Thread_local const Block *BLOCKS = NULL;
+static _Thread_local Allocator ALLOCATOR;
+// the block being emitted, and the registers of its function if linear scan allocates them
+static _Thread_local int CURRENT;
+static _Thread_local Allocation *ALLOCATION = NULL;
+static _Thread_local int CALLS; // the calls of the function emitted so far
+
+///// Output buffer //////////////////////////////////////////
+
+#define OUT_INIT_CAPACITY (64 * 1024)
+
+/* the assembly is appended to memory and written out at once by `printMIPS`,
+ * so that an instruction costs a few copies instead of a formatted write,
+ * and back-filling an annotation is a plain store. */
+static _Thread_local struct {
+  char *data;
+  size_t len, capacity;
+} out;
+
+// @return where the next n bytes go, the length is left to the caller
+static char* reserve(const size_t n) {
+  if (out.len + n > out.capacity) {
+    if (out.capacity == 0) out.capacity = OUT_INIT_CAPACITY;
+    while (out.len + n > out.capacity) out.capacity *= 2;
+    out.data = realloc(out.data, out.capacity);
+    assert(out.data != NULL);
+  }
+  return out.data + out.len;
+}
+
+static void emitBytes(const char *str, const size_t len) {
+  memcpy(reserve(len), str, len);
+  out.len += len;
+}
+
+static void emit(const char *str) {
+  emitBytes(str, strlen(str));
+}
+
+static void emitChar(const char c) {
+  *reserve(1) = c;
+  out.len++;
+}
+
+/**
+ * @brief write val in decimal to buf, which holds 12 chars at least.
+ * @return the end of digits, where '\0' is put.
+ */
+static char* formatInt(char *buf, const int val) {
+  char digits[10];
+  unsigned int u = val < 0 ? -(unsigned int) val : (unsigned int) val;
+  int n = 0;
+  do {
+    digits[n++] = (char) ('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  if (val < 0) *buf++ = '-';
+  while (n > 0) *buf++ = digits[--n];
+  *buf = '\0';
+  return buf;
+}
+
+static void emitInt(const int val) {
+  char buf[12];
+  emitBytes(buf, formatInt(buf, val) - buf);
+}
+
+static void emitIndent() {
+  memset(reserve(INDENT), ' ', INDENT);
+  out.len += INDENT;
+}
+
+// the indented mnemonic, padded to 4 columns and followed by a space
+static void emitMnemonic(const char *name) {
+  emitIndent();
+  const size_t len = strlen(name);
+  char *p = reserve(len + 5);
+  memcpy(p, name, len);
+  size_t n = len;
+  while (n < 4) p[n++] = ' ';
+  p[n++] = ' ';
+  out.len += n;
+}
+
+#ifdef LOCAL
+// only the annotations of LOCAL builds are formatted
+static void emitFormat(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  const int n = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  va_start(args, format);
+  vsnprintf(reserve(n + 1), n + 1, format, args);
+  va_end(args);
+  out.len += n;
+}
+
+// `printOp` and `printCode` write to streams, take their text through a memory stream
+#define EMIT_THROUGH_STREAM(print, arg) do {\
+    char *_text;\
+    size_t _len;\
+    FILE *_stream = open_memstream(&_text, &_len);\
+    assert(_stream != NULL);\
+    print(_stream, arg);\
+    fclose(_stream);\
+    emitBytes(_text, _len);\
+    free(_text);\
+  } while (false)
+
+static void emitOperand(const Operand *op) {
+  EMIT_THROUGH_STREAM(printOp, op);
+}
+
+static void emitCode(const Code *code) {
+  EMIT_THROUGH_STREAM(printCode, code);
+}
+#undef EMIT_THROUGH_STREAM
+#endif
+
+// write the whole buffer to file, and release it
+static void flushOutput(FILE *file) {
+  if (fwrite(out.data, 1, out.len, file) != out.len) {
+    DEBUG_INFO("fail to write the assembly.\n");
+    exit(EXIT_FAILURE);
+  }
+  free(out.data);
+  out.data = NULL;
+  out.len = out.capacity = 0;
+}
+#undef OUT_INIT_CAPACITY
 
 #define CHECK_FREE(i, op_) do { \
-    assert(cmp_operand(&(USE_INFO[i].op), &(op_)) == 0);\
-    if (!USE_INFO[i].in_use) freeReg(op_);\
+    assert(cmp_operand(&(USE_INFO[i].op), (op_)) == 0);\
+    if (!USE_INFO[i].in_use) freeReg(USE_INFO[i].index);\
   } while (false)
 
-/* variables is an array of pointers which takes charge
- * of variables in the current basic block */
-static const Operand **variables = NULL;
-static size_t CNT;
+// the number of the variable in the i-th operand of the current code
+#define VAR(i) (USE_INFO[i].index)
+
+/* variables is an array of operands which takes charge of variables in the
+ * current function, numbered by the optimizer. it belongs to `BLOCKS` */
+static _Thread_local const Operand *variables = NULL;
+static _Thread_local size_t CNT;
 
 // track the storage location of values
 typedef struct {
   /** offset is related to frame pointer($fp),
-   * reg_index is the index of register in registers' pool */
-  int offset, reg_index;
+   * reg_index is the index of register in registers' pool,
+   * storage is where the space of a declared array or struct starts, also related to $fp */
+  int offset, reg_index, storage;
+  bool dirty; // the register holds a value that isn't in memory yet
+  int clean_in; // under linear scan, the block in which memory holds the value of its register
 } AddrDescriptor;
 
 #define is_addr_descriptor_valid(ad) ((ad)->offset != -1)
 #define is_in_reg(ad) ((ad)->reg_index != -1)
 // an array of address descriptor, which is the same length of `variables`
-AddrDescriptor *addr_descriptors = NULL;
+static _Thread_local AddrDescriptor *addr_descriptors = NULL;
 
 // fix: to shuffle the regsPool, need to remove `const`, else cause segmentation fault
 static const RegType regsPool[] = {
@@ -69,20 +213,44 @@ static const RegType regsPool[] = {
 };
 #define LEN (ARRAY_LEN(regsPool))
 
+// $a0 to $a3, which end the pool
+static RegType argReg(const int i) {
+  assert(0 <= i && i < 4);
+  return regsPool[LEN - 4 + i];
+}
+
+// the registers linear scan places variables in, by their index in the pool
+static const int placeable[] = {0, 1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15, 16, 17};
+/* the registers `seizeReg` may take. under linear scan the deque only holds the variables
+ * in memory, in $t8, $t9, $v1 and $v0, and the parameters adopted in $a0 to $a3 */
+static _Thread_local bool seizable[LEN];
+
+// the register of var throughout the current block under linear scan, NULL if none
+static RegType placedReg(const int var) {
+  if (ALLOCATION == NULL) return NULL;
+  const int reg = placeOf(ALLOCATION, var, CURRENT);
+  return reg == -1 ? NULL : regsPool[placeable[reg]];
+}
+
 typedef struct {
   int next_i, prev_i; // next index and previous index
-  const Operand *op;
+  int var;            // the variable held, -1 for a temporary value
 } pair;
 
-static struct {
+static _Thread_local pair deque_pairs[LEN + 1];
+static _Thread_local struct {
   int size;    // the number of allocated register and op pairs
   pair *pairs; // act as an array
-} deque = {
-  .size = 0,
+} deque;
+
+static void initDeque() {
+  memset(deque_pairs, 0, sizeof(deque_pairs));
+  deque_pairs[0] = (pair){.next_i = -1, .prev_i = -1};
+  deque.size = 0;
   /** make pairs pointing to the second element in the
-   * anonymous array and spare the first element as sentinel */
-  .pairs = (pair[LEN + 1]){{.next_i = -1, .prev_i = -1}} + 1
-};
+   * array and spare the first element as sentinel */
+  deque.pairs = deque_pairs + 1;
+}
 
 // get the pair
 #define get_p(i) (deque.pairs[(i)])
@@ -94,15 +262,9 @@ static int cmp_pair(const void *a, const void *b) {
   return memcmp((pair *) a, (pair *) b, sizeof(pair));
 }
 
-static AddrDescriptor* getAddrDescriptor(const Operand *op) {
-#define findInVariables(op) \
-  findInArray(&(op), true, variables, CNT, sizeof(Operand*), cmp_operand)
-
-  assert(either(op->kind, O_TEM_VAR, O_VARIABLE));
-  const int variable_index = findInVariables(op);
-  assert(variable_index != -1);
-  return addr_descriptors + variable_index;
-#undef findInVariables
+static AddrDescriptor* getAddrDescriptor(const int var) {
+  assert(0 <= var && (size_t) var < CNT);
+  return addr_descriptors + var;
 }
 
 static bool all_addr_descriptor_valid() {
@@ -119,14 +281,18 @@ static void printTernary(const char *name, RegType result,
                          RegType reg1, RegType reg2);
 
 static void printAddImm(const RegType dst_reg, const RegType src_reg, const int val) {
-  char *im = (char *) int2String(val);
-  printTernary("addi", dst_reg, src_reg, im);
-  free(im);
+  emitMnemonic("addi");
+  emit(dst_reg);
+  emit(", ");
+  emit(src_reg);
+  emit(", ");
+  emitInt(val);
+  emitChar('\n');
 }
 
 /** initialize when function starts, increment when encounters a new operand
  * adjusts(increment and decrement) when arguments are more than 4 */
-int frameOffset;
+static _Thread_local int frameOffset;
 
 #define EXPAND (-1)
 #define SHRINK 1
@@ -143,25 +309,32 @@ static void printLoadImm(const RegType reg, const int val) {
   if (val == 0)
     return printBinary("move", reg, "$zero");
 
-  char *im = (char *) int2String(val);
-  printBinary("li", reg, im);
-  free(im);
+  emitMnemonic("li");
+  emit(reg);
+  emit(", ");
+  emitInt(val);
+  emitChar('\n');
 }
 
 static void print_save_load(const char *T, const RegType reg,
                             const int offset, const RegType base_reg) {
   assert(strcmp(T, "sw") == 0 || strcmp(T, "lw") == 0);
-  char buffer[16];
-  snprintf(buffer, sizeof(buffer), "%d(%s)", offset, base_reg);
-  printBinary(T, reg, buffer);
+  emitMnemonic(T);
+  emit(reg);
+  emit(", ");
+  emitInt(offset);
+  emitChar('(');
+  emit(base_reg);
+  emit(")\n");
 }
 
-static void print_spill_absorb(const char T, const AddrDescriptor *ad) {
+static void print_spill_absorb(const char T, AddrDescriptor *ad) {
   PRINT_INFO(NULL, "");
   assert(either(T, 's', 'l'));
   print_save_load(T == 's' ? "sw" : "lw",
                   regsPool[ad->reg_index],
                   ad->offset, "$fp");
+  ad->dirty = false;
 }
 
 #define find_in_regs(reg) findInArray(&reg, false, regsPool, LEN, sizeof(RegType), cmp_str)
@@ -185,7 +358,7 @@ static bool all_regs_empty() {
  * modifying the register and address descriptors.
  *
  * It prints the MIPS code for spilling and absorbing
- * register values to/from memory.
+ * register values to/from memory, values already in memory aren't spilled.
  *
  * @param T The type of operation: 's' for spill, 'l' for load.
  * @param exception The register to be excluded from the operation.
@@ -198,7 +371,8 @@ static void fake_flush_restore(const char T, const RegType exception) {
   for (int i = 0; i < LEN; ++i) {
     const pair *p = &get_p(i);
     if (i == except_index || is_pair_empty(p)) continue;
-    print_spill_absorb(T, getAddrDescriptor(p->op));
+    AddrDescriptor *ad = getAddrDescriptor(p->var);
+    if (T == 'l' || ad->dirty) print_spill_absorb(T, ad);
   }
 }
 
@@ -209,7 +383,7 @@ static void addReg(const int reg_index) {
   assert(is_pair_empty(find));
   find->next_i = -1;
   find->prev_i = pairs_sentinel.prev_i;
-  // note: unable to set find->op right here.
+  // note: unable to set find->var right here.
   get_p(pairs_sentinel.prev_i).next_i = reg_index;
   pairs_sentinel.prev_i = reg_index;
 
@@ -250,7 +424,7 @@ static void removeReg(const int reg_index) {
 static void unlinkBothSide(const int reg_index) {
   const pair *p = &get_p(reg_index);
   assert(!is_pair_empty(p));
-  AddrDescriptor *ad = getAddrDescriptor(p->op);
+  AddrDescriptor *ad = getAddrDescriptor(p->var);
   assert(is_addr_descriptor_valid(ad));
   assert(is_in_reg(ad) && ad->reg_index == reg_index);
 
@@ -260,21 +434,43 @@ static void unlinkBothSide(const int reg_index) {
 
 /**
  * @brief Finds the variable associated with the register, saves
- * its value to memory, and then relinquishes the register.
+ * its value to memory unless it is there already, and then relinquishes the register.
  * @param reg The register to be spilled.
  */
 static void spillReg(const RegType reg) {
   PRINT_INFO(NULL, "");
   const int reg_index = find_in_regs(reg);
   assert(reg_index != -1);
-  const Operand *op = get_p(reg_index).op;
-  const AddrDescriptor *ad = getAddrDescriptor(op);
+  AddrDescriptor *ad = getAddrDescriptor(get_p(reg_index).var);
   assert(ad->reg_index == reg_index);
 
-  print_spill_absorb('s', ad);
+  if (ad->dirty) print_spill_absorb('s', ad);
   unlinkBothSide(reg_index);
 }
 
+/* a block leaves in registers the values live at its end. a successor entered
+ * by a jump, or by several predecessors, expects them in memory, while the only
+ * successor of a block that falls through takes the registers as they are.
+ * under linear scan the deque hands nothing over, its values are in memory between blocks. */
+
+// save the values that the target block reads, unless they are in memory already
+static void storeLiveIn(const BasicBlock *target) {
+  for (int i = 0; i < (int) LEN; ++i) {
+    if (is_pair_empty(&get_p(i))) continue;
+    AddrDescriptor *ad = getAddrDescriptor(get_p(i).var);
+    if (ad->dirty && TEST_BIT(target->live_in, get_p(i).var))
+      print_spill_absorb('s', ad);
+  }
+}
+
+// relinquish the registers, except those holding values live into keep if it isn't NULL
+static void releaseRegs(const BasicBlock *keep) {
+  for (int i = 0; i < (int) LEN; ++i) {
+    if (is_pair_empty(&get_p(i))) continue;
+    if (keep == NULL || !TEST_BIT(keep->live_in, get_p(i).var)) unlinkBothSide(i);
+  }
+}
+
 /**
  * @brief Moves the ownership of a register to a new operand and links the register
  * to the receiver operand.
@@ -286,13 +482,10 @@ static void spillReg(const RegType reg) {
  *
  * @param reg The register to be adopted.
  * @param reg_must_empty A flag indicating whether the register must be empty.
- * @param receiver_op The operand that will receive the register.
+ * @param receiver The variable that will receive the register.
  */
-static void adoptReg(const RegType reg, const bool reg_must_empty,
-                     const Operand *receiver_op) {
-  PRINT_INFO(receiver_op, "adopt <%s>", reg);
-  assert(receiver_op != NULL &&
-    either(receiver_op->kind, O_TEM_VAR, O_VARIABLE));
+static void adoptReg(const RegType reg, const bool reg_must_empty, const int receiver) {
+  PRINT_INFO(&variables[receiver], "adopt <%s>", reg);
   const int reg_index = find_in_regs(reg);
   assert(reg_index != -1);
 
@@ -303,15 +496,21 @@ static void adoptReg(const RegType reg, const bool reg_must_empty,
      *  to spill register before `adoptReg` is called */
     unlinkBothSide(reg_index);
   }
+  const RegType placed = placedReg(receiver);
+  if (placed != NULL) {
+    getAddrDescriptor(receiver)->clean_in = -1;
+    return printBinary("move", placed, reg);
+  }
   addReg(reg_index);
   // note: link the register to the receiver operand
-  pair_->op = receiver_op;
+  pair_->var = receiver;
 
   // update the receiver's address descriptor
-  AddrDescriptor *ad = getAddrDescriptor(receiver_op);
+  AddrDescriptor *ad = getAddrDescriptor(receiver);
   // has valid addr descriptor and register attaches to it
   assert(is_addr_descriptor_valid(ad) && !is_in_reg(ad));
   ad->reg_index = reg_index;
+  ad->dirty = true;
 }
 
 /**
@@ -335,7 +534,7 @@ static int seizeReg(const RegType avoidance) {
     const int i = find_in_pairs(EMPTY_PAIR, reg_index, LEN - reg_index);
     if (i == -1) break;
     reg_index += i;
-    if (avoidance == NULL || strcmp(regsPool[reg_index], avoidance) != 0)
+    if (seizable[reg_index] && (avoidance == NULL || strcmp(regsPool[reg_index], avoidance) != 0))
       goto RETURN;
     reg_index++;
   }
@@ -347,6 +546,7 @@ static int seizeReg(const RegType avoidance) {
 
 RETURN:
   addReg(reg_index);
+  get_p(reg_index).var = -1; // a temporary value until a variable is linked
   return reg_index;
 #undef find_in_pairs
 }
@@ -366,22 +566,28 @@ RETURN:
  * If the allocated register is the same as the
  * avoidance register, it spills the register and tries again.
  *
- * @param op The operand for which a register is to be ensured.
- * @param has_defined A flag indicating whether the operand has been defined.
+ * @param var The variable for which a register is to be ensured.
+ * @param has_defined A flag indicating whether the operand has been defined,
+ * if not, the operand is about to be assigned.
  * @param avoidance The register to be avoided during allocation.
  * @return The register allocated for the operand.
  */
-static RegType ensureReg(const Operand *op, const bool has_defined, const RegType avoidance) {
-  PRINT_INFO(op, "");
-  assert(op->kind != O_CONSTANT);
-  AddrDescriptor *ad = getAddrDescriptor(op);
+static RegType ensureReg(const int var, const bool has_defined, const RegType avoidance) {
+  PRINT_INFO(&variables[var], "");
+  AddrDescriptor *ad = getAddrDescriptor(var);
+  const RegType placed = placedReg(var);
+  if (placed != NULL) {
+    if (!has_defined) ad->clean_in = -1;
+    BACK_FILL(placed);
+    return placed;
+  }
   // already saved on stack
   assert(is_addr_descriptor_valid(ad));
 
 SEARCH:
   if (!is_in_reg(ad)) {
     ad->reg_index = seizeReg(avoidance);
-    get_p(ad->reg_index).op = op; // note: link register here.
+    get_p(ad->reg_index).var = var; // note: link register here.
     if (has_defined)
       print_spill_absorb('l', ad);
   }
@@ -391,29 +597,75 @@ SEARCH:
     spillReg(reg);
     goto SEARCH;
   }
+  if (!has_defined) ad->dirty = true;
   BACK_FILL(reg);
   return reg;
 }
 #undef get_p
 #undef pairs_sentinel
 
-static void freeReg(const Operand *op) {
-  PRINT_INFO(op, "");
-  assert(either(op->kind, O_VARIABLE, O_TEM_VAR));
-  const AddrDescriptor *ad = getAddrDescriptor(op);
+// the value of var is dead, relinquish its register without saving it
+static void freeReg(const int var) {
+  PRINT_INFO(&variables[var], "");
+  const RegType placed = placedReg(var);
+  if (placed != NULL) { // it keeps the register through the block
+    BACK_FILL(placed);
+    return;
+  }
+  const AddrDescriptor *ad = getAddrDescriptor(var);
   assert(is_addr_descriptor_valid(ad) && is_in_reg(ad));
-  // note: always write back to memory
   const RegType reg = regsPool[ad->reg_index];
-  spillReg(reg);
+  unlinkBothSide(ad->reg_index);
   BACK_FILL(reg);
 }
 #undef PRINT_INFO
 #undef BACK_FILL
 
+///// Linear scan ////////////////////////////////////////////
+
+/* a register placed by linear scan is stored or loaded as a whole block wants, and is known
+ * to match memory from then on until it is assigned, within the block. */
+
+// store('s') or load('l') the placed register of var, a store is skipped if memory holds it
+static void movePlaced(const char T, const Placement *placement) {
+  AddrDescriptor *ad = getAddrDescriptor(placement->var);
+  if (T == 's' && ad->clean_in == CURRENT) return;
+  print_save_load(T == 's' ? "sw" : "lw", regsPool[placeable[placement->reg]], ad->offset, "$fp");
+  ad->clean_in = CURRENT;
+}
+
+// load the variables the current block takes in registers from memory, on entry
+static void loadPlaced() {
+  if (ALLOCATION == NULL) return;
+  const int b = CURRENT - ALLOCATION->entry;
+  for (int i = ALLOCATION->loads[b]; i < ALLOCATION->loads[b + 1]; ++i)
+    movePlaced('l', &ALLOCATION->moves[i]);
+}
+
+/* before leaving the current block, store the variables a successor takes from memory,
+ * then load those the only successor takes in other registers */
+static void leavePlaced() {
+  if (ALLOCATION == NULL) return;
+  const int b = CURRENT - ALLOCATION->entry;
+  for (int i = ALLOCATION->stores[b]; i < ALLOCATION->stores[b + 1]; ++i)
+    movePlaced('s', &ALLOCATION->moves[i]);
+  for (int i = ALLOCATION->exit_loads[b]; i < ALLOCATION->exit_loads[b + 1]; ++i)
+    movePlaced('l', &ALLOCATION->moves[i]);
+}
+
+// save('s') or restore('l') the registers held across the current call, which the callee may use
+static void keepAcrossCall(const char T) {
+  assert(either(T, 's', 'l'));
+  if (ALLOCATION == NULL) return;
+  assert(CALLS < ALLOCATION->call_cnt);
+  for (int i = ALLOCATION->call_saves[CALLS]; i < ALLOCATION->call_saves[CALLS + 1]; ++i)
+    movePlaced(T, &ALLOCATION->saves[i]);
+}
+
 /** both of parameters' and arguments' counter will be
  * initialized at the beginning of function, while only
  * arguments' counter will be reset after the function invocation. */
-static struct { // no more than 4
+static _Thread_local struct { // no more than 4
   uint8_t arg;
   uint8_t param;
 } counter;
@@ -423,19 +675,20 @@ static void printPARAM(const Code *code) {
   const Operand *receiver = &code->as.unary;
   assert(receiver->kind == O_VARIABLE);
 
-  AddrDescriptor *ad = getAddrDescriptor(receiver);
+  AddrDescriptor *ad = getAddrDescriptor(VAR(0));
   if (counter.param < 4) { // allocate space on stack
     assert(is_addr_descriptor_valid(ad));
 
-    char courier[4];
-    snprintf(courier, sizeof(courier), "$a%d", counter.param);
+    const RegType courier = argReg(counter.param);
     // pass the register's ownership to the operand
-    adoptReg(courier, false, receiver); // ad->reg_index will be set within `adoptReg`
+    adoptReg(courier, false, VAR(0)); // ad->reg_index will be set within `adoptReg`
     CHECK_FREE(0, receiver);            // note: remember to free
   } else {
     // the caller has already saved the value on stack
     ad->offset = (counter.param - 4) * ELEM_SIZE;
     assert(!is_in_reg(ad)); // unnecessary to load into register at present
+    const int reg = ALLOCATION == NULL ? -1 : placeOf(ALLOCATION, VAR(0), CURRENT);
+    if (reg != -1) movePlaced('l', &(Placement){VAR(0), reg});
   }
   counter.param++;
 }
@@ -444,6 +697,7 @@ static void printPARAM(const Code *code) {
 typedef struct {
   bool is_tmp;
   int reg_index;
+  Operand held; // the variable held by the register, unless is_tmp
 } RegHelper;
 
 // the below two macros are related with RegHelper
@@ -457,7 +711,7 @@ typedef struct {
   if (op##_helper.is_tmp) {\
     removeReg(op##_helper.reg_index);\
   } else {\
-    CHECK_FREE(i, op);\
+    CHECK_FREE(i, &op##_helper.held);\
   }
 
 /**
@@ -471,34 +725,34 @@ typedef struct {
  * @param avoidance The register to be avoided during allocation.
  * @return A struct containing information about whether the allocated register is temporary and its index.
  */
-static RegHelper rightHelper(const int index, const Operand **op, const RegType avoidance) {
-#define helper_(is_tmp_, reg_index_) (RegHelper){\
-  .is_tmp = is_tmp_, .reg_index = reg_index_\
+static RegHelper rightHelper(const int index, const Operand *op, const RegType avoidance) {
+#define helper_(is_tmp_, reg_index_, held_) (RegHelper){\
+  .is_tmp = is_tmp_, .reg_index = reg_index_, .held = held_\
 }
-  const int kind = (*op)->kind;
+  const int kind = op->kind;
   assert(in(kind, 1 + EFFECTIVE_OP, O_CONSTANT));
   int reg_index;
   if (kind == O_CONSTANT) {
     reg_index = seizeReg(avoidance);
-    printLoadImm(regsPool[reg_index], (*op)->value);
-    return helper_(true, reg_index);
+    printLoadImm(regsPool[reg_index], op->value);
+    return helper_(true, reg_index, *op);
   }
   if (kind == O_DEREF) {
-    distill_op(*op);
-    const RegType op1_reg = ensureReg(*op, true, avoidance);
+    const Operand base = base_op(op);
+    const RegType op1_reg = ensureReg(VAR(index), true, avoidance);
     reg_index = seizeReg(avoidance);
     print_save_load("lw", regsPool[reg_index], 0, op1_reg);
     // fix a bug
-    CHECK_FREE(index, *op); // this register may not need any more.
-    return helper_(true, reg_index);
+    // this register may not need any more, unless it has just been spilled for the value
+    if (regsPool[reg_index] != op1_reg) CHECK_FREE(index, &base);
+    return helper_(true, reg_index, base);
   }
   // reference or variable
-  if (kind == O_REFER)
-    distill_op(*op);
-  const RegType reg = ensureReg(*op, true, avoidance);
+  const Operand var = kind == O_REFER ? base_op(op) : *op;
+  const RegType reg = ensureReg(VAR(index), true, avoidance);
   reg_index = find_in_regs(reg);
   assert(reg_index != -1);
-  return helper_(false, reg_index);
+  return helper_(false, reg_index, var);
 #undef helper_
 }
 
@@ -513,8 +767,7 @@ static void printARG(const Code *code) {
 
   if (provider->kind == O_CONSTANT) {
     if (counter.arg < 4) {
-      const char courier[4];
-      snprintf(courier, sizeof(courier), "$a%d", counter.arg);
+      const RegType courier = argReg(counter.arg);
       if (!is_reg_empty(courier)) spillReg(courier);
       printLoadImm(courier, provider->value);
     } else {
@@ -530,16 +783,15 @@ static void printARG(const Code *code) {
   // fix: arguments can be deref type.
   RegHelper provider_helper;
   if (counter.arg < 4) {
-    const char courier[4];
-    snprintf(courier, sizeof(courier), "$a%d", counter.arg);
-    provider_helper = rightHelper(0, &provider, courier);
+    const RegType courier = argReg(counter.arg);
+    provider_helper = rightHelper(0, provider, courier);
     // const RegType reg = ensureReg(provider, true, courier);
     if (!is_reg_empty(courier)) spillReg(courier);
 
     assert(strcmp(courier, reg_(provider)) != 0);
     printBinary("move", courier, reg_(provider));
   } else {
-    provider_helper = rightHelper(0, &provider, NULL);
+    provider_helper = rightHelper(0, provider, NULL);
     adjustPtr(EXPAND, ELEM_SIZE);
     print_save_load("sw", reg_(provider), frameOffset, "$fp");
   }
@@ -558,7 +810,7 @@ static void printRETURN(const Code *code) {
     printLoadImm(courier, provider->value);
   } else {
     // fix: the provider can be deref type.
-    const RegHelper provider_helper = rightHelper(0, &provider, courier);
+    const RegHelper provider_helper = rightHelper(0, provider, courier);
     if (!is_reg_empty(courier)) spillReg(courier);
     printBinary("move", courier, reg_(provider));
     free_reg_helper(0, provider);
@@ -588,24 +840,26 @@ static void printInvoke(const Code *code) {
   // guarantee that all argument register is empty
   for (int i = 0; i < counter.arg; ++i) {
     if (i >= 4) break;
-    const char courier[4];
-    snprintf(courier, sizeof(courier), "$a%d", i);
+    const RegType courier = argReg(i);
     assert(is_reg_empty(courier));
   }
 #endif
 
   // pretend to flush all registers while leaving registers(deque) untouched
   fake_flush_restore('s', NULL);
+  keepAcrossCall('s');
   // for now, all registers' value is in memory.
-  printUnary("jal", invoke->value_s);
+  printUnary("jal", internedStr(invoke->name));
 
   /* note:
    *  use `adoptReg` rather than `printBinary("move", result_reg, "$v0");`,
        because the result operand will be refreshed anyway.
    *  adoptReg` doesn't cause a spill, as everything has already been spilled beforehand. */
-  adoptReg("$v0", false, result);
+  adoptReg("$v0", false, VAR(0));
   // $v0 has already been adopted, so no need to restore
   fake_flush_restore('l', "$v0");
+  keepAcrossCall('l');
+  CALLS++;
   CHECK_FREE(0, result); // note: remember to free
 
   // recover space allocated for arguments
@@ -622,7 +876,7 @@ static void printREAD(const Code *code) {
   const RegType courier = "$v0";
   if (!is_reg_empty(courier)) spillReg(courier);
   printUnary("jal", "read");
-  adoptReg(courier, false, receiver);
+  adoptReg(courier, false, VAR(0));
   CHECK_FREE(0, receiver); // note: remember to free
 }
 #undef is_addr_descriptor_valid
@@ -644,14 +898,17 @@ static void leftHelper(const int kind, const Operand *result, ...) {
   va_list regs;
   va_start(regs, kind == C_ASSIGN ? 1 : 2);
 
+  // the temporary holding the address, if result is dereferenced
+  const Operand base = base_op(result);
   if (kind == C_ASSIGN) {
     const RegType right_reg = va_arg(regs, RegType);
     if (result->kind == O_DEREF) {
-      distill_op(result);
-      const RegType result_reg = ensureReg(result, false, NULL);
+      // the address is read, keep away from the value which may be freed already
+      result = &base;
+      const RegType result_reg = ensureReg(VAR(0), true, right_reg);
       print_save_load("sw", right_reg, 0, result_reg);
     } else {
-      const RegType result_reg = ensureReg(result, false, NULL);
+      const RegType result_reg = ensureReg(VAR(0), false, NULL);
       printBinary("move", result_reg, right_reg);
     }
     CHECK_FREE(0, result);
@@ -662,7 +919,7 @@ static void leftHelper(const int kind, const Operand *result, ...) {
   if (result->kind == O_DEREF) {
     index = seizeReg(NULL);
   } else {
-    const RegType result_reg = ensureReg(result, false, NULL);
+    const RegType result_reg = ensureReg(VAR(0), false, NULL);
     index = find_in_regs(result_reg);
     assert(index != -1);
   }
@@ -686,8 +943,8 @@ static void leftHelper(const int kind, const Operand *result, ...) {
 
   if (result->kind == O_DEREF) {
     removeReg(index);
-    distill_op(result);
-    const RegType result_reg = ensureReg(result, false, NULL);
+    result = &base;
+    const RegType result_reg = ensureReg(VAR(0), true, regsPool[index]);
     print_save_load("sw", regsPool[index], 0, result_reg);
   }
   CHECK_FREE(0, result);
@@ -706,13 +963,13 @@ static void printASSIGN(const Code *code) {
    * single `li`. */
   if (right->kind == O_CONSTANT &&
       either(left->kind, O_VARIABLE, O_TEM_VAR)) {
-    const RegType left_reg = ensureReg(left, false, NULL);
+    const RegType left_reg = ensureReg(VAR(0), false, NULL);
     printLoadImm(left_reg, right->value);
     CHECK_FREE(0, left);
     return;
   }
 
-  const RegHelper right_helper = rightHelper(1, &right, NULL);
+  const RegHelper right_helper = rightHelper(1, right, NULL);
   free_reg_helper(1, right);
 
   leftHelper(C_ASSIGN, left, reg_(right));
@@ -727,17 +984,20 @@ static void printAddI(const Code *code) {
   // fix: the index for use_info should also be updated
   int index = 1; // assume the first operand isn't constant
   if (op1->kind == O_CONSTANT) {
-    SWAP(op1, op2, sizeof(Operand));
+    // swap the pointers only, the code itself is left untouched
+    const Operand *tmp = op1;
+    op1 = op2;
+    op2 = tmp;
     index = 2;
   }
 
-  const RegHelper op1_helper = rightHelper(index, &op1, NULL);
+  const RegHelper op1_helper = rightHelper(index, op1, NULL);
   free_reg_helper(index, op1);
 
   const Operand *result = &code->as.binary.result;
-  const RegType imme = int2String(op2->value);
+  char imme[12];
+  formatInt(imme, op2->value);
   leftHelper(C_ADD, result, reg_(op1), imme);
-  free((void *) imme);
 }
 
 static void printArithmatic(const Code *code) {
@@ -752,14 +1012,14 @@ static void printArithmatic(const Code *code) {
     return printAddI(code);
 
   // fix: what if two operands are the same?
-  const bool same = cmp_operand(&op1, &op2) == 0;
-  const RegHelper op1_helper = rightHelper(1, &op1, NULL);
+  const bool same = cmp_operand(op1, op2) == 0;
+  const RegHelper op1_helper = rightHelper(1, op1, NULL);
   free_reg_helper(1, op1);
   RegHelper op2_helper;
   if (same) {
     op2_helper.reg_index = op1_helper.reg_index;
   } else {
-    op2_helper = rightHelper(2, &op2, reg_(op1));
+    op2_helper = rightHelper(2, op2, reg_(op1));
     free_reg_helper(2, op2);
   }
 
@@ -770,38 +1030,37 @@ static void printArithmatic(const Code *code) {
 
 static void printIFGOTO(const Code *code) {
   assert(code->kind == C_IFGOTO);
-#define elem(s, m) { #s, #m }
-  const struct {
-    const char *symbol;
-    const char *mnemonic;
-  } map[] = {
-        elem(==, beq), elem(!=, bne), elem(>, bgt),
-        elem(<, blt), elem(>=, bge), elem(<=, ble),
-      };
-#undef elem
-  const char *relation = code->as.ternary.relation;
-  const int index = findInArray(&relation, false, map,
-                                ARRAY_LEN(map), sizeof(map[0]), cmp_str);
-  assert(index != -1);
+  static const char *const mnemonic[] = {
+    [REL_EQ] = "beq", [REL_NE] = "bne", [REL_LT] = "blt",
+    [REL_LE] = "ble", [REL_GT] = "bgt", [REL_GE] = "bge",
+  };
+  const Relop relation = code->as.ternary.relation;
   // fix: same problem with printArithmatic, two operands may be the same
   const Operand *x = &code->as.ternary.x;
   const Operand *y = &code->as.ternary.y;
-  const bool same = cmp_operand(&x, &y) == 0;
+  const bool same = cmp_operand(x, y) == 0;
 
-  const RegHelper x_helper = rightHelper(0, &x, NULL);
+  const RegHelper x_helper = rightHelper(0, x, NULL);
   free_reg_helper(0, x);
 
   RegHelper y_helper;
   if (same) {
     y_helper.reg_index = x_helper.reg_index;
   } else {
-    y_helper = rightHelper(1, &y, reg_(x));
+    y_helper = rightHelper(1, y, reg_(x));
     free_reg_helper(1, y);
   }
 
-  char label[16];
-  snprintf(label, sizeof(label), "label%d", code->as.ternary.label.var_no);
-  printTernary(map[index].mnemonic, reg_(x), reg_(y), label);
+  const int label = code->as.ternary.label.var_no;
+  storeLiveIn(&BLOCKS->container[getLabelBlock(BLOCKS, label)]);
+  leavePlaced();
+  emitMnemonic(mnemonic[relation]);
+  emit(reg_(x));
+  emit(", ");
+  emit(reg_(y));
+  emit(", label");
+  emitInt(label);
+  emitChar('\n');
 }
 
 static void printWRITE(const Code *code) {
@@ -817,7 +1076,7 @@ static void printWRITE(const Code *code) {
     /* note: there exists a case that provider's register happens to be courier.
      *  This register will be spilled within `ensureReg` which will be called
      *  inside `rightHelper` . */
-    const RegHelper provider_helper = rightHelper(0, &provider, courier);
+    const RegHelper provider_helper = rightHelper(0, provider, courier);
     assert(strcmp(courier, reg_(provider)) != 0);
     if (!is_reg_empty(courier)) spillReg(courier);
     printBinary("move", courier, reg_(provider));
@@ -831,21 +1090,28 @@ static void printWRITE(const Code *code) {
 
 static void printLABEL(const Code *code) {
   assert(code->kind == C_LABEL);
-  fprintf(f, "label%d:\n", code->as.unary.var_no);
+  emit("label");
+  emitInt(code->as.unary.var_no);
+  emit(":\n");
+  loadPlaced();
 }
 
 static void printGOTO(const Code *code) {
   assert(code->kind == C_GOTO);
-  char buffer[16];
-  snprintf(buffer, sizeof(buffer), "label%d", code->as.unary.var_no);
-  printUnary("j", buffer);
+  storeLiveIn(&BLOCKS->container[getLabelBlock(BLOCKS, code->as.unary.var_no)]);
+  leavePlaced();
+  emitMnemonic("j");
+  emit("label");
+  emitInt(code->as.unary.var_no);
+  emitChar('\n');
 }
 
 static void printDEC(const Code *code) {
   assert(code->kind == C_DEC);
   const Operand *op = &code->as.dec.target;
-  const RegType dec = ensureReg(op, false, NULL);
-  printBinary("move", dec, "$sp");
+  const RegType dec = ensureReg(VAR(0), false, NULL);
+  // the variable holds the address of its own space, which never overlaps the others
+  printAddImm(dec, "$fp", getAddrDescriptor(VAR(0))->storage);
   CHECK_FREE(0, op);
 }
 
@@ -864,48 +1130,39 @@ static void print(const Code *code) {
 #undef elem
 }
 
-#define begin_kind(basic) basic->begin->code.kind
+#define begin_kind(basic) codeAt(block->list, (basic)->begin)->kind
 
-// garner all variables within the current function block
-static void initialize(const Block *block, int current) {
-#define size(cnt) (sizeof(Operand *) * (cnt))
+// take all variables within the current function block
+static void initialize(const Block *block, const int current) {
   assert(current < block->cnt);
   // only redirect `variables` pointer for new function scope
   const BasicBlock *basic = block->container + current;
   assert(begin_kind(basic) == C_FUNCTION);
 
   assert(variables == NULL && addr_descriptors == NULL);
-  CNT = basic->cnt;
-  variables = malloc(size(CNT));
-  memcpy(variables, basic->variables, size(CNT));
-
-  while (++current < block->cnt) {
-    const BasicBlock *b = block->container + current;
-    if (begin_kind(b) == C_FUNCTION) break;
-
-    variables = realloc(variables, size(CNT + b->cnt));
-    memcpy(variables + CNT, b->variables, size(b->cnt));
-    CNT += b->cnt;
-
-    qsort(variables, CNT, sizeof(Operand *), cmp_operand);
-    removeDuplicates(variables, &CNT, sizeof(Operand *), cmp_operand);
-  }
+  const Function *function = &block->functions[basic->function];
+  CNT = function->cnt;
+  variables = function->variables;
 
   // initialize address descriptor
   addr_descriptors = malloc(sizeof(AddrDescriptor) * CNT);
-#undef size
 }
 
 static void printFUNCTION(const Block *block, const int index) {
   // fixme track all array sizes
   assert(index < block->cnt);
-  const Chunk *chunk = block->container[index].begin;
-  const Code *code = &chunk->code;
+  const CodeList *list = block->list;
+  const CodeIndex begin = block->container[index].begin;
+  const Code *code = codeAt(list, begin);
   assert(code->kind == C_FUNCTION);
   // initialize variables and address descriptor
   initialize(block, index);
+  if (ALLOCATOR == ALLOC_LINEAR_SCAN)
+    ALLOCATION = allocateRegisters(block, block->container[index].function, ARRAY_LEN(placeable));
+  CALLS = 0;
 
-  fprintf(f, "%s:\n", code->as.unary.value_s);
+  emit(internedStr(code->as.unary.name));
+  emit(":\n");
 
   frameOffset = 0;
   adjustPtr(EXPAND, 2 * ELEM_SIZE); // Offset.frameOffset will be changed to -4
@@ -917,22 +1174,25 @@ static void printFUNCTION(const Block *block, const int index) {
   for (int i = 0; i < CNT; ++i) {
     AddrDescriptor *ad = addr_descriptors + i;
     ad->offset = frameOffset - (i + 1) * ELEM_SIZE;
+    ad->storage = 0;
     ad->reg_index = -1;
+    ad->dirty = false;
+    ad->clean_in = -1;
   }
   adjustPtr(EXPAND, CNT * ELEM_SIZE);
 
   // loop through code to allocate space for arrays
-  const Chunk *c = chunk->next;
-  while (c != chunk && c->code.kind != C_FUNCTION) {
-    const Code *code_ = &c->code;
+  CodeIndex i = nextCode(list, begin);
+  while (i != CODE_SENTINEL && codeAt(list, i)->kind != C_FUNCTION) {
+    const Code *code_ = codeAt(list, i);
     if (code_->kind == C_DEC) {
-      const Operand *op = &code_->as.dec.target;
       adjustPtr(EXPAND, code_->as.dec.size);
-      AddrDescriptor *ad = getAddrDescriptor(op);
-      ad->offset = frameOffset;
+      // the target is the first operand
+      AddrDescriptor *ad = getAddrDescriptor(block->numbers[3 * i]);
+      ad->storage = frameOffset;
       assert(ad->reg_index == -1);
     }
-    c = c->next;
+    i = nextCode(list, i);
   }
   counter.param = counter.arg = 0;
 }
@@ -942,8 +1202,19 @@ static void printFUNCTION(const Block *block, const int index) {
 // and remove begin_kind
 static void finalize(const Block *block, const int current) {
   assert(current < block->cnt);
-  // after each basic block, all registers are empty.
-  assert(all_regs_empty());
+  const BasicBlock *basic = block->container + current, *next = NULL;
+  for (int i = 0; i < basic->succ_cnt; ++i) {
+    if (basic->succ[i] == current + 1) next = basic + 1; // falls through
+  }
+  if (next != NULL && (next->pred_cnt > 1 || ALLOCATION != NULL)) {
+    storeLiveIn(next);
+    next = NULL;
+  }
+  // a jump has stored them already
+  if (!either(codeAt(block->list, basic->end)->kind, C_GOTO, C_IFGOTO)) leavePlaced();
+  releaseRegs(next);
+  // after each basic block, all registers are empty, unless they are handed over.
+  assert(next != NULL || all_regs_empty());
   if (current != block->cnt - 1) {
     const BasicBlock *next_basic = block->container + current + 1;
     if (begin_kind(next_basic) != C_FUNCTION) return;
@@ -951,24 +1222,32 @@ static void finalize(const Block *block, const int current) {
 
   assert(variables != NULL && addr_descriptors != NULL);
 #ifdef LOCAL
-  fprintf(f, "# -- FINALIZE\n");
+  emit("# -- FINALIZE\n");
 #endif
 
-  free(variables);
   variables = NULL;
   free(addr_descriptors);
   addr_descriptors = NULL;
+  if (ALLOCATION != NULL) {
+    assert(CALLS == ALLOCATION->call_cnt);
+    freeAllocation(ALLOCATION);
+    ALLOCATION = NULL;
+  }
 }
 #undef begin_kind
 
 static void init_MIPS();
 static void print_read_write();
 
-void printMIPS(const char *file_name, const Block *blocks) {
-  f = fopen(file_name, "w");
-  if (f == NULL) {
-    DEBUG_INFO("can't open file: %s.\n", file_name);
-    exit(EXIT_FAILURE);
+// @param file is left open, it can be a file or a memory stream
+void printMIPS(CompilerContext *ctx, FILE *file, const Block *blocks, const Allocator allocator) {
+  bindContext(ctx);
+  initDeque();
+  BLOCKS = blocks;
+  ALLOCATOR = allocator;
+  for (size_t i = 0; i < LEN; ++i) seizable[i] = allocator == ALLOC_FIFO || i < LEN - 4;
+  if (allocator == ALLOC_LINEAR_SCAN) {
+    for (size_t i = 0; i < ARRAY_LEN(placeable); ++i) seizable[placeable[i]] = false;
   }
 
   // note: remember to remove `const` keyword for `regsPool` if uncomment shuffle
@@ -983,15 +1262,19 @@ void printMIPS(const char *file_name, const Block *blocks) {
      * So it is necessary to spare a variable to keep track of it. */
     int info_index = 0;
 
-    const Chunk *chunk = basic->begin;
+    const CodeList *list = blocks->list;
+    CURRENT = i;
+    // a label loads them after itself
+    if (codeAt(list, basic->begin)->kind != C_LABEL) loadPlaced();
+    const CodeIndex stop = nextCode(list, basic->end);
     // loop through each line of code
-    while (chunk != basic->end->next) {
-      const Code *code = &chunk->code;
+    for (CodeIndex c = basic->begin; c != stop; c = nextCode(list, c)) {
+      const Code *code = codeAt(list, c);
       const int kind = code->kind;
-      if (kind == C_FUNCTION) fprintf(f, "\n");
+      if (kind == C_FUNCTION) emitChar('\n');
 #ifdef LOCAL
-      fprintf(f, "# ");
-      printCode(f, code);
+      emit("# ");
+      emitCode(code);
 #endif
       if (in(kind, EFFECTIVE_CODE)) {
         // only increment the 'info_index' if it is effective code.
@@ -999,50 +1282,66 @@ void printMIPS(const char *file_name, const Block *blocks) {
       }
       if (kind == C_FUNCTION) printFUNCTION(blocks, i);
       else print(code);
-      chunk = chunk->next;
     }
     finalize(blocks, i);
   }
 
   print_read_write();
-  fclose(f);
+  flushOutput(file);
 }
 
 static void printUnary(const char *name, const RegType reg) {
-  fprintf(f, "%*s%-4s %s\n", INDENT, "", name, reg);
+  emitMnemonic(name);
+  emit(reg);
+  emitChar('\n');
 }
 
 static void printBinary(const char *name, const RegType reg1, const RegType reg2) {
-  fprintf(f, "%*s%-4s %s, %s\n", INDENT, "", name, reg1, reg2);
+  emitMnemonic(name);
+  emit(reg1);
+  emit(", ");
+  emit(reg2);
+  emitChar('\n');
 }
 
 static void printTernary(const char *name, const RegType result,
                          const RegType reg1, const RegType reg2) {
-  fprintf(f, "%*s%-4s %s, %s, %s\n", INDENT, "", name, result, reg1, reg2);
+  emitMnemonic(name);
+  emit(result);
+  emit(", ");
+  emit(reg1);
+  emit(", ");
+  emit(reg2);
+  emitChar('\n');
+}
+
+static void printSyscall() {
+  emitIndent();
+  emit("syscall\n");
 }
 
 static void print_read_write() {
-  fprintf(f, "\nread:\n");
+  emit("\nread:\n");
   printBinary("addi", "$sp", "$sp, -4");
   print_save_load("sw", "$a0", 0, "$sp");
   printLoadImm("$v0", 4);
   printBinary("la", "$a0", "_prompt");
-  fprintf(f, "%*ssyscall\n",INDENT, "");
+  printSyscall();
   printLoadImm("$v0", 5);
-  fprintf(f, "%*ssyscall\n",INDENT, "");
+  printSyscall();
   print_save_load("lw", "$a0", 0, "$sp");
   printTernary("addi", "$sp", "$sp", "4");
   printUnary("jr", "$ra");
 
-  fprintf(f, "\nwrite:\n");
+  emit("\nwrite:\n");
   printTernary("addi", "$sp", "$sp", "-8");
   print_save_load("sw", "$v0", 4, "$sp");
   print_save_load("sw", "$a0", 0, "$sp");
   printLoadImm("$v0", 1);
-  fprintf(f, "%*ssyscall\n",INDENT, "");
+  printSyscall();
   printLoadImm("$v0", 4);
   printBinary("la", "$a0", "_ret");
-  fprintf(f, "%*ssyscall\n",INDENT, "");
+  printSyscall();
   // "move $v0, $0" don't care about return value at all
   print_save_load("lw", "$v0", 4, "$sp");
   print_save_load("lw", "$a0", 0, "$sp");
@@ -1051,18 +1350,18 @@ static void print_read_write() {
 }
 
 static void init_MIPS() {
-  fprintf(f, ".data\n");
-  fprintf(f, "_prompt: .asciiz \"Enter an integer:\"\n");
-  fprintf(f, "_ret: .asciiz \"\\n\"\n");
-  fprintf(f, ".globl __start\n");
-  fprintf(f, ".text\n\n");
+  emit(".data\n");
+  emit("_prompt: .asciiz \"Enter an integer:\"\n");
+  emit("_ret: .asciiz \"\\n\"\n");
+  emit(".globl __start\n");
+  emit(".text\n\n");
 
-  fprintf(f, "__start:\n");
+  emit("__start:\n");
   printUnary("jal", "main");
   printBinary("li", "$v0", "10");
-  fprintf(f, "%*ssyscall\n",INDENT, "");
+  printSyscall();
 #ifdef LOCAL
-  fprintf(f, "# END initialization\n");
+  emit("# END initialization\n");
 #endif
 }
 #undef CHECK_FREE
@@ -10,6 +10,12 @@
 #include "utils.h"
 #endif
 
-void printMIPS(const char *file_name, const Block *blocks);
+// how the registers of a function are allocated
+typedef enum {
+  ALLOC_FIFO,        // within a block, the register held longest is spilled first
+  ALLOC_LINEAR_SCAN, // over the live intervals of the whole function, see `LinearScan.h`
+} Allocator;
+
+void printMIPS(CompilerContext *ctx, FILE *out, const Block *blocks, Allocator allocator);
 
 #endif
@@ -4,13 +4,15 @@
 #include "Optimize.h"
 #endif
 
-typedef struct {
-  size_t len;
-  use_info *use;
-} UseInfoTable;
+#include <limits.h>
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
 
 extern const uint8_t operand_count_per_code[];
-int cmp_use_info(const void *u1, const void *u2);
 /* print code is only for debug purpose, so declare it as
  `extern` rather than add it in the header file. */
 
@@ -21,66 +23,78 @@ int cmp_use_info(const void *u1, const void *u2);
  * LABEL label1           |
  * </pre>
  */
-static void flipCondition(const Chunk *sentinel) {
-  Chunk *chunk = (Chunk *) sentinel;
-  while (chunk->next != sentinel) {
-    chunk = chunk->next;
-
-    Code *c = &chunk->code;
+static void flipCondition(CodeList *list) {
+  for (CodeIndex i = firstCode(list); i != CODE_SENTINEL; i = nextCode(list, i)) {
+    Code *c = codeAt(list, i);
     if (c->kind != C_IFGOTO) continue;
-    if (chunk->next->code.kind != C_GOTO) continue;
-    if (chunk->next->next->code.kind != C_LABEL) continue;
-    const Code *c2 = &chunk->next->next->code;
+    const CodeIndex goto_i = nextCode(list, i);
+    const Code *c1 = codeAt(list, goto_i);
+    if (c1->kind != C_GOTO) continue;
+    const Code *c2 = codeAt(list, nextCode(list, goto_i));
+    if (c2->kind != C_LABEL) continue;
     if (c->as.ternary.label.var_no != c2->as.unary.var_no) continue;
 
-    const int len = 6;
-    const char *flipList[] = {"==", "<", ">", "<=", ">=", "!="};
-    char **relation = &c->as.ternary.relation;
-    // search in flipList
-    const int index = findInArray(relation, false, flipList,
-                                  len, sizeof(char *), cmp_str);
-    free(*relation); // maybe cause free after use warning.
-    *relation = my_strdup(flipList[len - 1 - index]);
+    static const Relop negation[] = {
+      [REL_EQ] = REL_NE, [REL_NE] = REL_EQ, [REL_LT] = REL_GE,
+      [REL_LE] = REL_GT, [REL_GT] = REL_LE, [REL_GE] = REL_LT,
+    };
+    c->as.ternary.relation = negation[c->as.ternary.relation];
 
     // update IFGOTO label NO.
-    c->as.ternary.label.var_no = chunk->next->code.as.unary.var_no;
+    c->as.ternary.label.var_no = c1->as.unary.var_no;
     // remove the redundant 'GOTO' code
-    removeCode(chunk->next);
+    removeCode(list, goto_i);
+  }
+}
+
+// remove the GOTO whose label comes right after it
+static void deleteJumps(CodeList *list) {
+  CodeIndex i = firstCode(list);
+  while (i != CODE_SENTINEL) {
+    const Code *c = codeAt(list, i);
+    const CodeIndex current = i;
+    i = nextCode(list, i);
+    if (c->kind != C_GOTO) continue;
+    for (CodeIndex j = i; j != CODE_SENTINEL && codeAt(list, j)->kind == C_LABEL; j = nextCode(list, j)) {
+      if (codeAt(list, j)->as.unary.var_no != c->as.unary.var_no) continue;
+      removeCode(list, current);
+      break;
+    }
   }
 }
 
 // remove redundant labels
-static void deleteLabels(const Chunk *sentinel) {
+static void deleteLabels(CodeList *list) {
   // collect all labels referred by IFGOTO and GOTO
-  const Chunk *chunk = sentinel->next;
+  CodeIndex i = firstCode(list);
   int cnt = 0, capacity = 20;
   int *container = malloc(sizeof(int) * capacity);
-  while (chunk != sentinel) {
-    const Code *c = &chunk->code;
+  while (i != CODE_SENTINEL) {
+    const Code *c = codeAt(list, i);
     if (cnt >= capacity) goto RESIZE;
     if (c->kind == C_IFGOTO) {
       container[cnt++] = c->as.ternary.label.var_no;
     } else if (c->kind == C_GOTO) {
       container[cnt++] = c->as.unary.var_no;
     }
-    chunk = chunk->next;
+    i = nextCode(list, i);
     continue;
   RESIZE:
     RESIZE(capacity);
     container = realloc(container, sizeof(int) * capacity);
   }
   qsort(container, cnt, sizeof(int), cmp_int);
-  assert(chunk == sentinel);
   // loop through again to remove those redundant labels
-  chunk = chunk->next;
-  while (chunk != sentinel) {
-    const Code *c = &chunk->code;
-    chunk = chunk->next;
+  i = firstCode(list);
+  while (i != CODE_SENTINEL) {
+    const Code *c = codeAt(list, i);
+    const CodeIndex current = i;
+    i = nextCode(list, i);
     if (c->kind != C_LABEL) continue;
     if (findInArray(&c->as.unary.var_no, true, container,
                     cnt, sizeof(int), cmp_int) != -1)
       continue;
-    removeCode(chunk->prev);
+    removeCode(list, current);
   }
   free(container);
 }
@@ -93,6 +107,27 @@ static void organizeOpSequence(Code *c) {
   c->as.binary.op2.value = -c->as.binary.op2.value;
 }
 
+// @return false if the quotient is undefined, the others wrap around as on MIPS
+static bool calculate(const int kind, const int x, const int y, int *result) {
+  switch (kind) {
+    case C_ADD:
+      *result = (int) ((unsigned) x + (unsigned) y);
+      return true;
+    case C_SUB:
+      *result = (int) ((unsigned) x - (unsigned) y);
+      return true;
+    case C_MUL:
+      *result = (int) ((unsigned) x * (unsigned) y);
+      return true;
+    case C_DIV:
+      if (y == 0 || (x == INT_MIN && y == -1)) return false;
+      *result = x / y;
+      return true;
+    default:
+      return false;
+  }
+}
+
 // merge (#1 + #2) into (#3)
 static void foldConstant(Code *c) {
   if (!in(c->kind, 4, C_ADD, C_SUB, C_MUL, C_DIV))
@@ -104,224 +139,974 @@ static void foldConstant(Code *c) {
     return;
 
   int *right = &c->as.assign.right.value;
-  if (c->kind == C_ADD)
-    *right = op1->value + op2->value;
-  else if (c->kind == C_SUB)
-    *right = op1->value - op2->value;
-  else if (c->kind == C_MUL)
-    *right = op1->value * op2->value;
-  else if (c->kind == C_DIV)
-    *right = op1->value / op2->value;
+  if (!calculate(c->kind, op1->value, op2->value, right))
+    return;
   // no need to change assign.left because it aligns with binary.result
   c->kind = C_ASSIGN;
 }
 
-///// Blocks ///////////////////////////////////////////////
+// change (op + #0), (op * #1) and the like into (op)
+static void dropIdentity(Code *c) {
+  if (!in(c->kind, 4, C_ADD, C_SUB, C_MUL, C_DIV))
+    return;
+
+  const Operand *op1 = &c->as.binary.op1;
+  const Operand *op2 = &c->as.binary.op2;
+  const int identity = either(c->kind, C_ADD, C_SUB) ? 0 : 1;
+  Operand right;
+  if (op2->kind == O_CONSTANT && op2->value == identity)
+    right = *op1;
+  else if (either(c->kind, C_ADD, C_MUL) && op1->kind == O_CONSTANT && op1->value == identity)
+    right = *op2;
+  else
+    return;
+  c->kind = C_ASSIGN;
+  c->as.assign.right = right;
+}
+
+///// Constant propagation /////////////////////////////////
+
+/* sparse conditional constant propagation, one function at a time.
+ * the IR isn't in SSA form, so an operand is linked to the definition before it in
+ * its block, or in the blocks above it while each has a single predecessor, or else to
+ * every definition that leaves a block, which covers all the definitions reaching it.
+ * values only go down the lattice, so each code is revisited at most twice per operand,
+ * and a block is only visited once a branch reaches it.
+ * @note a variable read before it is assigned is undefined in C--, so it is taken
+ * as any value, the constant of the other definitions included. a branch still undefined
+ * when nothing is left to visit may go either way, both of its edges are reached then. */
+
+typedef struct {
+  enum { UNDEF, CONST, OVERDEF } state;
+  int value;
+} Lattice;
+
+#define SITE(pos, slot) ((pos) * 3 + (slot))
+
+typedef struct {
+  CodeList *list;
+  CodeIndex *codes;   // the codes of the function, a code is known by its position here
+  int len;
+  int *block_of;      // of each code
+  int *block_begin;   // the first code of each block, one more entry for the end
+  int block_cnt;
+  bool *reachable;    // of each block
+  int *labels;        // pairs of label number and block, sorted by label
+  int label_cnt;
+  int *pred, *pred_cnt; // of each block, pred is the last predecessor found
+
+  Operand *vars;      // the temporaries and variables, in the order they are seen
+  int var_cnt;
+  int *slots, slot_cnt; // open addressing from a variable to its number
+  int *var_of;        // the variable each code defines, -1 if none
+  bool *leaves;       // the definition is the last one of its variable in its block
+  Lattice *def;       // the value each code defines
+  Lattice *var;       // the meet of the definitions that leave their blocks
+  int *site_var;      // of each operand site, -1 if it reads no variable
+  int *src;           // the code in the same block that defines the site, -1 if none
+  int *use_next;      // the next site reading the same definition or variable
+  int *def_uses;      // the first site reading each definition
+  int *var_uses;      // the first site reading each variable from another block
+
+  int *stack, top;
+  bool *queued;
+} Propagation;
+
+static bool compare(const Relop relation, const int x, const int y) {
+  switch (relation) {
+    case REL_EQ: return x == y;
+    case REL_NE: return x != y;
+    case REL_LT: return x < y;
+    case REL_LE: return x <= y;
+    case REL_GT: return x > y;
+    case REL_GE: return x >= y;
+    default: return false;
+  }
+}
+
+// @return whether the first operand of code is the temporary or variable it assigns
+static bool definesFirst(const Code *code) {
+  switch (code->kind) {
+    case C_ASSIGN: case C_ADD: case C_SUB: case C_MUL: case C_DIV: case C_READ: case C_PARAM:
+      return either(code->as.unary.kind, O_TEM_VAR, O_VARIABLE);
+    default:
+      return false;
+  }
+}
+
+// the number of leading operands that may read a variable
+static int readingCount(const Code *code) {
+  switch (code->kind) {
+    case C_FUNCTION: case C_LABEL: case C_GOTO: case C_DEC:
+      return 0;
+    case C_IFGOTO:
+      return 2;
+    default:
+      return operand_count_per_code[code->kind];
+  }
+}
+
+// the temporary or variable whose value op reads, a reference only reads an address
+static bool readVar(const Operand *op, Operand *var) {
+  if (op->kind == O_DEREF) *var = base_op(op);
+  else if (either(op->kind, O_TEM_VAR, O_VARIABLE)) *var = *op;
+  else return false;
+  return true;
+}
+
+// the first slot to probe in an open addressing table of mask + 1 slots
+static size_t hashPair(const int a, const int b, const size_t mask) {
+  const uint64_t key = (uint64_t) (uint32_t) a << 32 | (uint32_t) b;
+  return (key * 0x9E3779B97F4A7C15u) >> 32 & mask;
+}
+
+// the number of var in the function, the first time a variable is seen it gets the next one
+static int numberVar(Propagation *p, const Operand *var) {
+  const size_t mask = p->slot_cnt - 1;
+  size_t i = hashPair(var->kind, var->var_no, mask);
+  while (p->slots[i] != -1) {
+    const Operand *seen = &p->vars[p->slots[i]];
+    if (seen->kind == var->kind && seen->var_no == var->var_no) return p->slots[i];
+    i = (i + 1) & mask;
+  }
+  p->vars[p->var_cnt] = *var;
+  return p->slots[i] = p->var_cnt++;
+}
+
+static Lattice siteValue(const Propagation *p, const int pos, const int slot, const Operand *op) {
+  if (op->kind == O_CONSTANT) return (Lattice){.state = CONST, .value = op->value};
+  if (!either(op->kind, O_TEM_VAR, O_VARIABLE)) return (Lattice){.state = OVERDEF};
+  const int site = SITE(pos, slot);
+  return p->src[site] != -1 ? p->def[p->src[site]] : p->var[p->site_var[site]];
+}
+
+// move l down to its meet with value, @return true if l has changed
+static bool lower(Lattice *l, const Lattice value) {
+  if (l->state == OVERDEF || value.state == UNDEF) return false;
+  if (l->state == CONST && value.state == CONST && l->value == value.value) return false;
+  *l = l->state == UNDEF ? value : (Lattice){.state = OVERDEF};
+  return true;
+}
+
+// the value code assigns, or the outcome of its condition, 1 for true
+static Lattice evaluate(const Propagation *p, const int pos, const Code *code) {
+  if (code->kind == C_ASSIGN) return siteValue(p, pos, 1, &code->as.assign.right);
+  if (!in(code->kind, 5, C_ADD, C_SUB, C_MUL, C_DIV, C_IFGOTO)) return (Lattice){.state = OVERDEF};
+
+  const bool is_if = code->kind == C_IFGOTO;
+  const Lattice x = is_if ? siteValue(p, pos, 0, &code->as.ternary.x) : siteValue(p, pos, 1, &code->as.binary.op1);
+  const Lattice y = is_if ? siteValue(p, pos, 1, &code->as.ternary.y) : siteValue(p, pos, 2, &code->as.binary.op2);
+  if (x.state == OVERDEF || y.state == OVERDEF) return (Lattice){.state = OVERDEF};
+  if (x.state == UNDEF || y.state == UNDEF) return (Lattice){.state = UNDEF};
+  Lattice result = {.state = CONST};
+  if (is_if) result.value = compare(code->as.ternary.relation, x.value, y.value);
+  else if (!calculate(code->kind, x.value, y.value, &result.value)) result.state = OVERDEF;
+  return result;
+}
+
+static void push(Propagation *p, const int pos) {
+  if (p->queued[pos]) return;
+  p->queued[pos] = true;
+  p->stack[p->top++] = pos;
+}
+
+static void pushReaders(Propagation *p, int site) {
+  for (; site != -1; site = p->use_next[site]) {
+    const int pos = site / 3;
+    if (p->reachable[p->block_of[pos]]) push(p, pos);
+  }
+}
+
+static void reach(Propagation *p, const int block) {
+  if (block >= p->block_cnt || p->reachable[block]) return;
+  p->reachable[block] = true;
+  for (int pos = p->block_begin[block]; pos < p->block_begin[block + 1]; ++pos) push(p, pos);
+}
+
+static int blockOfLabel(const Propagation *p, const int label) {
+  const int *found = bsearch(&label, p->labels, p->label_cnt, sizeof(int) * 2, cmp_int);
+  assert(found != NULL);
+  return found[1];
+}
+
+static void visit(Propagation *p, const int pos) {
+  const Code *code = codeAt(p->list, p->codes[pos]);
+  const int v = p->var_of[pos];
+  if (v != -1 && lower(&p->def[pos], evaluate(p, pos, code))) {
+    pushReaders(p, p->def_uses[pos]);
+    if (p->leaves[pos] && lower(&p->var[v], p->def[pos])) pushReaders(p, p->var_uses[v]);
+  }
+
+  const int block = p->block_of[pos];
+  if (pos != p->block_begin[block + 1] - 1) return;
+  if (code->kind == C_GOTO) {
+    reach(p, blockOfLabel(p, code->as.unary.var_no));
+  } else if (code->kind == C_IFGOTO) {
+    const Lattice condition = evaluate(p, pos, code);
+    if (condition.state == UNDEF) return;
+    if (condition.state == OVERDEF || condition.value)
+      reach(p, blockOfLabel(p, code->as.ternary.label.var_no));
+    if (condition.state == OVERDEF || !condition.value)
+      reach(p, block + 1);
+  } else if (code->kind != C_RETURN) {
+    reach(p, block + 1);
+  }
+}
+
+// reach both edges of every branch still undefined, @return whether there is more to visit
+static bool reachUndecided(Propagation *p) {
+  for (int block = 0; block < p->block_cnt; ++block) {
+    const int pos = p->block_begin[block + 1] - 1;
+    const Code *code = codeAt(p->list, p->codes[pos]);
+    if (!p->reachable[block] || code->kind != C_IFGOTO || evaluate(p, pos, code).state != UNDEF)
+      continue;
+    reach(p, blockOfLabel(p, code->as.ternary.label.var_no));
+    reach(p, block + 1);
+  }
+  return p->top > 0;
+}
+
+static void addEdge(Propagation *p, const int from, const int to) {
+  if (to >= p->block_cnt) return;
+  p->pred_cnt[to]++;
+  p->pred[to] = from;
+}
+
+// split the function into blocks, link them and number the variables
+static void splitFunction(Propagation *p) {
+  p->vars = malloc(sizeof(Operand) * SITE(p->len, 0));
+  p->var_cnt = p->block_cnt = p->label_cnt = 0;
+  // at least twice as many slots as variables
+  for (p->slot_cnt = 16; p->slot_cnt < 2 * SITE(p->len, 0); p->slot_cnt *= 2) {}
+  p->slots = malloc(sizeof(int) * p->slot_cnt);
+  memset(p->slots, -1, sizeof(int) * p->slot_cnt);
+  for (int pos = 0; pos < p->len; ++pos) {
+    const Code *code = codeAt(p->list, p->codes[pos]);
+    const int prev = pos == 0 ? C_FUNCTION : codeAt(p->list, p->codes[pos - 1])->kind;
+    if (pos == 0 || code->kind == C_LABEL || prev == C_GOTO || prev == C_IFGOTO || prev == C_RETURN)
+      p->block_begin[p->block_cnt++] = pos;
+    p->block_of[pos] = p->block_cnt - 1;
+    if (code->kind == C_LABEL) {
+      p->labels[2 * p->label_cnt] = code->as.unary.var_no;
+      p->labels[2 * p->label_cnt++ + 1] = p->block_cnt - 1;
+    }
+    const bool defines = definesFirst(code);
+    const int reading_cnt = readingCount(code);
+    for (int slot = 0; slot < 3; ++slot) {
+      Operand var;
+      const int site = SITE(pos, slot);
+      p->site_var[site] = -1;
+      if (slot >= defines && slot < reading_cnt && readVar((const Operand *) &code->as + slot, &var))
+        p->site_var[site] = numberVar(p, &var);
+    }
+    p->var_of[pos] = defines ? numberVar(p, &code->as.unary) : -1;
+  }
+  p->block_begin[p->block_cnt] = p->len;
+  qsort(p->labels, p->label_cnt, sizeof(int) * 2, cmp_int);
+  free(p->slots);
+
+  for (int block = 0; block < p->block_cnt; ++block) {
+    p->pred_cnt[block] = block == 0; // the entry of the function
+    p->pred[block] = -1;
+  }
+  for (int block = 0; block < p->block_cnt; ++block) {
+    const Code *last = codeAt(p->list, p->codes[p->block_begin[block + 1] - 1]);
+    if (last->kind == C_GOTO) {
+      addEdge(p, block, blockOfLabel(p, last->as.unary.var_no));
+    } else if (last->kind == C_IFGOTO) {
+      addEdge(p, block, blockOfLabel(p, last->as.ternary.label.var_no));
+      addEdge(p, block, block + 1);
+    } else if (last->kind != C_RETURN) {
+      addEdge(p, block, block + 1);
+    }
+  }
+}
 
 /**
- * @brief create a use-info table which contains the use_info of variables <b>"in order"</b>
- * for each basic block
- * @return a use-info table.
- * <p>
- * helper function of `setBasicBlock`
+ * @brief the only definition of v that reaches the start of block: up through the blocks
+ * that have a single predecessor, the first definition found is the one.
+ * @return -1 if several definitions may reach
  */
-static UseInfoTable* createUseInfoTable(const BasicBlock *basic) {
-  UseInfoTable *table = malloc(sizeof(UseInfoTable));
-  size_t capacity = 5, *len = &table->len;
-  use_info **use = &table->use;
-  *len = 0;
-  *use = malloc(sizeof(use_info) * capacity);
+static int soleDefinition(const Propagation *p, const int *exits, const size_t mask,
+                          const int v, int block) {
+  for (int steps = 0; steps < p->block_cnt && p->pred_cnt[block] == 1 && p->pred[block] != -1; ++steps) {
+    block = p->pred[block];
+    for (size_t i = hashPair(v, block, mask); exits[i] != -1; i = (i + 1) & mask) {
+      if (p->var_of[exits[i]] == v && p->block_of[exits[i]] == block) return exits[i];
+    }
+  }
+  return -1;
+}
 
-  // loop from begging to end
-  const Chunk *chunk = basic->begin;
-  while (chunk != basic->end->next) {
-    const Code *code = &chunk->code;
-    chunk = chunk->next;
-    const int kind = code->kind;
-    if (!in(kind, EFFECTIVE_CODE)) continue;
+static void linkSite(Propagation *p, const int site, const int src) {
+  int *head = src != -1 ? &p->def_uses[src] : &p->var_uses[p->site_var[site]];
+  p->src[site] = src;
+  p->use_next[site] = *head;
+  *head = site;
+}
+
+// link every read to the definition before it in its block, or to those reaching the block
+static void linkFunction(Propagation *p) {
+  p->var = malloc(sizeof(Lattice) * p->var_cnt);
+  p->var_uses = malloc(sizeof(int) * p->var_cnt);
+  int *local_def = malloc(sizeof(int) * p->var_cnt);
+  int *local_block = malloc(sizeof(int) * p->var_cnt);
+  for (int v = 0; v < p->var_cnt; ++v) {
+    p->var[v] = (Lattice){.state = UNDEF};
+    p->var_uses[v] = local_block[v] = -1;
+  }
 
-    uint8_t op_cnt = operand_count_per_code[kind];
-    // the third operand for `C_IFGOTO` is label
-    if (kind == C_IFGOTO) op_cnt--;
+  for (int pos = 0; pos < p->len; ++pos) {
+    const int block = p->block_of[pos];
+    p->def[pos] = (Lattice){.state = UNDEF};
+    p->def_uses[pos] = -1;
+    for (int slot = 0; slot < 3; ++slot) {
+      const int site = SITE(pos, slot);
+      const int v = p->site_var[site];
+      p->src[site] = p->use_next[site] = -1;
+      if (v != -1 && local_block[v] == block) linkSite(p, site, local_def[v]);
+    }
+    const int v = p->var_of[pos];
+    if (v == -1) continue;
+    if (local_block[v] == block) p->leaves[local_def[v]] = false;
+    local_def[v] = pos;
+    local_block[v] = block;
+    p->leaves[pos] = true;
+  }
+  free(local_def);
+  free(local_block);
 
-    // iterate through all operands per code
-    for (int i = 0; i < op_cnt; ++i) {
-      const Operand *op = (Operand *) &code->as + i;
-      // ignore constant
-      if (!in(op->kind, EFFECTIVE_OP)) continue;
+  // the reads left come from other blocks, find the definitions leaving each block by hash
+  size_t slot_cnt = 16;
+  while (slot_cnt < 2 * (size_t) p->len) slot_cnt *= 2;
+  int *exits = malloc(sizeof(int) * slot_cnt);
+  memset(exits, -1, sizeof(int) * slot_cnt);
+  for (int pos = 0; pos < p->len; ++pos) {
+    if (p->var_of[pos] == -1 || !p->leaves[pos]) continue;
+    size_t i = hashPair(p->var_of[pos], p->block_of[pos], slot_cnt - 1);
+    while (exits[i] != -1) i = (i + 1) & (slot_cnt - 1);
+    exits[i] = pos;
+  }
+  for (int site = 0; site < SITE(p->len, 0); ++site) {
+    if (p->site_var[site] == -1 || p->src[site] != -1) continue;
+    linkSite(p, site, soleDefinition(p, exits, slot_cnt - 1, p->site_var[site], p->block_of[site / 3]));
+  }
+  free(exits);
+}
 
-      if (*len >= capacity) { //resize
-        RESIZE(capacity);
-        *use = realloc(*use, sizeof(use_info) * capacity);
+// put the constants into the codes, fold the branches decided and remove what is dead
+static void rewriteFunction(Propagation *p) {
+  // the sites still reading each definition, or each variable from another block
+  int *def_readers = calloc(p->len, sizeof(int));
+  int *var_readers = calloc(p->var_cnt, sizeof(int));
+  for (int pos = 0; pos < p->len; ++pos) {
+    Code *code = codeAt(p->list, p->codes[pos]);
+    if (!p->reachable[p->block_of[pos]]) {
+      // declarations are kept, so that the frame doesn't depend on reachability
+      if (code->kind != C_DEC) removeCode(p->list, p->codes[pos]);
+      continue;
+    }
+    for (int slot = 0; slot < 3; ++slot) {
+      const int site = SITE(pos, slot);
+      if (p->site_var[site] == -1) continue;
+      Operand *op = (Operand *) &code->as + slot;
+      const Lattice value = siteValue(p, pos, slot, op);
+      if (value.state == CONST) *op = (Operand){.kind = O_CONSTANT, .value = value.value};
+      else if (p->src[site] != -1) def_readers[p->src[site]]++;
+      else var_readers[p->site_var[site]]++;
+    }
+    if (code->kind == C_IFGOTO) {
+      const Lattice condition = evaluate(p, pos, code);
+      if (condition.state == CONST && condition.value) {
+        const Operand label = code->as.ternary.label;
+        *code = (Code){.kind = C_GOTO, .as.unary = label};
+      } else if (condition.state == CONST) {
+        removeCode(p->list, p->codes[pos]);
       }
-      (*use)[*len].in_use = false;
-      (*use)[(*len)++].op = op;
-      if (either(op->kind, O_REFER, O_DEREF))
-        distill_op((*use)[*len - 1].op);
     }
+    foldConstant(code);
+    organizeOpSequence(code);
+    dropIdentity(code);
   }
-  // sort and remove duplicates
-  qsort(*use, *len, sizeof(use_info), cmp_use_info);
-  removeDuplicates(*use, len, sizeof(use_info), cmp_use_info);
-  *use = realloc(*use, *len * sizeof(use_info));
-  return table;
+  // an assignment of a constant nobody reads any longer
+  for (int pos = 0; pos < p->len; ++pos) {
+    const int v = p->var_of[pos];
+    if (v == -1 || !p->reachable[p->block_of[pos]] || p->def[pos].state != CONST) continue;
+    if (def_readers[pos] == 0 && (!p->leaves[pos] || var_readers[v] == 0))
+      removeCode(p->list, p->codes[pos]);
+  }
+  free(def_readers);
+  free(var_readers);
 }
 
-static void freeUseInfoTable(UseInfoTable *table) {
-  assert(table != NULL);
-  free(table->use);
-  free(table);
+static void propagateFunction(Propagation *p) {
+  const int len = p->len;
+  p->block_of = malloc(sizeof(int) * len);
+  p->block_begin = malloc(sizeof(int) * (len + 1));
+  p->reachable = calloc(len, sizeof(bool));
+  p->labels = malloc(sizeof(int) * 2 * len);
+  p->pred = malloc(sizeof(int) * len);
+  p->pred_cnt = malloc(sizeof(int) * len);
+  p->var_of = malloc(sizeof(int) * len);
+  p->leaves = malloc(sizeof(bool) * len);
+  p->def = malloc(sizeof(Lattice) * len);
+  p->def_uses = malloc(sizeof(int) * len);
+  p->site_var = malloc(sizeof(int) * SITE(len, 0));
+  p->src = malloc(sizeof(int) * SITE(len, 0));
+  p->use_next = malloc(sizeof(int) * SITE(len, 0));
+  p->stack = malloc(sizeof(int) * len);
+  p->queued = calloc(len, sizeof(bool));
+  p->top = 0;
+
+  splitFunction(p);
+  linkFunction(p);
+  reach(p, 0);
+  do {
+    while (p->top > 0) {
+      const int pos = p->stack[--p->top];
+      p->queued[pos] = false;
+      visit(p, pos);
+    }
+  } while (reachUndecided(p));
+  rewriteFunction(p);
+
+  free(p->block_of);
+  free(p->block_begin);
+  free(p->reachable);
+  free(p->labels);
+  free(p->pred);
+  free(p->pred_cnt);
+  free(p->vars);
+  free(p->var_of);
+  free(p->leaves);
+  free(p->def);
+  free(p->var);
+  free(p->site_var);
+  free(p->src);
+  free(p->use_next);
+  free(p->def_uses);
+  free(p->var_uses);
+  free(p->stack);
+  free(p->queued);
 }
 
-#define search(key, table, cmp_fn) \
-    bsearch(&(key), (table)->use, (table)->len, sizeof(use_info), (cmp_fn))
+/**
+ * @example
+ * <pre>
+ * t0 := #2        |  WRITE #7
+ * a := t0 * #3    |
+ * t1 := a + #1    |
+ * WRITE t1        |
+ * </pre>
+ */
+static void propagateConstants(CodeList *list) {
+  Propagation p = {.list = list};
+  p.codes = malloc(sizeof(CodeIndex) * list->cnt);
+  CodeIndex i = firstCode(list);
+  while (i != CODE_SENTINEL) {
+    p.len = 0;
+    do {
+      p.codes[p.len++] = i;
+      i = nextCode(list, i);
+    } while (i != CODE_SENTINEL && codeAt(list, i)->kind != C_FUNCTION);
+    propagateFunction(&p);
+  }
+  free(p.codes);
+}
 
-#define check_distill_op(op) \
-  either((op)->kind, O_REFER, O_DEREF) ? (op)->address : (op)
+///// Control flow /////////////////////////////////////////
+
+/* the edges, orders and dominators of the blocks, in time linear to the code.
+ * a function is only entered at its first block, so each function is a graph of its own.
+ * the dominators are settled by passes over the reverse postorder, as in "A Simple, Fast
+ * Dominance Algorithm" by Cooper, Harvey and Kennedy. the graph of a C-- program is
+ * reducible, on which the second pass finds nothing to change. */
+
+// the block starting with the label, -1 if none
+int getLabelBlock(const Block *block, const int label) {
+  const size_t mask = block->label_slot_cnt - 1;
+  for (size_t i = hashPair(label, 0, mask); block->label_slots[i] != -1; i = (i + 1) & mask) {
+    const int found = block->label_slots[i];
+    if (codeAt(block->list, block->container[found].begin)->as.unary.var_no == label) return found;
+  }
+  return -1;
+}
 
 /**
- * @brief update use-info table with <b>'effective'</b> variables of the given current code
- * <p>
- * * helper function of `setBasicBlock`
+ * @brief whether every path from the entry of the function to the block at index goes
+ * through the block at dominator, a block dominates itself.
+ * @return false if either block is unreachable.
  */
-static void updateUseInfoTable(const Code *code, const UseInfoTable *table) {
-#define update(target_op, is_alive, table, cmp_fn) do {\
-    use_info *find = search((use_info){.op = (target_op)}, (table), (cmp_fn));\
-    assert(find != NULL);\
-    find->in_use = (is_alive);\
-  } while (false)
+bool dominates(const Block *block, const int dominator, const int index) {
+  const BasicBlock *d = &block->container[dominator], *b = &block->container[index];
+  if (d->rpo == -1 || b->rpo == -1) return false;
+  return d->dom_in <= b->dom_in && b->dom_out <= d->dom_out;
+}
+
+static void indexLabels(Block *block) {
+  int label_cnt = 0;
+  for (int b = 0; b < block->cnt; ++b)
+    label_cnt += codeAt(block->list, block->container[b].begin)->kind == C_LABEL;
+  // at least twice as many slots as labels
+  for (block->label_slot_cnt = 16; block->label_slot_cnt < 2 * label_cnt; block->label_slot_cnt *= 2) {}
+  block->label_slots = malloc(sizeof(int) * block->label_slot_cnt);
+  memset(block->label_slots, -1, sizeof(int) * block->label_slot_cnt);
+
+  const size_t mask = block->label_slot_cnt - 1;
+  for (int b = 0; b < block->cnt; ++b) {
+    const Code *c = codeAt(block->list, block->container[b].begin);
+    if (c->kind != C_LABEL) continue;
+    size_t i = hashPair(c->as.unary.var_no, 0, mask);
+    while (block->label_slots[i] != -1) i = (i + 1) & mask;
+    block->label_slots[i] = b;
+  }
+}
+
+// the successors of each block by its last code, then the predecessors gathered from them
+static void linkBlocks(Block *block) {
+  const int cnt = block->cnt;
+  BasicBlock *container = block->container;
+  block->edges = malloc(sizeof(int) * 4 * cnt);
+  for (int b = 0; b < cnt; ++b) {
+    BasicBlock *basic = &container[b];
+    const Code *first = codeAt(block->list, basic->begin);
+    const Code *last = codeAt(block->list, basic->end);
+    basic->entry = b == 0 || first->kind == C_FUNCTION ? b : container[b - 1].entry;
+    basic->succ = block->edges + 2 * b;
+    basic->succ_cnt = basic->pred_cnt = 0;
+
+    if (last->kind == C_GOTO || last->kind == C_IFGOTO) {
+      const int target = getLabelBlock(block, last->kind == C_GOTO
+                                                ? last->as.unary.var_no
+                                                : last->as.ternary.label.var_no);
+      // the IR loaders reject a jump to a label its function doesn't define
+      assert(target != -1);
+      basic->succ[basic->succ_cnt++] = target;
+    }
+    const bool falls = b + 1 < cnt && last->kind != C_GOTO && last->kind != C_RETURN &&
+                       codeAt(block->list, container[b + 1].begin)->kind != C_FUNCTION;
+    // a condition jumping to the next block has a single edge
+    if (falls && (basic->succ_cnt == 0 || basic->succ[0] != b + 1))
+      basic->succ[basic->succ_cnt++] = b + 1;
+  }
+
+  for (int b = 0; b < cnt; ++b)
+    for (int s = 0; s < container[b].succ_cnt; ++s) container[container[b].succ[s]].pred_cnt++;
+  int *pred = block->edges + 2 * cnt;
+  for (int b = 0; b < cnt; ++b) {
+    container[b].pred = pred;
+    pred += container[b].pred_cnt;
+    container[b].pred_cnt = 0;
+  }
+  for (int b = 0; b < cnt; ++b) {
+    for (int s = 0; s < container[b].succ_cnt; ++s) {
+      BasicBlock *succ = &container[container[b].succ[s]];
+      succ->pred[succ->pred_cnt++] = b;
+    }
+  }
+}
+
+// depth first from the entry of each function, a block is done once all its successors are
+static void orderBlocks(Block *block) {
+  BasicBlock *container = block->container;
+  block->rpo = malloc(sizeof(int) * block->cnt);
+  block->rpo_cnt = 0;
+  int *stack = malloc(sizeof(int) * block->cnt);
+  int *next = calloc(block->cnt, sizeof(int)); // the successor to visit next
+  bool *seen = calloc(block->cnt, sizeof(bool));
+
+  for (int entry = 0; entry < block->cnt; ++entry) {
+    container[entry].rpo = -1;
+    if (container[entry].entry != entry) continue;
+    const int start = block->rpo_cnt;
+    int top = 0;
+    stack[top++] = entry;
+    seen[entry] = true;
+    while (top > 0) {
+      const int b = stack[top - 1];
+      if (next[b] == container[b].succ_cnt) {
+        block->rpo[block->rpo_cnt++] = b;
+        top--;
+        continue;
+      }
+      const int s = container[b].succ[next[b]++];
+      if (!seen[s]) {
+        seen[s] = true;
+        stack[top++] = s;
+      }
+    }
+    reverseArray(block->rpo + start, block->rpo_cnt - start, sizeof(int));
+  }
+  for (int i = 0; i < block->rpo_cnt; ++i) container[block->rpo[i]].rpo = i;
+  free(stack);
+  free(next);
+  free(seen);
+}
+
+// the nearest common dominator, walking up from the later block in reverse postorder
+static int intersect(const BasicBlock *container, int a, int b) {
+  while (a != b) {
+    while (container[a].rpo > container[b].rpo) a = container[a].idom;
+    while (container[b].rpo > container[a].rpo) b = container[b].idom;
+  }
+  return a;
+}
 
-  assert(table != NULL);
-  const int kind = code->kind;
-  assert(in(kind, EFFECTIVE_CODE));
+static void findDominators(Block *block) {
+  BasicBlock *container = block->container;
+  // an entry is its own dominator while iterating, which stops `intersect` there
+  for (int b = 0; b < block->cnt; ++b)
+    container[b].idom = container[b].entry == b && container[b].rpo != -1 ? b : -1;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < block->rpo_cnt; ++i) {
+      BasicBlock *basic = &container[block->rpo[i]];
+      if (basic->entry == block->rpo[i]) continue;
+      int idom = -1;
+      for (int p = 0; p < basic->pred_cnt; ++p) {
+        const int pred = basic->pred[p];
+        if (container[pred].idom == -1) continue; // not processed or unreachable
+        idom = idom == -1 ? pred : intersect(container, pred, idom);
+      }
+      if (idom != basic->idom) {
+        basic->idom = idom;
+        changed = true;
+      }
+    }
+  }
 
-  // result operand is always the first operand lower in memory
-  const Operand *result = (Operand *) &code->as;
-  if (in(kind, 3, C_RETURN, C_WRITE, C_ARG) && result->kind == O_CONSTANT) return;
+  // number the dominator tree in preorder, the children of a block are kept in a list
+  int *child = malloc(sizeof(int) * block->cnt), *sibling = malloc(sizeof(int) * block->cnt);
+  int *stack = malloc(sizeof(int) * block->cnt);
+  for (int b = 0; b < block->cnt; ++b) {
+    child[b] = -1;
+    container[b].dom_in = container[b].dom_out = -1;
+  }
+  for (int i = block->rpo_cnt - 1; i >= 0; --i) {
+    const int b = block->rpo[i];
+    if (container[b].entry == b) continue;
+    sibling[b] = child[container[b].idom];
+    child[container[b].idom] = b;
+  }
+  int order = 0;
+  for (int i = 0; i < block->rpo_cnt; ++i) {
+    const int root = block->rpo[i];
+    if (container[root].entry != root) continue;
+    container[root].idom = -1;
+    container[root].dom_in = order++;
+    int top = 0;
+    stack[top++] = root;
+    while (top > 0) {
+      const int b = stack[top - 1];
+      if (child[b] == -1) {
+        container[b].dom_out = order - 1;
+        top--;
+        continue;
+      }
+      const int c = child[b];
+      child[b] = sibling[c];
+      container[c].dom_in = order++;
+      stack[top++] = c;
+    }
+  }
+  free(child);
+  free(sibling);
+  free(stack);
+}
 
-  int start_index = 0;
-  uint8_t op_cnt = operand_count_per_code[kind];
-  // Note: if kind is C_RETURN update it to be true
-  if (kind == C_IFGOTO) {
-    op_cnt--;
-  } else if (!(kind == C_RETURN || either(result->kind, O_REFER, O_DEREF))) {
-    // if kind includes `C_DEC`, then use info set to false
-    update(result, false, table, cmp_use_info);
-    start_index = 1;
+/* an edge into a block dominating its source closes a natural loop, whose body is the
+ * header and every block reaching the source without passing the header. the loops
+ * sharing a header count as one. */
+static void findLoops(Block *block) {
+  BasicBlock *container = block->container;
+  int *stack = malloc(sizeof(int) * block->cnt);
+  int *mark = malloc(sizeof(int) * block->cnt); // the last header whose body took the block
+  for (int b = 0; b < block->cnt; ++b) {
+    container[b].loop_depth = 0;
+    mark[b] = -1;
+  }
+  for (int header = 0; header < block->cnt; ++header) {
+    const BasicBlock *h = &container[header];
+    int top = 0;
+    for (int p = 0; p < h->pred_cnt; ++p) {
+      const int source = h->pred[p];
+      if (!dominates(block, header, source) || mark[source] == header) continue;
+      mark[source] = header;
+      if (source != header) stack[top++] = source;
+    }
+    if (mark[header] != header && top == 0) continue;
+    mark[header] = header;
+    container[header].loop_depth++;
+    while (top > 0) {
+      BasicBlock *basic = &container[stack[--top]];
+      basic->loop_depth++;
+      for (int p = 0; p < basic->pred_cnt; ++p) {
+        const int pred = basic->pred[p];
+        if (mark[pred] == header || container[pred].rpo == -1) continue;
+        mark[pred] = header;
+        stack[top++] = pred;
+      }
+    }
   }
+  free(stack);
+  free(mark);
+}
+
+static void buildControlFlow(Block *block) {
+  indexLabels(block);
+  linkBlocks(block);
+  orderBlocks(block);
+  findDominators(block);
+  findLoops(block);
+}
+
+///// Liveness /////////////////////////////////////////////
 
-  for (int i = start_index; i < op_cnt; ++i) {
-    const Operand *op = result + i;
-    // do not update variables whose kind isn't within effective operands
-    if (!in(op->kind, EFFECTIVE_OP)) continue;
-    update(check_distill_op(op), true, table, cmp_use_info);
+/* a variable is live at a point if some path from there reads it before assigning it.
+ * the sets at the start and the end of each block are found backwards over the blocks
+ * of a function, until a pass changes nothing. */
+
+// the temporary or variable that an operand reads or writes
+#define check_distill_op(op) \
+  (either((op)->kind, O_REFER, O_DEREF) ? base_op(op) : *(op))
+
+// whether op reads or writes a temporary or variable, a reference reads the address it holds
+static bool isVariable(const Operand *op) {
+  switch (op->kind) {
+    case O_TEM_VAR: case O_VARIABLE: case O_DEREF: case O_REFER:
+      return true;
+    default:
+      return false;
   }
-#undef update
+}
+
+// the operand a code assigns as a whole, NULL if none
+static const Operand* definedOperand(const Code *code) {
+  if (code->kind == C_DEC) return &code->as.dec.target;
+  return definesFirst(code) ? &code->as.unary : NULL;
 }
 
 /**
- * @brief copy the current state of use-info table into the info list.
- * for each code, only copy those effective variables that appear in it.
+ * @brief the operands of code that hold the temporaries and variables it reads or writes.
+ * @return a mask of their slots, the assigned one is always the first slot.
  */
-static void copyUseInfo(info *info, const Chunk *chunk, const UseInfoTable *table) {
-  info->currentLine = chunk;
-  const int kind = chunk->code.kind;
-  assert(in(kind, EFFECTIVE_CODE));
+int variableSlots(const Code *code, bool *defines) {
+  *defines = definedOperand(code) != NULL;
+  int mask = *defines;
+  for (int i = *defines; i < readingCount(code); ++i) {
+    if (isVariable((const Operand *) &code->as + i)) mask |= 1 << i;
+  }
+  return mask;
+}
 
-  uint8_t op_cnt = operand_count_per_code[kind];
-  // the third operand for `C_IFGOTO` is label
-  if (kind == C_IFGOTO) op_cnt--;
+// number the variables of each function in the order they are seen
+static void numberVariables(Block *block) {
+  const CodeList *list = block->list;
+  block->numbers = malloc(sizeof(int) * SITE(list->cnt, 0));
+  block->function_cnt = 0;
+  for (int b = 0; b < block->cnt; ++b)
+    block->function_cnt += block->container[b].entry == b;
+  block->functions = malloc(sizeof(Function) * block->function_cnt);
 
-  for (int i = 0; i < op_cnt; ++i) {
-    const Operand *op = (Operand *) &chunk->code.as + i;
-    // only search effective operands
-    if (!in(op->kind, EFFECTIVE_OP)) continue;
+  int *slots = NULL;
+  size_t slot_cnt = 0;
+  for (int f = 0, b = 0; f < block->function_cnt; ++f) {
+    Function *function = &block->functions[f];
+    const int entry = b;
+    // no more variables than the operands of the codes
+    int site_cnt = 0;
+    do {
+      block->container[b].function = f;
+      const CodeIndex stop = nextCode(list, block->container[b].end);
+      for (CodeIndex i = block->container[b].begin; i != stop; i = nextCode(list, i)) site_cnt += 3;
+    } while (++b < block->cnt && block->container[b].entry != b);
 
-    const use_info *find = search((use_info){.op = check_distill_op(op)},
-                                  table, cmp_use_info);
-    assert(find != NULL);
-    memcpy(info->use + i, find, sizeof(use_info));
+    *function = (Function){.entry = entry, .cnt = 0};
+    function->variables = malloc(sizeof(Operand) * (site_cnt + 1));
+    // at least twice as many slots as variables
+    if (slot_cnt < 2 * (size_t) site_cnt) {
+      for (slot_cnt = 16; slot_cnt < 2 * (size_t) site_cnt; slot_cnt *= 2) {}
+      slots = realloc(slots, sizeof(int) * slot_cnt);
+    }
+    memset(slots, -1, sizeof(int) * slot_cnt);
+    const size_t mask = slot_cnt - 1;
+
+    const CodeIndex stop = nextCode(list, block->container[b - 1].end);
+    for (CodeIndex i = block->container[entry].begin; i != stop; i = nextCode(list, i)) {
+      const Code *code = codeAt(list, i);
+      bool defines;
+      const int used = variableSlots(code, &defines);
+      for (int slot = 0; slot < 3; ++slot) {
+        block->numbers[SITE(i, slot)] = -1;
+        if (!(used >> slot & 1)) continue;
+        const Operand var = check_distill_op((const Operand *) &code->as + slot);
+        size_t s = hashPair(var.kind, var.var_no, mask);
+        while (slots[s] != -1 && (function->variables[slots[s]].kind != var.kind ||
+                                  function->variables[slots[s]].var_no != var.var_no))
+          s = (s + 1) & mask;
+        if (slots[s] == -1) {
+          function->variables[function->cnt] = var;
+          slots[s] = function->cnt++;
+        }
+        block->numbers[SITE(i, slot)] = slots[s];
+      }
+    }
+    function->variables = realloc(function->variables, sizeof(Operand) * (function->cnt + 1));
   }
+  free(slots);
 }
 
-#undef check_distill_op
-#undef search
+static void findLiveness(Block *block) {
+  const CodeList *list = block->list;
+  size_t words = 0;
+  for (int b = 0; b < block->cnt; ++b)
+    words += BIT_WORDS(block->functions[block->container[b].function].cnt);
+  // live in and out of each block, then what a block reads first and what it assigns
+  block->live = calloc(2 * words + 1, sizeof(uint64_t));
+  uint64_t *gen = calloc(words + 1, sizeof(uint64_t)), *kill = calloc(words + 1, sizeof(uint64_t));
+
+  size_t offset = 0;
+  for (int b = 0; b < block->cnt; ++b) {
+    BasicBlock *basic = &block->container[b];
+    const int n = BIT_WORDS(block->functions[basic->function].cnt);
+    basic->live_in = block->live + 2 * offset;
+    basic->live_out = basic->live_in + n;
+    uint64_t *g = gen + offset, *k = kill + offset;
+    offset += n;
+
+    const CodeIndex stop = prevCode(list, basic->begin);
+    for (CodeIndex i = basic->end; i != stop; i = prevCode(list, i)) {
+      bool defines;
+      const int used = variableSlots(codeAt(list, i), &defines);
+      if (defines) {
+        SET_BIT(k, block->numbers[SITE(i, 0)]);
+        CLEAR_BIT(g, block->numbers[SITE(i, 0)]);
+      }
+      for (int slot = defines; slot < 3; ++slot) {
+        if (used >> slot & 1) SET_BIT(g, block->numbers[SITE(i, slot)]);
+      }
+    }
+  }
+
+  for (int f = 0; f < block->function_cnt; ++f) {
+    const int n = BIT_WORDS(block->functions[f].cnt), entry = block->functions[f].entry;
+    const int last = f + 1 < block->function_cnt ? block->functions[f + 1].entry - 1 : block->cnt - 1;
+    // blocks are mostly laid out in the order of the flow, so go backwards
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int b = last; b >= entry; --b) {
+        BasicBlock *basic = &block->container[b];
+        // gen and kill hold one set per block, where `block->live` holds two
+        const size_t at = (basic->live_in - block->live) / 2;
+        for (int w = 0; w < n; ++w) {
+          uint64_t out = 0;
+          for (int s = 0; s < basic->succ_cnt; ++s) out |= block->container[basic->succ[s]].live_in[w];
+          const uint64_t in = gen[at + w] | (out & ~kill[at + w]);
+          basic->live_out[w] = out;
+          if (in != basic->live_in[w]) {
+            basic->live_in[w] = in;
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+  free(gen);
+  free(kill);
+}
+
+///// Blocks ///////////////////////////////////////////////
+
+/**
+ * @brief set info for each line of effective code inside the basic block.
+ * going backwards from the variables live at the end of the block, a variable
+ * is in use after a code if it is live there.
+ */
+static void setInfo(const Block *block, BasicBlock *basic) {
+  const CodeList *list = block->list;
+  const int words = BIT_WORDS(block->functions[basic->function].cnt);
+  uint64_t *live = malloc(sizeof(uint64_t) * (words + 1));
+  memcpy(live, basic->live_out, sizeof(uint64_t) * words);
 
-// set info for each line of code inside the basic block
-static void setInfo(BasicBlock *basic) {
   int capacity = 5, *len = &basic->len;
   info **info_ = &basic->info;
   *len = 0;
   *info_ = malloc(sizeof(info) * capacity);
-  // initialize use-info table
-  UseInfoTable *table = createUseInfoTable(basic);
-
   // loop from end to begin
-  const Chunk *chunk = basic->end;
-  while (chunk != basic->begin->prev) {
-    if (!in(chunk->code.kind, EFFECTIVE_CODE)) goto CONTINUE;
-    if (*len >= capacity) goto RESIZE;
-    // get a snapshot of the current state of use-info table
-    copyUseInfo(&(*info_)[(*len)++], chunk, table);
-    // update the use-info table with the current code
-    updateUseInfoTable(&chunk->code, table);
-  CONTINUE:
-    chunk = chunk->prev;
-    continue;
-  RESIZE:
-    RESIZE(capacity);
-    *info_ = realloc(*info_, sizeof(info) * capacity);
+  const CodeIndex stop = prevCode(list, basic->begin);
+  for (CodeIndex i = basic->end; i != stop; i = prevCode(list, i)) {
+    const Code *code = codeAt(list, i);
+    if (!in(code->kind, EFFECTIVE_CODE)) continue;
+    if (*len >= capacity) {
+      RESIZE(capacity);
+      *info_ = realloc(*info_, sizeof(info) * capacity);
+    }
+    // a snapshot of the variables live after the code
+    info *info = &(*info_)[(*len)++];
+    info->currentLine = i;
+    bool defines;
+    const int used = variableSlots(code, &defines);
+    for (int slot = 0; slot < 3; ++slot) {
+      if (!(used >> slot & 1)) continue;
+      const int v = block->numbers[SITE(i, slot)];
+      info->use[slot] = (use_info){
+        .op = check_distill_op((const Operand *) &code->as + slot),
+        .index = v, .in_use = TEST_BIT(live, v),
+      };
+    }
+    // the assigned variable is dead before the code, the variables read are live
+    if (defines) CLEAR_BIT(live, block->numbers[SITE(i, 0)]);
+    for (int slot = defines; slot < 3; ++slot) {
+      if (used >> slot & 1) SET_BIT(live, block->numbers[SITE(i, slot)]);
+    }
   }
   reverseArray(*info_, *len, sizeof(info));
-
-  // copy variables from table to basic block
-  basic->cnt = (int) table->len;
-  basic->variables = malloc(sizeof(Operand *) * table->len);
-  for (int i = 0; i < table->len; ++i) {
-    basic->variables[i] = table->use[i].op;
-  }
-  freeUseInfoTable(table);
+  free(live);
 }
 
+#undef check_distill_op
+
 // for each basic block, set their info array
 static void setBlocksInfo(const Block *block) {
   assert(block != NULL);
   // loop through all basic blocks
   for (int i = 0; i < block->cnt; ++i) {
-    BasicBlock *basic = &block->container[i];
-    setInfo(basic);
+    setInfo(block, &block->container[i]);
   }
 }
 
 /**
  * @brief partition chunk into basic blocks
  * @note: after delete redundant labels, all labels are necessary.
- * @return a list of basic blocks
+ * @return a list of basic blocks, linked into a control-flow graph
  */
-static Block* partitionChunk(const Chunk *sentinel) {
+static Block* partitionChunk(const CodeList *list) {
   Block *block = malloc(sizeof(Block));
+  block->list = list;
   int *cnt = &block->cnt, capacity = 5;
   BasicBlock **container = &block->container;
   *cnt = 0;
   *container = malloc(sizeof(BasicBlock) * capacity);
 
-  const Chunk *chunk = sentinel->next;
-  (*container)[(*cnt)++].begin = chunk;
+  CodeIndex i = firstCode(list);
+  (*container)[(*cnt)++].begin = i;
 
-  while (chunk != sentinel) {
-    const Code *c = &chunk->code;
-    if (!in(c->kind, 4, C_LABEL, C_IFGOTO, C_GOTO, C_FUNCTION))
+  while (i != CODE_SENTINEL) {
+    const Code *c = codeAt(list, i);
+    if (!in(c->kind, 5, C_LABEL, C_IFGOTO, C_GOTO, C_RETURN, C_FUNCTION))
       goto CONTINUE;
     if (*cnt >= capacity) goto RESIZE;
 
-    const Chunk *target = either(c->kind, C_FUNCTION, C_LABEL)
-                            ? chunk
-                            : chunk->next;
+    const CodeIndex target = either(c->kind, C_FUNCTION, C_LABEL)
+                               ? i
+                               : nextCode(list, i);
     // check for duplication before adding
-    if ((*container)[*cnt - 1].begin != target)
+    if (target != CODE_SENTINEL && (*container)[*cnt - 1].begin != target)
       (*container)[(*cnt)++].begin = target;
   CONTINUE:
-    chunk = chunk->next;
+    i = nextCode(list, i);
     continue;
   RESIZE:
     RESIZE(capacity);
@@ -329,118 +1114,33 @@ static Block* partitionChunk(const Chunk *sentinel) {
   }
 
   for (int i = 0; i < *cnt - 1; ++i)
-    (*container)[i].end = (*container)[i + 1].begin->prev;
-  (*container)[*cnt - 1].end = sentinel->prev;
+    (*container)[i].end = prevCode(list, (*container)[i + 1].begin);
+  (*container)[*cnt - 1].end = lastCode(list);
 
+  buildControlFlow(block);
+  numberVariables(block);
+  findLiveness(block);
   setBlocksInfo(block);
   return block;
 }
 
-/** cascade (adjacent) arithmetic operations that only include
- * <b>"temporary"</b> constants
- * @return true if there are some constants that can be folded
- *  @example:
- *  <pre>
- *  t0 := #2      |  t1 := #6
- *  t1 := t0 * 3  |
- *  </pre>
- *  @example:
- *  <pre>
- *  a := 0        |  a := #0
- *  t0 := a * b   |  t0 := #0
- *  </pre>
- *  @example:
- *  <pre>
- *  a := 1        |  a := #0
- *  t0 := a * b   |  t0 := b
- *  </pre>
- */
-static bool optimizeArithmatic(const Chunk *sentinel) {
-  bool flag = false;
-  Chunk *chunk = sentinel->next;
-  while (chunk != sentinel) {
-    bool need_remove = true;
-    Code *c = &chunk->code;
-    chunk = chunk->next; // chunk is now pointing to the next code
-    foldConstant(c);
-    organizeOpSequence(c);
-
-    if (c->kind != C_ASSIGN) continue;
-    const Operand *prev_right = &c->as.assign.right;
-    if (prev_right->kind != O_CONSTANT) continue;
-    const Operand *prev_left = &c->as.assign.left;
-    // the previous line of code is assignment of constant
-
-    Operand *target = NULL;
-    // check assignment
-    if (chunk->code.kind == C_ASSIGN) {
-      Operand *right = &chunk->code.as.assign.right;
-      if (right->kind == O_TEM_VAR && prev_left->kind == O_TEM_VAR
-          && right->var_no == prev_left->var_no) {
-        target = right;
-        goto FOUND;
-      }
-      if (right->kind == O_VARIABLE && prev_left->kind == O_VARIABLE
-          && strcmp(right->value_s, prev_left->value_s) == 0) {
-        need_remove = false;
-        target = right;
-        goto FOUND;
-      }
-    }
-    // check binary operation
-    if (!in(chunk->code.kind, 4, C_ADD, C_SUB, C_MUL, C_DIV)) continue;
-    Operand *op1 = &chunk->code.as.binary.op1;
-    Operand *op2 = &chunk->code.as.binary.op2;
-
-
-    if (prev_left->kind == O_TEM_VAR && either(O_TEM_VAR, op1->kind, op2->kind)) {
-      if (either(prev_left->var_no, op1->var_no, op2->var_no)) {
-        target = op1->var_no == prev_left->var_no ? op1 : op2;
-        goto FOUND;
-      }
-    } else if (prev_left->kind == O_VARIABLE && either(O_VARIABLE, op1->kind, op2->kind)) {
-      need_remove = false;
-      if (op1->kind == O_VARIABLE &&
-          strcmp(op1->value_s, prev_left->value_s) == 0) {
-        target = op1;
-        goto FOUND;
-      }
-      if (op2->kind == O_VARIABLE &&
-          strcmp(op2->value_s, prev_left->value_s) == 0) {
-        target = op2;
-        goto FOUND;
-      }
-    }
-    continue;
-
-  FOUND:
-    if (target->kind == O_VARIABLE)
-      free((void *) target->value_s);
-    target->value = prev_right->value;
-    target->kind = O_CONSTANT;
-    flag = true;
-    if (need_remove)
-      removeCode(chunk->prev);
-  }
-  return flag;
-}
-
-static void printBasicBlock(const BasicBlock *basic) {
-  printf("all variables inside block.\n");
-  for (int i = 0; i < basic->cnt; ++i) {
-    printOp(stdout, basic->variables[i]);
+static void printBasicBlock(const Block *block, const BasicBlock *basic) {
+  const CodeList *list = block->list;
+  const Function *function = &block->functions[basic->function];
+  printf("variables live at the start of block.\n");
+  for (int i = 0; i < function->cnt; ++i) {
+    if (TEST_BIT(basic->live_in, i)) printOp(stdout, &function->variables[i]);
   }
   printf("\n");
 
   for (int i = 0; i < basic->len; ++i) {
     const info *info_ = basic->info + i;
-    const Chunk *chunk = info_->currentLine;
+    const Code *code = codeAt(list, info_->currentLine);
     // all code is effective if they are inside 'info' array
-    assert(in(chunk->code.kind, EFFECTIVE_CODE));
+    assert(in(code->kind, EFFECTIVE_CODE));
     printf("As for line %d: \t", i);
-    printCode(stdout, &chunk->code);
+    printCode(stdout, code);
     printf("use info is: \t");
-    const Code *code = &chunk->code;
     const int kind = code->kind;
 
     for (int e = 0; e < operand_count_per_code[kind]; ++e) {
@@ -450,37 +1150,36 @@ static void printBasicBlock(const BasicBlock *basic) {
         printf("i:[%d] Oops\t", e);
         continue;
       }
-      printOp(stdout, info_->use[e].op);
+      printOp(stdout, &info_->use[e].op);
       printf("\b[%d]--> in use or not: (%d)  ", e, info_->use[e].in_use);
     }
     printf("\n");
   }
 }
 
-// debug utility
-__attribute__((unused))
-static void printBlock(const Block *block) {
+// debug utility, the driver dumps the blocks of a single file to stdout
+void printBlock(const Block *block) {
   assert(block != NULL);
   for (int i = 0; i < block->cnt; ++i) {
-    printf("\n+++Block %d:\n", i);
-    printCode(stdout, &block->container[i].begin->code);
-    printCode(stdout, &block->container[i].end->code);
+    const BasicBlock *basic = &block->container[i];
+    printf("\n+++Block %d (idom %d, depth %d) ->", i, basic->idom, basic->loop_depth);
+    for (int s = 0; s < basic->succ_cnt; ++s) printf(" %d", basic->succ[s]);
+    printf("\n");
+    printCode(stdout, codeAt(block->list, block->container[i].begin));
+    printCode(stdout, codeAt(block->list, block->container[i].end));
   }
   // print the first block info list
   printf("\n+++ FIRST basic block:\n");
-  printBasicBlock(block->container);
+  printBasicBlock(block, block->container);
 }
 
-Block* optimize(const Chunk *sentinel) {
-  while (optimizeArithmatic(sentinel)) { /* do nothing */ }
-  flipCondition(sentinel);
-  deleteLabels(sentinel);
-  Block *block = partitionChunk(sentinel);
-
-#ifdef LOCAL
-  printBlock(block);
-#endif
-  return block;
+Block* optimize(CompilerContext *ctx, CodeList *list) {
+  bindContext(ctx);
+  propagateConstants(list);
+  deleteJumps(list);
+  flipCondition(list);
+  deleteLabels(list);
+  return partitionChunk(list);
 }
 
 void freeBlock(Block *block) {
@@ -489,15 +1188,18 @@ void freeBlock(Block *block) {
     // free basic block
     const BasicBlock *basic = block->container + i;
     free(basic->info);
-    free(basic->variables);
   }
+  for (int i = 0; i < block->function_cnt; ++i) free(block->functions[i].variables);
+  free(block->functions);
+  free(block->live);
+  free(block->numbers);
   free(block->container);
+  free(block->edges);
+  free(block->rpo);
+  free(block->label_slots);
   free(block);
 }
 
-int cmp_use_info(const void *u1, const void *u2) {
-  return cmp_operand(&((use_info *) u1)->op, &((use_info *) u2)->op);
-}
-
+#undef SITE
 #undef EFFECTIVE_CODE
 #undef EFFECTIVE_OP
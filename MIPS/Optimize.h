@@ -15,29 +15,55 @@
 #define EFFECTIVE_OP   4, O_VARIABLE, O_TEM_VAR, O_DEREF, O_REFER
 
 typedef struct {
-  Operand *op;
+  Operand op;
+  int index;   // the number of the variable in its function
   bool in_use;
 } use_info;
 
 typedef struct {
-  const Chunk *currentLine;
+  CodeIndex currentLine;
   use_info use[3]; // no more than 3 operands in an expression
 } info;
 
 typedef struct {
-  const Chunk *begin, *end;
+  CodeIndex begin, end;
   int len;             // the amount of code
   info *info;          // an array
-  int cnt;             // the number of variables
-  Operand **variables; // a list of pointers
+  // the control flow, a block is known by its index in the container
+  int *succ, succ_cnt; // no more than 2 successors
+  int *pred, pred_cnt;
+  int entry;           // the first block of its function
+  int rpo;             // the position in the reverse postorder, -1 if unreachable
+  int idom;            // the immediate dominator, -1 for an entry or if unreachable
+  int dom_in, dom_out; // the interval of the block in a preorder walk of the dominator tree
+  int function;        // the index in Block.functions
+  int loop_depth;      // the number of natural loops the block is in
+  uint64_t *live_in, *live_out; // bitsets over the variables of its function
 } BasicBlock;
 
 typedef struct {
+  int entry;           // the first block
+  int cnt;             // the number of temporaries and variables
+  Operand *variables;  // in the order they are seen, a variable is known by its index here
+} Function;
+
+typedef struct {
+  const CodeList *list; // the codes the blocks refer to
   int cnt;
   BasicBlock *container;
+  int *edges;           // the successors then the predecessors of every block
+  int *rpo, rpo_cnt;    // the reachable blocks, function after function in reverse postorder
+  int *label_slots, label_slot_cnt; // open addressing from a label number to its block
+  Function *functions;
+  int function_cnt;
+  uint64_t *live;       // the bitsets of every block
+  int *numbers;         // the variable in each operand, at 3 * CodeIndex + slot, -1 if none
 } Block;
 
-Block* optimize(const Chunk *sentinel);
+Block* optimize(CompilerContext *ctx, CodeList *list);
 void freeBlock(Block *block);
+int getLabelBlock(const Block *block, int label);
+bool dominates(const Block *block, int dominator, int index);
+int variableSlots(const Code *code, bool *defines);
 
 #endif
@@ -1,3 +1,4 @@
+#include <stdatomic.h>
 #ifdef LOCAL
 #include <ParseTree.h>
 #include <utils.h>
@@ -8,28 +9,34 @@
 
 // #define THRESHOLD 0.75
 #define THRESHOLD 1
-// the definition of root.
-ParseTNode *root = NULL;
+// the size of each chunk in the parse tree arena
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+// every node and children list of the parse tree lives in the arena of current context
+static void* parseTreeAlloc(const size_t size) {
+  CompilerContext *ctx = currentContext();
+  assert(ctx != NULL);
+  if (ctx->parse_arena == NULL) ctx->parse_arena = createArena(ARENA_CHUNK_SIZE);
+  return arenaAlloc(ctx->parse_arena, size);
+}
 
 // Array List functions
 static int initArrayList(ArrayList *list) {
   list->capacity = 4;
   list->num = 0;
-  list->container = (ParseTNode **) malloc(list->capacity * sizeof(ParseTNode *));
-  if (list->container == NULL) {
-    DEBUG_INFO("fail to initialize array list.\n");
-    exit(EXIT_FAILURE);
-  }
+  list->container = parseTreeAlloc(list->capacity * sizeof(ParseTNode *));
   return 0;
 }
 
+/**
+ * @note the old container is abandoned inside the arena,
+ * it will be released together with the whole tree.
+ */
 static int resizeArrayList(ArrayList *list) {
+  ParseTNode **old = list->container;
   list->capacity *= 2;
-  list->container = (ParseTNode **) realloc(list->container, list->capacity * sizeof(ParseTNode *));
-  if (list->container == NULL) {
-    DEBUG_INFO("fail to resize array list.\n");
-    exit(EXIT_FAILURE);
-  }
+  list->container = parseTreeAlloc(list->capacity * sizeof(ParseTNode *));
+  memcpy(list->container, old, list->num * sizeof(ParseTNode *));
   return 0;
 }
 
@@ -44,66 +51,68 @@ static void addToArrayList(ArrayList *list, ParseTNode *node) {
   list->container[list->num++] = node;
 }
 
-static void freeArrayList(const ArrayList *list) {
-  if (list == NULL) {
-    return;
-  }
-  for (int i = 0; i < list->num; ++i) {
-    freeParseTNode(list->container[i]);
-  }
-  free(list->container);
+// printable names of grammar symbols, indexed by SymbolKind
+static const char *symbolNames[] = {
+#define name_(s) [S_##s] = #s,
+  TERMINALS(name_)
+  NON_TERMINALS(name_)
+#undef name_
+};
+
+// the left-hand and right-hand side of every production, indexed by Production
+static const SymbolKind productionLhs[] = {
+#define lhs_(lhs, p, rhs) [P_##p] = S_##lhs,
+  PRODUCTIONS(lhs_)
+#undef lhs_
+};
+
+static const char *productionRhs[] = {
+#define rhs_(lhs, p, rhs) [P_##p] = rhs,
+  PRODUCTIONS(rhs_)
+#undef rhs_
+};
+
+const char* symbolName(const SymbolKind kind) {
+  assert(0 <= kind && kind < SYMBOL_COUNT);
+  return symbolNames[kind];
 }
 
 // ParseTree Tree functions
 // Create a new ParseTree node without a value
-ParseTNode* createParseTNode(const char *name, const int lineNum, const int flag) {
-  if (flag != 0 && flag != 1) {
-    DEBUG_INFO("Wrong flag value.\n");
-    exit(EXIT_FAILURE);
-  }
-  ParseTNode *node = malloc(sizeof(ParseTNode));
-  if (node == NULL) {
-    DEBUG_INFO("fail to allocate memory for ParseTree node.\n");
-    exit(EXIT_FAILURE);
-  }
-  node->flag = flag;
-  node->name = my_strdup(name);
-  if (node->name == NULL) {
-    DEBUG_INFO("Fail to duplicate string for ParseTree node name.\n");
-    free(node);
+ParseTNode* createParseTNode(const SymbolKind kind, const Production production, const int lineNum) {
+  if (isTerminal(kind) != (production == P_NONE)) {
+    DEBUG_INFO("Only non-terminals are produced by a rule.\n");
     exit(EXIT_FAILURE);
   }
+  ParseTNode *node = parseTreeAlloc(sizeof(ParseTNode));
+  node->kind = kind;
+  node->production = production;
   node->lineNum = lineNum;
   initArrayList(&node->children);
   return node;
 }
 
-// Function to copy ValueUnion
-static void copyValueUnion(ValueUnion *dest, const ValueUnion *src, const char *type) {
-  if (strcmp(type, "str") == 0) {
-    dest->str_value = my_strdup(src->str_value);
-  } else if (strcmp(type, "int") == 0) {
-    dest->int_value = src->int_value;
-  } else if (strcmp(type, "float") == 0) {
-    dest->float_value = src->float_value;
-  } else {
-    fprintf(stderr, "unknown type %s.\n", type);
-    DEBUG_INFO("");
-    exit(EXIT_FAILURE);
-  }
-}
-
 // Create a new ParseTree node with a value
-ParseTNode* createParseTNodeWithValue(const char *name, const int lineNum, const ValueUnion value) {
-  ParseTNode *node = createParseTNode(name, lineNum, 1);
-  if (strcmp(name, "INT") == 0) {
-    copyValueUnion(&node->value, &value, "int");
-  } else if (strcmp(name, "FLOAT") == 0) {
-    copyValueUnion(&node->value, &value, "float");
-  } else if (strcmp(name, "ID") == 0 ||
-             strcmp(name, "TYPE") == 0 ||
-             strcmp(name, "RELOP") == 0) {
-    copyValueUnion(&node->value, &value, "str");
+ParseTNode* createParseTNodeWithValue(const SymbolKind kind, const int lineNum, const ValueUnion value) {
+  ParseTNode *node = createParseTNode(kind, P_NONE, lineNum);
+  switch (kind) {
+    case S_INT:
+      node->value.int_value = value.int_value;
+      break;
+    case S_FLOAT:
+      node->value.float_value = value.float_value;
+      break;
+    case S_ID:
+    case S_TYPE:
+      node->value.id = value.id;
+      break;
+    case S_RELOP:
+      node->value.relop = value.relop;
+      break;
+    default:
+      fprintf(stderr, "token %s doesn't carry a value.\n", symbolName(kind));
+      DEBUG_INFO("");
+      exit(EXIT_FAILURE);
   }
   return node;
 }
@@ -117,33 +126,18 @@ void addChild(ParseTNode *parent, ParseTNode *child) {
   addToArrayList(&parent->children, child);
 }
 
-// Free an ParseTree node
-void freeParseTNode(ParseTNode *node) {
-  if (node == NULL) {
-    return;
-  }
-  freeArrayList(&node->children);
-  if (strcmp(node->name, "ID") == 0 ||
-      strcmp(node->name, "TYPE") == 0 ||
-      strcmp(node->name, "RELOP") == 0) {
-    free(node->value.str_value);
-  }
-  free(node->name);
-  free(node);
-}
-
 // printParseTree helper function
-static void print(const ParseTNode *root, const int level) {
-  if (root->flag) { // token
-    printf("%*s%s", level * 2, "", root->name);
-    if (strcmp(root->name, "INT") == 0) {
-      printf(": %d", root->value.int_value);
-    } else if (strcmp(root->name, "FLOAT") == 0) {
-      printf(": %f", root->value.float_value);
-    } else if (strcmp(root->name, "TYPE") == 0 || strcmp(root->name, "ID") == 0) {
-      printf(": %s", root->value.str_value);
+static void print(FILE *out, const ParseTNode *root, const int level) {
+  if (isTerminal(root->kind)) { // token
+    fprintf(out, "%*s%s", level * 2, "", symbolName(root->kind));
+    if (root->kind == S_INT) {
+      fprintf(out, ": %d", root->value.int_value);
+    } else if (root->kind == S_FLOAT) {
+      fprintf(out, ": %f", root->value.float_value);
+    } else if (either(root->kind, S_TYPE, S_ID)) {
+      fprintf(out, ": %s", internedStr(root->value.id));
     }
-    printf("\n");
+    fprintf(out, "\n");
     return;
   }
   // higher expression
@@ -152,95 +146,91 @@ static void print(const ParseTNode *root, const int level) {
     return;
   }
 
-  printf("%*s%s (%d)\n", level * 2, "", root->name, root->lineNum);
+  fprintf(out, "%*s%s (%d)\n", level * 2, "", symbolName(root->kind), root->lineNum);
   for (int i = 0; i < root->children.num; i++) {
-    print(getChild(root, i), level + 1);
+    print(out, getChild(root, i), level + 1);
   }
 }
 
 // print out entire ParseTree tree
-void printParseTree(const ParseTNode *root) {
+void printParseTree(FILE *out, const ParseTNode *root) {
   if (root == NULL) {
     DEBUG_INFO("Root is null.\n");
     exit(EXIT_FAILURE);
   }
-  print(root, 0);
-}
-
-void printParseTRoot() {
-  printParseTree(root);
+  print(out, root, 0);
 }
 
+// release the whole parse tree in one go
 void cleanParseTree() {
-  freeParseTNode(root);
-}
-
-/**
- * @brief compare expression's children name with the given text
- * @param node the parse tree node to be compared
- * @param text the name or expression string as comparison target
- * @return 1 if equal; 0 not equal
-*/
-int nodeChildrenNamesEqual(const ParseTNode *node, const char *text) {
-  assert(node != NULL);
-  // compare with children names
-  char *text_copy = my_strdup(text);
-  const char *delim = " ";
-  const char *t = strtok(text_copy, delim);
-  int i = 0;
-  while (t != NULL) {
-    if (i >= node->children.num) {
-      // text_copy is longer than node's children names
-      free(text_copy);
-      return 0;
-    }
-    const char *child_name = getChild(node, i)->name;
-    if (strcmp(child_name, t) != 0) {
-      // mismatch word
-      free(text_copy);
-      return 0;
-    }
-    t = strtok(NULL, delim);
-    i++;
-  }
-  free(text_copy);
-  // check whether text is shorter than node's children names or not
-  return i == node->children.num;
+  CompilerContext *ctx = currentContext();
+  freeArena(ctx->parse_arena);
+  ctx->parse_arena = NULL;
+  ctx->root = NULL;
 }
 
 /**
- *  @brief get the child node by its name
+ *  @brief get the first child node of the given kind
  *  @return child node if found; else error occurred
 */
-ParseTNode* getChildByName(const ParseTNode *parent, const char *name) {
+ParseTNode* getChildByKind(const ParseTNode *parent, const SymbolKind kind) {
   assert(parent != NULL);
   for (int i = 0; i < parent->children.num; ++i) {
     ParseTNode *child = getChild(parent, i);
-    if (strcmp(child->name, name) == 0) {
+    if (child->kind == kind) {
       return child;
     }
   }
-  fprintf(stderr, "Wrong child name: %s. The parent node is %s\n.",
-          name, parent->name);
+  fprintf(stderr, "Wrong child kind: %s. The parent node is %s\n.",
+          symbolName(kind), symbolName(parent->kind));
   DEBUG_INFO("");
   exit(EXIT_FAILURE);
 }
 
+/**
+ * @brief fill `index` with the index of the pattern each production of
+ * `lhs` spells, the patterns are only compared here, never at lookup time.
+ */
+static void compileExprPattern(const SymbolKind lhs, const char *expressions[],
+                               const int length, int8_t index[PRODUCTION_COUNT]) {
+  assert(length <= INT8_MAX);
+  memset(index, -1, sizeof(int8_t) * PRODUCTION_COUNT);
+  for (int p = P_NONE + 1; p < PRODUCTION_COUNT; ++p) {
+    if (productionLhs[p] != lhs) continue;
+    for (int i = 0; i < length; ++i) {
+      if (strcmp(productionRhs[p], expressions[i]) != 0) continue;
+      index[p] = (int8_t) i;
+      break;
+    }
+  }
+}
+
 /**
  * @brief find which kind of expression the node's children match
+ * @param matcher the table of the call site, compiled on first use.
+ * only one thread publishes the table, the others use their own copy until it is ready.
  * @return if found, return the index of expr fitted in expressions; else error occurred
 */
-int matchExprPattern(const ParseTNode *node, const char *expressions[], const int length) {
-  int i = 0;
-  while (i < length) {
-    if (nodeChildrenNamesEqual(node, expressions[i])) {
-      break;
+int matchExprPattern(const ParseTNode *node, const char *expressions[], const int length,
+                     ExprMatcher *matcher) {
+  assert(node != NULL && !isTerminal(node->kind));
+  const int8_t *table = matcher->index;
+  int8_t index[PRODUCTION_COUNT];
+  if (atomic_load_explicit(&matcher->state, memory_order_acquire) != 2) {
+    compileExprPattern(node->kind, expressions, length, index);
+    table = index;
+    int expected = 0;
+    if (atomic_compare_exchange_strong_explicit(&matcher->state, &expected, 1,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+      memcpy(matcher->index, index, sizeof(index));
+      atomic_store_explicit(&matcher->state, 2, memory_order_release);
     }
-    i++;
   }
-  if (i == length) {
+
+  const int i = table[node->production];
+  if (i == -1) {
     DEBUG_INFO("There must be a typo in expression list.\n");
-    fprintf(stderr, "node: %s\n", node->name);
+    fprintf(stderr, "node: %s\n", symbolName(node->kind));
     for (int j = 0; j < length; ++j) {
       fprintf(stderr, "<%02d.>\t%s\n", j, expressions[j]);
     }
@@ -250,7 +240,7 @@ int matchExprPattern(const ParseTNode *node, const char *expressions[], const in
 }
 
 const ParseTNode* getRoot() {
-  return root;
+  return currentContext()->root;
 }
 
 //////test code/////////////////////////////////////////////
@@ -260,3 +250,4 @@ int main(int argc, char const* argv[]) {
 #endif
 
 #undef THRESHOLD
+#undef ARENA_CHUNK_SIZE
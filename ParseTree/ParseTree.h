@@ -1,24 +1,144 @@
 #ifndef PARSE_TREE
 #define PARSE_TREE
 
-// get the expression index
-#define EXPRESSION_INDEX(node, expressions) \
-  matchExprPattern(node, expressions, ARRAY_LEN(expressions))
+#ifdef LOCAL
+#include <utils.h>
+#else
+#include "utils.h"
+#endif
+
+/**
+ * get the expression index.
+ * each call site owns a matcher, its patterns are compiled into a table
+ * keyed by production on the first call, later calls are a single lookup.
+ */
+#define EXPRESSION_INDEX(node, expressions) ({\
+    static ExprMatcher _matcher;\
+    matchExprPattern(node, expressions, ARRAY_LEN(expressions), &_matcher);\
+  })
 
 #define getChild(node, index) \
   node->children.container[index]
 
 // extract string value from node of ID, no copy
 #define getStrFrom(node, where) \
-  getChildByName(node, #where)->value.str_value
+  internedStr(getIdFrom(node, where))
+
+// extract interned id from node of ID
+#define getIdFrom(node, where) \
+  getChildByKind(node, S_##where)->value.id
+
+// extract the operator from node of RELOP
+#define getRelopFrom(node) \
+  getChildByKind(node, S_RELOP)->value.relop
 
 // extract int value from node of INT, no copy
 #define getValFromINT(node) \
-  getChildByName(node, "INT")->value.int_value
+  getChildByKind(node, S_INT)->value.int_value
 
 // extract float value from node of FLOAT, no copy
 #define getValFromFLOAT(node) \
-  getChildByName(node, "FLOAT")->value.float_value
+  getChildByKind(node, S_FLOAT)->value.float_value
+
+#define isTerminal(kind) ((kind) < S_Program)
+
+// grammar symbols, terminals come before non-terminals
+#define TERMINALS(T) \
+  T(INT) T(FLOAT) T(TYPE) T(ID) \
+  T(SEMI) T(COMMA) T(ASSIGNOP) T(RELOP) T(DOT) \
+  T(PLUS) T(MINUS) T(STAR) T(DIV) \
+  T(AND) T(OR) T(NOT) \
+  T(LP) T(RP) T(LB) T(RB) T(LC) T(RC) \
+  T(STRUCT) T(RETURN) T(IF) T(ELSE) T(WHILE)
+
+#define NON_TERMINALS(N) \
+  N(Program) N(ExtDefList) N(ExtDef) N(ExtDecList) \
+  N(Specifier) N(StructSpecifier) N(OptTag) N(Tag) \
+  N(VarDec) N(FunDec) N(VarList) N(ParamDec) \
+  N(CompSt) N(StmtList) N(Stmt) \
+  N(DefList) N(Def) N(DecList) N(Dec) \
+  N(Exp) N(Args)
+
+/**
+ * every production of "syntax.y" with its left-hand and right-hand side,
+ * listed in the same order as the grammar file, so that the
+ * value of each production equals the rule number of bison.
+ */
+#define PRODUCTIONS(P) \
+  P(Program, Program, "ExtDefList") \
+  P(ExtDefList, ExtDefList_Empty, "") \
+  P(ExtDefList, ExtDefList, "ExtDef ExtDefList") \
+  P(ExtDef, ExtDef_Var, "Specifier ExtDecList SEMI") \
+  P(ExtDef, ExtDef_Struct, "Specifier SEMI") \
+  P(ExtDef, ExtDef_Func, "Specifier FunDec CompSt") \
+  P(ExtDecList, ExtDecList_VarDec, "VarDec") \
+  P(ExtDecList, ExtDecList, "VarDec COMMA ExtDecList") \
+  P(Specifier, Specifier_TYPE, "TYPE") \
+  P(Specifier, Specifier_Struct, "StructSpecifier") \
+  P(StructSpecifier, StructSpecifier_Def, "STRUCT OptTag LC DefList RC") \
+  P(StructSpecifier, StructSpecifier_Tag, "STRUCT Tag") \
+  P(OptTag, OptTag_Empty, "") \
+  P(OptTag, OptTag_ID, "ID") \
+  P(Tag, Tag_ID, "ID") \
+  P(VarDec, VarDec_ID, "ID") \
+  P(VarDec, VarDec_Array, "VarDec LB INT RB") \
+  P(FunDec, FunDec_Params, "ID LP VarList RP") \
+  P(FunDec, FunDec_Empty, "ID LP RP") \
+  P(VarList, VarList, "ParamDec COMMA VarList") \
+  P(VarList, VarList_ParamDec, "ParamDec") \
+  P(ParamDec, ParamDec, "Specifier VarDec") \
+  P(CompSt, CompSt, "LC DefList StmtList RC") \
+  P(StmtList, StmtList_Empty, "") \
+  P(StmtList, StmtList, "Stmt StmtList") \
+  P(Stmt, Stmt_Exp, "Exp SEMI") \
+  P(Stmt, Stmt_CompSt, "CompSt") \
+  P(Stmt, Stmt_Return, "RETURN Exp SEMI") \
+  P(Stmt, Stmt_If, "IF LP Exp RP Stmt") \
+  P(Stmt, Stmt_IfElse, "IF LP Exp RP Stmt ELSE Stmt") \
+  P(Stmt, Stmt_While, "WHILE LP Exp RP Stmt") \
+  P(DefList, DefList_Empty, "") \
+  P(DefList, DefList, "Def DefList") \
+  P(Def, Def, "Specifier DecList SEMI") \
+  P(DecList, DecList_Dec, "Dec") \
+  P(DecList, DecList, "Dec COMMA DecList") \
+  P(Dec, Dec_VarDec, "VarDec") \
+  P(Dec, Dec_Assign, "VarDec ASSIGNOP Exp") \
+  P(Exp, Exp_ASSIGNOP, "Exp ASSIGNOP Exp") \
+  P(Exp, Exp_AND, "Exp AND Exp") \
+  P(Exp, Exp_OR, "Exp OR Exp") \
+  P(Exp, Exp_RELOP, "Exp RELOP Exp") \
+  P(Exp, Exp_PLUS, "Exp PLUS Exp") \
+  P(Exp, Exp_MINUS, "Exp MINUS Exp") \
+  P(Exp, Exp_STAR, "Exp STAR Exp") \
+  P(Exp, Exp_DIV, "Exp DIV Exp") \
+  P(Exp, Exp_Paren, "LP Exp RP") \
+  P(Exp, Exp_Neg, "MINUS Exp") \
+  P(Exp, Exp_NOT, "NOT Exp") \
+  P(Exp, Exp_Call, "ID LP Args RP") \
+  P(Exp, Exp_CallEmpty, "ID LP RP") \
+  P(Exp, Exp_Index, "Exp LB Exp RB") \
+  P(Exp, Exp_DOT, "Exp DOT ID") \
+  P(Exp, Exp_ID, "ID") \
+  P(Exp, Exp_INT, "INT") \
+  P(Exp, Exp_FLOAT, "FLOAT") \
+  P(Args, Args, "Exp COMMA Args") \
+  P(Args, Args_Exp, "Exp")
+
+typedef enum {
+#define symbol_(s) S_##s,
+  TERMINALS(symbol_)
+  NON_TERMINALS(symbol_)
+#undef symbol_
+  SYMBOL_COUNT
+} SymbolKind;
+
+typedef enum {
+  P_NONE, // tokens aren't produced by any rule (bison's rule 0 is `$accept`)
+#define production_(lhs, p, rhs) P_##p,
+  PRODUCTIONS(production_)
+#undef production_
+  PRODUCTION_COUNT
+} Production;
 
 // Forward declaration of ParseTNode
 typedef struct ParseTNode ParseTNode;
@@ -29,14 +149,21 @@ typedef struct {
 } ArrayList;
 
 typedef union {
-  char *str_value; // id
+  InternId id; // ID, TYPE
+  Relop relop; // RELOP
   int int_value;
   float float_value;
 } ValueUnion;
 
+// map production to the index of the pattern it matches, -1 if none
+typedef struct {
+  _Atomic int state; // 0: not compiled, 1: being published by a thread, 2: ready
+  int8_t index[PRODUCTION_COUNT];
+} ExprMatcher;
+
 struct ParseTNode {
-  int flag; // 1: is token; 0: is higher expression
-  char *name;
+  SymbolKind kind;
+  Production production; // P_NONE for tokens
   int lineNum;
   ArrayList children;
   ValueUnion value;
@@ -44,16 +171,16 @@ struct ParseTNode {
 
 // PARSE_TREE Tree functions
 const ParseTNode* getRoot();
-ParseTNode* createParseTNode(const char *name, int lineNum, int flag);
-ParseTNode* createParseTNodeWithValue(const char *name, int lineNum, ValueUnion value);
+ParseTNode* createParseTNode(SymbolKind kind, Production production, int lineNum);
+ParseTNode* createParseTNodeWithValue(SymbolKind kind, int lineNum, ValueUnion value);
 void addChild(ParseTNode *parent, ParseTNode *child);
-void freeParseTNode(ParseTNode *node);
-void printParseTree(const ParseTNode *root);
+void printParseTree(FILE *out, const ParseTNode *root);
 void cleanParseTree();
 
 // utility function
-int nodeChildrenNamesEqual(const ParseTNode *node, const char *text);
-ParseTNode* getChildByName(const ParseTNode *parent, const char *name);
-int matchExprPattern(const ParseTNode *node, const char *expressions[], const int length);
+const char* symbolName(SymbolKind kind);
+ParseTNode* getChildByKind(const ParseTNode *parent, SymbolKind kind);
+int matchExprPattern(const ParseTNode *node, const char *expressions[], int length,
+                     ExprMatcher *matcher);
 
 #endif // PARSE_TREE
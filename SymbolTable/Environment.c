@@ -6,91 +6,209 @@
 #include "utils.h"
 #endif
 
-Environment* newEnvironment(Environment *parent, const EnvKind kind) {
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+#define ENV_INIT_SLOTS 64
+#define ENV_INIT_DEPTH 16
+
+/* every visible name owns a slot, which points to its innermost binding.
+ * a binding remembers the one it shadows, so leaving a scope only pops
+ * the bindings made since the scope was entered and restores the slots. */
+typedef struct {
+  uint32_t hash;
+  const char *name; // NULL marks an empty slot
+  int top;          // the innermost binding of name, -1 if none
+} EnvSlot;
+
+typedef struct {
+  const Data *data;
+  int depth;        // the scope where it was bound
+  int shadowed;     // the binding hidden by this one, -1 if none
+  size_t slot;
+} Binding;
+
+struct Environment {
+  EnvSlot *slots;
+  size_t slot_cnt, name_cnt; // slot_cnt is always a power of two
+  Binding *bindings;         // in binding order, it doubles as the undo log
+  int binding_cnt, binding_capacity;
+  // scope stack, `marks[d]` is the binding count when scope d was entered
+  EnvKind *kinds;
+  int *marks;
+  int depth, depth_capacity;
+};
+
+Environment* createEnvironment() {
   Environment *env = malloc(sizeof(Environment));
-  env->parent = parent;
-  env->vMap = createRedBlackTree();
-  env->kind = kind;
+  env->slot_cnt = ENV_INIT_SLOTS;
+  env->slots = malloc(sizeof(EnvSlot) * env->slot_cnt);
+  for (size_t i = 0; i < env->slot_cnt; ++i) env->slots[i] = (EnvSlot){.name = NULL, .top = -1};
+  env->name_cnt = 0;
+  env->binding_capacity = ENV_INIT_SLOTS;
+  env->bindings = malloc(sizeof(Binding) * env->binding_capacity);
+  env->binding_cnt = 0;
+  env->depth_capacity = ENV_INIT_DEPTH;
+  env->kinds = malloc(sizeof(EnvKind) * env->depth_capacity);
+  env->marks = malloc(sizeof(int) * env->depth_capacity);
+  env->depth = -1;
   return env;
 }
 
-/**
- * @return a pointer directly pointing to the data in map
-*/
-const Data* searchEntireScopeWithName(const Environment *currentEnv, const char *name) {
-  const Data *data = NULL;
-  while (currentEnv != NULL) {
-    data = searchWithName(currentEnv->vMap, name);
-    if (data != NULL) break;
-    currentEnv = currentEnv->parent;
-  }
-  return data;
-}
-
 void freeEnvironment(Environment *env) {
   assert(env != NULL);
-  freeRedBlackTree(env->vMap);
+  free(env->slots);
+  free(env->bindings);
+  free(env->kinds);
+  free(env->marks);
   free(env);
 }
 
 /**
- * @brief change the current environment back to its parent environment
- * @note the pointer of current environment will be changed after calling this function.
-*/
-void revertEnvironment(Environment **current) {
-  assert(current != NULL);
-  Environment *parent = (*current)->parent;
-  if (parent == NULL) {
+ * @brief the scope stack only grows when the program nests deeper than ever before,
+ * so entering a scope doesn't allocate in general.
+ */
+void enterScope(Environment *env, const EnvKind kind) {
+  if (++env->depth >= env->depth_capacity) {
+    env->depth_capacity *= 2;
+    env->kinds = realloc(env->kinds, sizeof(EnvKind) * env->depth_capacity);
+    env->marks = realloc(env->marks, sizeof(int) * env->depth_capacity);
+  }
+  env->kinds[env->depth] = kind;
+  env->marks[env->depth] = env->binding_cnt;
+}
+
+// undo every binding of the current scope
+void leaveScope(Environment *env) {
+  if (env->depth <= 0) {
     DEBUG_INFO("Can't revert global environment.\n");
     exit(EXIT_FAILURE);
   }
-  freeEnvironment(*current);
-  *current = parent;
+  const int mark = env->marks[env->depth];
+  while (env->binding_cnt > mark) {
+    const Binding *b = &env->bindings[--env->binding_cnt];
+    env->slots[b->slot].top = b->shadowed;
+  }
+  env->depth--;
+}
+
+EnvKind scopeKind(const Environment *env) {
+  assert(env->depth >= 0);
+  return env->kinds[env->depth];
+}
+
+// @return the slot of name; if it isn't there, the empty slot where it belongs.
+static size_t findSlot(const Environment *env, const char *name, const uint32_t h) {
+  const size_t mask = env->slot_cnt - 1;
+  size_t i = h & mask;
+  while (env->slots[i].name != NULL) {
+    const EnvSlot *slot = &env->slots[i];
+    if (slot->hash == h && (slot->name == name || strcmp(slot->name, name) == 0)) break;
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+static void growSlots(Environment *env) {
+  EnvSlot *old = env->slots;
+  const size_t old_cnt = env->slot_cnt;
+  env->slot_cnt *= 2;
+  env->slots = malloc(sizeof(EnvSlot) * env->slot_cnt);
+  for (size_t i = 0; i < env->slot_cnt; ++i) env->slots[i] = (EnvSlot){.name = NULL, .top = -1};
+  for (size_t i = 0; i < old_cnt; ++i) {
+    if (old[i].name == NULL) continue;
+    const size_t j = findSlot(env, old[i].name, old[i].hash);
+    env->slots[j] = old[i];
+    // the whole shadow chain of this name moves along
+    for (int b = old[i].top; b != -1; b = env->bindings[b].shadowed)
+      env->bindings[b].slot = j;
+  }
+  free(old);
 }
 
+/**
+ * @brief bind data to its name in the current scope, shadowing the outer ones.
+ * @note data is not copied, it should outlive the current scope.
+ */
+void bindInScope(Environment *env, const Data *data) {
+  assert(env->depth >= 0 && data != NULL);
+  const uint32_t h = hashString(data->name);
+  size_t i = findSlot(env, data->name, h);
+  if (env->slots[i].name == NULL) {
+    // keep the load factor under 1/2
+    if ((env->name_cnt + 1) * 2 > env->slot_cnt) {
+      growSlots(env);
+      i = findSlot(env, data->name, h);
+    }
+    env->slots[i] = (EnvSlot){.hash = h, .name = data->name, .top = -1};
+    env->name_cnt++;
+  }
+  if (env->binding_cnt >= env->binding_capacity) {
+    env->binding_capacity *= 2;
+    env->bindings = realloc(env->bindings, sizeof(Binding) * env->binding_capacity);
+  }
+  env->bindings[env->binding_cnt] = (Binding){
+    .data = data, .depth = env->depth, .shadowed = env->slots[i].top, .slot = i
+  };
+  env->slots[i].top = env->binding_cnt++;
+}
+
+/**
+ * @return a pointer directly pointing to the data of the innermost binding
+*/
+const Data* searchEntireScopeWithName(const Environment *env, const char *name) {
+  const EnvSlot *slot = &env->slots[findSlot(env, name, hashString(name))];
+  return slot->top == -1 ? NULL : env->bindings[slot->top].data;
+}
+
+// only look for the bindings of current scope
+const Data* searchCurrentScopeWithName(const Environment *env, const char *name) {
+  const EnvSlot *slot = &env->slots[findSlot(env, name, hashString(name))];
+  if (slot->top == -1) return NULL;
+  const Binding *b = &env->bindings[slot->top];
+  return b->depth == env->depth ? b->data : NULL;
+}
+
+#undef ENV_INIT_SLOTS
+#undef ENV_INIT_DEPTH
+
 /**
  * @brief versatile function: get the basic type of current node
  * @param basic_node must contain basic token(int or float).
- * @return copy of type
 */
 const Type* createBasicTypeOfNode(const ParseTNode *basic_node) {
   assert(basic_node != NULL);
-  if (strcmp(basic_node->name, "TYPE") == 0) { // specifier
-    const char *val = basic_node->value.str_value;
-    if (strcmp(val, "int") == 0) {
-      Type *rt_type = malloc(sizeof(Type));
-      rt_type->kind = INT;
-      return rt_type;
+  switch (basic_node->kind) {
+    case S_TYPE: { // specifier
+      const char *val = internedStr(basic_node->value.id);
+      if (strcmp(val, "int") == 0) return basicType(INT);
+      if (strcmp(val, "float") == 0) return basicType(FLOAT);
+      break;
     }
-    if (strcmp(val, "float") == 0) {
-      Type *rt_type = malloc(sizeof(Type));
-      rt_type->kind = FLOAT;
-      return rt_type;
-    }
-  } else if (strcmp(basic_node->name, "INT") == 0) { // expression
-    Type *t = malloc(sizeof(Type));
-    t->kind = INT;
-    return t;
-  } else if (strcmp(basic_node->name, "FLOAT") == 0) { // expression
-    Type *t = malloc(sizeof(Type));
-    t->kind = FLOAT;
-    return t;
+    case S_INT: // expression
+      return basicType(INT);
+    case S_FLOAT: // expression
+      return basicType(FLOAT);
+    default:
+      break;
   }
   fprintf(stderr, "basic_node:%s.\n"
-          "Wrong type! Should be 'int' or 'float'.\n", basic_node->name);
+          "Wrong type! Should be 'int' or 'float'.\n", symbolName(basic_node->kind));
   DEBUG_INFO("");
   exit(EXIT_FAILURE);
 }
 
 /**
- *  @brief copy and add struct type to the head of the linked list
+ *  @brief add struct type to the head of the linked list
  *  @note head will be changed after calling this function
- *  @warning remember to free type passed in after use
 */
 void addDefinedStruct(StructRegister **head, const Type *type) {
   assert(type->kind == STRUCT);
   StructRegister *reg = malloc(sizeof(StructRegister));
-  reg->structType = deepCopyType(type);
+  reg->structType = type;
   reg->next = *(head);
   *(head) = reg;
 }
@@ -115,21 +233,20 @@ void freeDefinedStructList(StructRegister *head) {
   while (head != NULL) {
     StructRegister *tmp = head;
     head = head->next;
-    freeType(tmp->structType);
     free(tmp);
   }
 }
 
 /**
  *  @brief add variable info to the head of gather
- *  all information will be copied
+ *  all information will be copied, except the interned name
  *  @note the pointing of head will be changed after calling this function
 */
 void gatherDecInfo(DecGather **head, const char *name,
                    const int dimension, const int size_list[], const int lineNum) {
   assert(name != NULL);
   DecGather *gather = malloc(sizeof(DecGather));
-  gather->name = my_strdup(name);
+  gather->name = name;
   gather->dimension = dimension;
   for (int i = 0; i < dimension; ++i) {
     gather->size_list[i] = size_list[i];
@@ -141,20 +258,14 @@ void gatherDecInfo(DecGather **head, const char *name,
 
 /**
  * @brief turn a single variable which is in the form of dec gather to type
- * @return a copy of type
+ * the outermost array comes first in size_list, so build from the innermost one.
 */
 const Type* turnDecGather2Type(const DecGather *gather, const Type *base_type) {
   assert(gather != NULL);
-  Type *type = NULL;
-  Type **t = &type;
-  for (int i = 0; i < gather->dimension; ++i) {
-    *t = malloc(sizeof(Type));
-    (*t)->kind = ARRAY;
-    (*t)->array.size = gather->size_list[i];
-    (*t)->array.elemType = NULL; // Initialize elemType to NULL
-    t = &(*t)->array.elemType;   // Update t to point to elemType
-  }
-  *t = (Type *) deepCopyType(base_type);
+  const Type *type = base_type;
+  for (int i = gather->dimension - 1; i >= 0; --i) {
+    type = arrayOf(type, gather->size_list[i]);
+  }
   return type;
 }
 
@@ -162,7 +273,6 @@ void freeDecGather(DecGather *head) {
   while (head != NULL) {
     DecGather *tmp = head;
     head = head->next;
-    free(tmp->name);
     free(tmp);
   }
 }
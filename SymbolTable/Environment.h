@@ -14,22 +14,19 @@
 
 typedef enum { GLOBAL, STRUCTURE, COMPOUND } EnvKind;
 
-typedef struct Environment {
-    EnvKind kind;
-    struct Environment *parent;
-    RedBlackTree *vMap; // stands for variable map
-} Environment;
+// every scope shares one table, see Environment.c
+typedef struct Environment Environment;
 
 // collect struct type and check whether they are defined
 typedef struct StructRegister {
-    Type *structType;
+    const Type *structType;
     struct StructRegister *next;
 } StructRegister;
 
 #define MAX_DIMENSION 10
 
 typedef struct DecGather {
-    char *name;
+    const char *name;             // interned
     int lineNum;
     int dimension;                // if dimension is zero, it is a variable; else an array
     int size_list[MAX_DIMENSION]; // only support max 10 dimension for array;
@@ -42,10 +39,14 @@ typedef struct ParamGather {
     struct ParamGather *next;
 } ParamGather;
 
-Environment* newEnvironment(Environment *parent, EnvKind kind);
-const Data* searchEntireScopeWithName(const Environment *env, const char *name);
+Environment* createEnvironment();
 void freeEnvironment(Environment *env);
-void revertEnvironment(Environment **current);
+void enterScope(Environment *env, EnvKind kind);
+void leaveScope(Environment *env);
+EnvKind scopeKind(const Environment *env);
+void bindInScope(Environment *env, const Data *data);
+const Data* searchEntireScopeWithName(const Environment *env, const char *name);
+const Data* searchCurrentScopeWithName(const Environment *env, const char *name);
 
 // utility functions
 const Type* createBasicTypeOfNode(const ParseTNode *basic_node);
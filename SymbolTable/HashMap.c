@@ -0,0 +1,120 @@
+/**
+ * Open addressing hash map from name to data, with linear probing.
+ * Every slot keeps the hash of its name, so a probe only touches the name
+ * string when the hashes agree. It is the default backend of `SymbolMap`,
+ * define SYMBOL_MAP_RBTREE to fall back to the red black tree in RBTree.c.
+ */
+#ifndef SYMBOL_MAP_RBTREE
+#ifdef LOCAL
+#include <RBTree.h>
+#include <utils.h>
+#else
+#include "utils.h"
+#include "RBTree.h"
+#endif
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+#define HASH_MAP_INIT_SLOTS 8
+
+typedef struct {
+  uint32_t hash;
+  Data *data; // NULL marks an empty slot
+} Slot;
+
+struct HashMap {
+  Slot *slots;
+  size_t slot_cnt; // always a power of two
+  size_t cnt;
+};
+
+static Slot* createSlots(const size_t slot_cnt) {
+  Slot *slots = calloc(slot_cnt, sizeof(Slot));
+  if (slots == NULL) {
+    DEBUG_INFO("fail to allocate hash map slots.\n");
+    exit(EXIT_FAILURE);
+  }
+  return slots;
+}
+
+// double the slots and re-place every data with its stored hash
+static void growHashMap(HashMap *map) {
+  Slot *old = map->slots;
+  const size_t old_cnt = map->slot_cnt;
+  map->slot_cnt *= 2;
+  map->slots = createSlots(map->slot_cnt);
+  const size_t mask = map->slot_cnt - 1;
+  for (size_t i = 0; i < old_cnt; ++i) {
+    if (old[i].data == NULL) continue;
+    size_t j = old[i].hash & mask;
+    while (map->slots[j].data != NULL) j = (j + 1) & mask;
+    map->slots[j] = old[i];
+  }
+  free(old);
+}
+
+HashMap* createSymbolMap() {
+  HashMap *map = malloc(sizeof(HashMap));
+  map->slot_cnt = HASH_MAP_INIT_SLOTS;
+  map->slots = createSlots(map->slot_cnt);
+  map->cnt = 0;
+  return map;
+}
+
+/**
+ * @brief insert data to the hash map
+ * @note data is not deep copied. Instead, simply pointing to it.
+ * Like the red black tree, a duplicated name is kept; lookups find the earlier one.
+*/
+void insert(HashMap *map, Data *data) {
+  assert(map != NULL && data != NULL);
+  // keep the load factor under 1/2
+  if ((map->cnt + 1) * 2 > map->slot_cnt) growHashMap(map);
+
+  const uint32_t h = hashString(data->name);
+  const size_t mask = map->slot_cnt - 1;
+  size_t i = h & mask;
+  while (map->slots[i].data != NULL) i = (i + 1) & mask;
+  map->slots[i] = (Slot){.hash = h, .data = data};
+  map->cnt++;
+}
+
+/**
+ * @brief probe from the home slot of the name, nothing is allocated.
+ * @return the data (no copy) if found; else NULL.
+ */
+const Data* searchWithName(const HashMap *map, const char *name) {
+  assert(map != NULL && name != NULL);
+  const uint32_t h = hashString(name);
+  const size_t mask = map->slot_cnt - 1;
+  for (size_t i = h & mask; map->slots[i].data != NULL; i = (i + 1) & mask) {
+    const Slot *slot = &map->slots[i];
+    if (slot->hash != h) continue;
+    // names are usually interned, so the pointers are likely to be equal
+    if (slot->data->name == name || strcmp(slot->data->name, name) == 0)
+      return slot->data;
+  }
+  return NULL;
+}
+
+// print every data, in slot order
+void inorder(const HashMap *map) {
+  for (size_t i = 0; i < map->slot_cnt; ++i) {
+    if (map->slots[i].data != NULL) dataToString(map->slots[i].data);
+  }
+}
+
+void freeSymbolMap(HashMap *map) {
+  for (size_t i = 0; i < map->slot_cnt; ++i) {
+    if (map->slots[i].data != NULL) freeData(map->slots[i].data);
+  }
+  free(map->slots);
+  free(map);
+}
+
+#undef HASH_MAP_INIT_SLOTS
+#endif
@@ -12,7 +12,14 @@ This code is provided by @author costheta_z
 #include "RBTree.h"
 #endif
 
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
 ///// Red Black Tree /////////////////////////////////////////
+#ifdef SYMBOL_MAP_RBTREE
 // Node structure for the Red-Black Tree
 typedef struct Node {
   Data *data;
@@ -31,8 +38,12 @@ struct RedBlackTree {
  *@return negative if n1 < data
  *@return zero     if n1 = data
 */
+static int nodeCompareWithName(const Node *n1, const char *name) {
+  return strcmp(n1->data->name, name);
+}
+
 static int nodeCompareWithData(const Node *n1, const Data *data) {
-  return strcmp(n1->data->name, data->name);
+  return nodeCompareWithName(n1, data->name);
 }
 
 // Utility function to create a new node
@@ -133,19 +144,8 @@ static void inorderHelper(const Node *node, Node *NIL) {
   }
 }
 
-// Search helper function
-static Node* searchHelper(Node *node, Data *data, Node *NIL) {
-  if (node == NIL || nodeCompareWithData(node, data) == 0) {
-    return node;
-  }
-  if (nodeCompareWithData(node, data) > 0) {
-    return searchHelper(node->left, data, NIL);
-  }
-  return searchHelper(node->right, data, NIL);
-}
-
 // Constructor or Red Black Tree
-RedBlackTree* createRedBlackTree() {
+RedBlackTree* createSymbolMap() {
   RedBlackTree *tree = malloc(sizeof(RedBlackTree));
   tree->NIL = createNode(NULL, NULL);
   strcpy(tree->NIL->color, "BLACK");
@@ -201,55 +201,41 @@ void inorder(const RedBlackTree *tree) {
   inorderHelper(tree->root, tree->NIL);
 }
 
-// Search function
-static Node* search(const RedBlackTree *tree, Data *data) {
-  return searchHelper(tree->root, data, tree->NIL);
-}
-
+/**
+ * @brief walk down the tree comparing the key directly, nothing is allocated.
+ * @return the data (no copy) if found; else NULL.
+ */
 const Data* searchWithName(const RedBlackTree *tree, const char *name) {
-  assert(tree != NULL);
-  Data *data = malloc(sizeof(Data));
-  data->name = my_strdup(name);
-  const Data *rst = search(tree, data)->data;
-  free(data);
-  return rst;
+  assert(tree != NULL && name != NULL);
+  const Node *node = tree->root;
+  while (node != tree->NIL) {
+    const int cmp = nodeCompareWithName(node, name);
+    if (cmp == 0) return node->data;
+    node = cmp > 0 ? node->left : node->right;
+  }
+  return NULL;
 }
 
-///// utilities functions of free ////////////////////////////
-static void freeStructFieldElement(structFieldElement *e) {
-  while (e != NULL) {
-    structFieldElement *tmp = e;
-    e = e->next;
-    free(tmp->name);
-    freeType(tmp->elemType);
-    free(tmp);
+// Helper function to free nodes
+static void freeNodes(Node *node, Node *NIL) {
+  if (node != NIL) {
+    freeNodes(node->left, NIL);
+    freeNodes(node->right, NIL);
+    freeData(node->data);
+    free(node);
   }
 }
 
-void freeType(Type *t) {
-  if (t == NULL) {
-    DEBUG_INFO("Can't free a null pointer.\n");
-    exit(EXIT_FAILURE);
-  }
-  switch (t->kind) {
-    case INT:
-    case FLOAT:
-    case ERROR:
-      break;
-    case ARRAY:
-      freeType(t->array.elemType);
-      break;
-    case STRUCT:
-      free(t->structure.struct_name);
-      freeStructFieldElement(t->structure.fields);
-      break;
-    default:
-      DEBUG_INFO("false type to free.\n");
-      exit(EXIT_FAILURE);
-  }
-  free(t);
+// Function to free the Red-Black Tree
+void freeSymbolMap(RedBlackTree *tree) {
+  freeNodes(tree->root, tree->NIL);
+  free(tree->NIL);
+  free(tree);
 }
+#endif
 
+///// utilities functions of free ////////////////////////////
+// types belong to the type table, only the data itself and its argument list are freed
 void freeData(Data *d) {
   if (d == NULL) {
     DEBUG_INFO("Can't free null Data.\n");
@@ -257,40 +243,17 @@ void freeData(Data *d) {
   }
   switch (d->kind) {
     case VAR:
-      freeType(d->variable.type);
       break;
     case FUNC:
-      freeType(d->function.returnType);
-      for (int i = 0; i < d->function.argc; ++i) {
-        freeType(d->function.argvTypes[i]);
-      }
       free(d->function.argvTypes);
       break;
     default:
       DEBUG_INFO("false type to free.\n");
       exit(EXIT_FAILURE);
   }
-  free(d->name);
   free(d);
 }
 
-// Helper function to free nodes
-static void freeNodes(Node *node, Node *NIL) {
-  if (node != NIL) {
-    freeNodes(node->left, NIL);
-    freeNodes(node->right, NIL);
-    freeData(node->data);
-    free(node);
-  }
-}
-
-// Function to free the Red-Black Tree
-void freeRedBlackTree(RedBlackTree *tree) {
-  freeNodes(tree->root, tree->NIL);
-  free(tree->NIL);
-  free(tree);
-}
-
 ///// print helpers //////////////////////////////////////////
 /**
  * @brief turn Type into string
@@ -344,99 +307,224 @@ const char* dataToString(const Data *data) {
 // utility functions
 /**
  * @brief check two types are the same or not
+ * arrays only need the same dimension and base type, their sizes don't matter.
  * @return 1 if same; 0 distinct.
 */
 int typeEqual(const Type *t1, const Type *t2) {
   assert(t1 != NULL && t2 != NULL);
   assert(t1->kind != ERROR && t2->kind != ERROR);
-  if (t1->kind != t2->kind) {
-    return 0;
-  } // t1->kind == t2->kind
-  if (t1->kind == INT || t1->kind == FLOAT) {
-    return 1;
-  }
-  if (t1->kind == ARRAY) {
-    Type *base1 = NULL;
-    Type *base2 = NULL;
-    const int d1 = getArrayDimension(t1, &base1);
-    const int d2 = getArrayDimension(t2, &base2);
-    if (d1 != d2) {
-      return 0;
-    }
-    const int rst = typeEqual(base1, base2);
-    freeType(base1);
-    freeType(base2);
-    return rst;
-  } // t1->kind == STRUCT
-  return strcmp(t1->structure.struct_name, t2->structure.struct_name) == 0;
+  if (t1 == t2) return 1;
+  return t1->kind == ARRAY && t2->kind == ARRAY &&
+         t1->array.dimension == t2->array.dimension &&
+         t1->array.base == t2->array.base;
 }
 
-static structFieldElement* deepCopyFieldElement(const structFieldElement *src) {
-  if (src == NULL) {
-    return NULL;
+const Data* deepCopyData(const Data *src) {
+  assert(src != NULL);
+  Data *dst = malloc(sizeof(Data));
+  *dst = *src;
+  if (src->kind == FUNC) {
+    const int argc = src->function.argc;
+    dst->function.argvTypes = malloc(sizeof(Type *) * argc);
+    memcpy(dst->function.argvTypes, src->function.argvTypes, sizeof(Type *) * argc);
   }
-  structFieldElement *dst = malloc(sizeof(structFieldElement));
-  dst->name = my_strdup(src->name);
-  dst->elemType = deepCopyType(src->elemType);
-  dst->next = deepCopyFieldElement(src->next);
   return dst;
 }
 
-const Type* deepCopyType(const Type *src) {
-  assert(src != NULL);
-  Type *dst = malloc(sizeof(Type));
-  dst->kind = src->kind;
-  if (src->kind == ARRAY) {
-    dst->array.size = src->array.size;
-    dst->array.elemType = deepCopyType(src->array.elemType);
-  } else if (src->kind == STRUCT) {
-    dst->structure.struct_name = my_strdup(src->structure.struct_name);
-    dst->structure.fields = deepCopyFieldElement(src->structure.fields);
+///// Type table /////////////////////////////////////////////
+#define TYPE_TABLE_INIT_SLOTS 64
+
+static const Type basicTypes[] = {
+  [INT] = {.kind = INT, .bytes = 4},
+  [FLOAT] = {.kind = FLOAT, .bytes = 4},
+  [ERROR] = {.kind = ERROR, .bytes = 0},
+};
+
+// every context owns a type table, types are released together with it
+struct TypeTable {
+  Arena *arena;       // every array type, struct type and field lives here
+  const Type **slots; // hash-consed array types, NULL marks an empty slot
+  size_t slot_cnt, cnt;
+};
+
+static struct TypeTable* currentTypeTable() {
+  CompilerContext *ctx = currentContext();
+  assert(ctx != NULL);
+  if (ctx->types == NULL) ctx->types = calloc(1, sizeof(struct TypeTable));
+  return ctx->types;
+}
+
+static size_t hashArrayType(const Type *elemType, const int size) {
+  const uint64_t h = (uint64_t) (uintptr_t) elemType * 0x9E3779B97F4A7C15ull ^ (uint32_t) size;
+  return (size_t) (h ^ h >> 29);
+}
+
+static void* typeTableAlloc(const size_t size) {
+  struct TypeTable *typeTable = currentTypeTable();
+  if (typeTable->arena == NULL) typeTable->arena = createArena(4 * 1024);
+  return arenaAlloc(typeTable->arena, size);
+}
+
+static void growTypeSlots(struct TypeTable *typeTable) {
+  const Type **old = typeTable->slots;
+  const size_t old_cnt = typeTable->slot_cnt;
+  typeTable->slot_cnt = old_cnt == 0 ? TYPE_TABLE_INIT_SLOTS : old_cnt * 2;
+  typeTable->slots = calloc(typeTable->slot_cnt, sizeof(Type *));
+  assert(typeTable->slots != NULL);
+  const size_t mask = typeTable->slot_cnt - 1;
+  for (size_t i = 0; i < old_cnt; ++i) {
+    if (old[i] == NULL) continue;
+    size_t j = hashArrayType(old[i]->array.elemType, old[i]->array.size) & mask;
+    while (typeTable->slots[j] != NULL) j = (j + 1) & mask;
+    typeTable->slots[j] = old[i];
   }
-  return dst;
+  free(old);
 }
 
-const Data* deepCopyData(const Data *src) {
-  assert(src != NULL);
-  Data *dst = malloc(sizeof(Data));
-  dst->name = my_strdup(src->name);
-  dst->kind = src->kind;
-  if (src->kind == VAR) {
-    dst->variable.type = deepCopyType(src->variable.type);
-  } else if (src->kind == FUNC) {
-    dst->function.returnType = deepCopyType(src->function.returnType);
-    const int argc = src->function.argc;
-    dst->function.argc = argc;
-    dst->function.argvTypes = malloc(sizeof(Type *) * argc);
-    for (int i = 0; i < argc; ++i) {
-      dst->function.argvTypes[i] = deepCopyType(src->function.argvTypes[i]);
-    }
+// @param kind one of INT, FLOAT and ERROR
+const Type* basicType(const int kind) {
+  assert(kind == INT || kind == FLOAT || kind == ERROR);
+  return &basicTypes[kind];
+}
+
+// @return the only array type of `size` elements of `elemType`
+const Type* arrayOf(const Type *elemType, const int size) {
+  assert(elemType != NULL);
+  struct TypeTable *typeTable = currentTypeTable();
+  // keep the load factor under 1/2
+  if ((typeTable->cnt + 1) * 2 > typeTable->slot_cnt) growTypeSlots(typeTable);
+  const size_t mask = typeTable->slot_cnt - 1;
+  size_t i = hashArrayType(elemType, size) & mask;
+  while (typeTable->slots[i] != NULL) {
+    const Type *t = typeTable->slots[i];
+    if (t->array.elemType == elemType && t->array.size == size) return t;
+    i = (i + 1) & mask;
   }
-  return dst;
+  Type *t = typeTableAlloc(sizeof(Type));
+  t->kind = ARRAY;
+  t->bytes = size * elemType->bytes;
+  t->array.elemType = elemType;
+  t->array.size = size;
+  if (elemType->kind == ARRAY) {
+    t->array.dimension = elemType->array.dimension + 1;
+    t->array.base = elemType->array.base;
+  } else {
+    t->array.dimension = 1;
+    t->array.base = elemType;
+  }
+  typeTable->slots[i] = t;
+  typeTable->cnt++;
+  return t;
+}
+
+// a field of a struct that is about to be defined by `structOf`
+structFieldElement* newStructField(const char *name, const Type *elemType) {
+  structFieldElement *f = typeTableAlloc(sizeof(structFieldElement));
+  f->name = name;
+  f->elemType = elemType;
+  f->next = NULL;
+  return f;
 }
 
 /**
- * @brief get array dimension and may get base_type as well
- * @param arrayType
- * @param base_type if set to NULL, nothing will happen;
- *                  if not null while it's pointing to NULL, then tie a new copy of base type.
- * @return the dimension of array type
-*/
-int getArrayDimension(const Type *arrayType, Type **base_type) {
-  assert(arrayType != NULL);
-  int dimension = 0;
-  while (arrayType->kind == ARRAY) {
-    dimension++;
-    arrayType = arrayType->array.elemType;
+ * @brief define a new struct type, structs are equal only to themselves.
+ * lay the fields out one after another and hash them by name, once per definition.
+ * @param fields made by `newStructField`, their names should be distinct
+ */
+const Type* structOf(const char *struct_name, structFieldElement *fields) {
+  Type *t = typeTableAlloc(sizeof(Type));
+  t->kind = STRUCT;
+  t->structure.struct_name = struct_name;
+  t->structure.fields = fields;
+
+  int cnt = 0;
+  unsigned offset = 0;
+  for (structFieldElement *f = fields; f != NULL; f = f->next) {
+    f->index = cnt++;
+    f->offset = offset;
+    offset += f->elemType->bytes;
+  }
+  t->bytes = offset;
+
+  // keep the load factor under 1/2
+  unsigned slot_cnt = 4;
+  while (slot_cnt < 2 * (unsigned) cnt) slot_cnt *= 2;
+  const structFieldElement **slots = typeTableAlloc(sizeof(structFieldElement *) * slot_cnt);
+  memset(slots, 0, sizeof(structFieldElement *) * slot_cnt);
+  for (const structFieldElement *f = fields; f != NULL; f = f->next) {
+    size_t i = hashString(f->name) & (slot_cnt - 1);
+    while (slots[i] != NULL) i = (i + 1) & (slot_cnt - 1);
+    slots[i] = f;
   }
-  if (base_type != NULL) {
-    assert(*base_type == NULL);                    // *base_type should be initialized to NULL
-    *base_type = (Type *) deepCopyType(arrayType); // suppress warning
+  t->structure.slots = slots;
+  t->structure.slot_cnt = slot_cnt;
+  return t;
+}
+
+// @return the field of struct with its layout if found; else NULL.
+const structFieldElement* findStructField(const Type *structType, const char *name) {
+  assert(structType != NULL && structType->kind == STRUCT);
+  const unsigned mask = structType->structure.slot_cnt - 1;
+  const structFieldElement **slots = structType->structure.slots;
+  for (size_t i = hashString(name) & mask; slots[i] != NULL; i = (i + 1) & mask) {
+    if (slots[i]->name == name || strcmp(slots[i]->name, name) == 0) return slots[i];
   }
-  return dimension;
+  return NULL;
+}
+
+void freeTypeTable() {
+  CompilerContext *ctx = currentContext();
+  if (ctx->types == NULL) return;
+  freeArena(ctx->types->arena);
+  free(ctx->types->slots);
+  free(ctx->types);
+  ctx->types = NULL;
 }
 
+#undef TYPE_TABLE_INIT_SLOTS
+
 #ifdef RBTREE_test
-int main() {
+#include <time.h>
+
+#define NAME_LEN 16
+// benchmark `searchWithName`: build a map of n variables, then look up m random names.
+int main(const int argc, char const *argv[]) {
+  const int n = argc > 1 ? atoi(argv[1]) : 100000;
+  const int m = argc > 2 ? atoi(argv[2]) : 10000000;
+  assert(n > 0 && m > 0);
+  // one extra slot for a key which is never inserted
+  char (*names)[NAME_LEN] = malloc(sizeof(*names) * (n + 1));
+  SymbolMap *map = createSymbolMap();
+  for (int i = 0; i < n; ++i) {
+    snprintf(names[i], NAME_LEN, "v%d", i);
+    Data *d = malloc(sizeof(Data));
+    d->name = names[i];
+    d->kind = VAR;
+    d->variable.type = basicType(INT);
+    insert(map, d);
+  }
+  snprintf(names[n], NAME_LEN, "missing");
+
+  srand(0);
+  int found = 0;
+  struct timespec begin, end;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  for (int i = 0; i < m; ++i) {
+    found += searchWithName(map, names[rand() % (n + 1)]) != NULL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  const double seconds = (double) (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+#ifdef SYMBOL_MAP_RBTREE
+  printf("backend: red black tree\n");
+#else
+  printf("backend: hash map\n");
+#endif
+  printf("symbols: %d, lookups: %d, hits: %d\n", n, m, found);
+  printf("%.3f s, %.0f lookups/s\n", seconds, m / seconds);
+
+  freeSymbolMap(map);
+  free(names);
+  return 0;
 }
+#undef NAME_LEN
 #endif
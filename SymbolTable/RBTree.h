@@ -6,65 +6,87 @@ typedef struct Type Type;
 typedef struct structFieldElement structFieldElement;
 typedef struct Data Data;
 typedef struct RedBlackTree RedBlackTree;
+typedef struct HashMap HashMap;
+// the map from name to data, backed by HashMap.c unless SYMBOL_MAP_RBTREE is defined
+#ifdef SYMBOL_MAP_RBTREE
+typedef RedBlackTree SymbolMap;
+#else
+typedef HashMap SymbolMap;
+#endif
 
 // function declaration
-RedBlackTree* createRedBlackTree();
-void insert(RedBlackTree *tree, Data *data);
-const Data* searchWithName(const RedBlackTree *tree, const char *name);
-void freeRedBlackTree(RedBlackTree *tree);
+SymbolMap* createSymbolMap();
+void insert(SymbolMap *map, Data *data);
+const Data* searchWithName(const SymbolMap *map, const char *name);
+void freeSymbolMap(SymbolMap *map);
 // debug utilities
 const char* typeToString(const Type *type);
 const char* dataToString(const Data *data);
-void inorder(const RedBlackTree *tree);
+void inorder(const SymbolMap *map);
 
 // utility function
-void freeType(Type *t);
 void freeData(Data *d);
-const Type* deepCopyType(const Type *src);
 const Data* deepCopyData(const Data *src);
 int typeEqual(const Type *t1, const Type *t2);
-int getArrayDimension(const Type *arrayType, Type **base_type);
+
+// type table: every Type is interned and immutable, so it is shared rather than copied or freed
+const Type* basicType(int kind);
+const Type* arrayOf(const Type *elemType, int size);
+structFieldElement* newStructField(const char *name, const Type *elemType);
+const Type* structOf(const char *struct_name, structFieldElement *fields);
+const structFieldElement* findStructField(const Type *structType, const char *name);
+void freeTypeTable();
 
 
 // type definition
+// every name below is interned, so it is shared rather than copied or freed
 struct structFieldElement {
-  char *name;
-  Type *elemType;
+  const char *name;
+  const Type *elemType;
+  // layout, filled in by `structOf`
+  int index;       // the order of declaration
+  unsigned offset; // in bytes, from the beginning of struct
   structFieldElement *next;
 };
 
 struct Type {
   enum { INT, FLOAT, ARRAY, STRUCT, ERROR } kind;
+  unsigned bytes; // the size of a value of this type, no alignment needed
 
   // error is the most generic type and only use when resolve expression 'resolveExp SymbolTable.c'
   union {
     // array needs element type and size
     struct {
-      Type *elemType;
+      const Type *elemType;
       int size;
+      int dimension;    // the number of nested arrays, this one included
+      const Type *base; // the innermost type which is not an array
     } array;
 
+    // each definition of struct is a type of its own
     struct {
-      char *struct_name;
-      structFieldElement *fields;
+      const char *struct_name;
+      const structFieldElement *fields;  // in the order of declaration
+      const structFieldElement **slots; // fields hashed by name, NULL marks an empty slot
+      unsigned slot_cnt;                 // always a power of two
     } structure;
   };
 };
 
 struct Data {
-  char *name;
+  const char *name;
 
   enum { VAR, FUNC } kind;
 
   union {
     struct {
-      Type *type;
+      const Type *type;
     } variable;
 
     struct {
-      Type *returnType;
+      const Type *returnType;
       int argc;
-      Type **argvTypes;
+      const Type **argvTypes;
     } function;
   };
 };
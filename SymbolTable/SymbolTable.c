@@ -6,24 +6,41 @@
 #include "utils.h"
 #endif
 
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+// table->vars owns the data, the current scope only refers to it
 #define INSERT_VAR(data) \
   do {\
-    insert(currentEnv->vMap, deepCopyData(data));\
-    insert(table->vars, data);\
+    Data *d_ = (Data *) (data);\
+    insert(table->vars, d_);\
+    bindInScope(currentEnv, d_);\
   } while(false)
 
-SymbolTable *table = NULL;
-Environment *currentEnv = NULL;
+// the state of `buildTable`, each thread resolves its own file
+static _Thread_local SymbolTable *table = NULL;
+static _Thread_local Environment *currentEnv = NULL;
 // register all defined functions
 // RedBlackTree *funcMap = NULL;
 // a linked list registers those defined struct type
-StructRegister *definedStructList = NULL;
+static _Thread_local StructRegister *definedStructList = NULL;
+
+// generate a random name for anonymous structures and clashing parameters
+static const char* internRandomName(const char *suffix) {
+  const char *random = randomString(5, suffix);
+  const char *name = internedStr(intern(random));
+  free((char *) random);
+  return name;
+}
 
 static const Type* resolveExp(const ParseTNode *node);
 /**
  * @brief helper function for 'resolveExp'
  * @warning may return ERROR type
- * @return a copy of type of expression
+ * @return the interned type of expression
 */
 static const Type* evalBinaryOperator(const ParseTNode *node) {
   const char *expressions[] = {
@@ -40,57 +57,33 @@ static const Type* evalBinaryOperator(const ParseTNode *node) {
   const Type *type1 = resolveExp(getChild(node, 0));
   if (type1->kind == ERROR) return type1;
   const Type *type2 = resolveExp(getChild(node, 2));
-  if (type2->kind == ERROR) {
-    freeType((Type *) type1);
-    return type2;
-  }
+  if (type2->kind == ERROR) return type2;
   if (i == 0) { // assignment
     if (!typeEqual(type1, type2)) {
-      const int lineNum = getChildByName(node, "ASSIGNOP")->lineNum;
+      const int lineNum = getChildByKind(node, S_ASSIGNOP)->lineNum;
       error(5, lineNum, "Type mismatched for assignment.\n");
-      freeType((Type *) type1);
-      freeType((Type *) type2);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
-    if (!(nodeChildrenNamesEqual(getChild(node, 0), "ID") ||
-          nodeChildrenNamesEqual(getChild(node, 0), "Exp LB Exp RB") ||
-          nodeChildrenNamesEqual(getChild(node, 0), "Exp DOT ID"))) {
-      const int lineNum = getChildByName(node, "ASSIGNOP")->lineNum;
+    if (!in(getChild(node, 0)->production, 3, P_Exp_ID, P_Exp_Index, P_Exp_DOT)) {
+      const int lineNum = getChildByKind(node, S_ASSIGNOP)->lineNum;
       error(6, lineNum, "The left-hand side of an assignment must be a variable.\n");
-      freeType((Type *) type1);
-      freeType((Type *) type2);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
-    freeType((Type *) type1);
     return type2;
   }
   if (1 <= i && i <= 3) { // logical operations
     if (type1->kind != INT || type2->kind != INT) {
       const int lineNum = getChild(node, 1)->lineNum;
       error(7, lineNum, "Type mismatched for operands.\n");
-      freeType((Type *) type1);
-      freeType((Type *) type2);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
-    freeType((Type *) type1);
     return type2;
   } // arithmatic operations: 4 <= i && i <= 7
   if (!((type1->kind == INT || type1->kind == FLOAT) && typeEqual(type1, type2))) {
     const int lineNum = getChild(node, 1)->lineNum;
     error(7, lineNum, "Type mismatched for operands.\n");
-    freeType((Type *) type1);
-    freeType((Type *) type2);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
-  freeType((Type *) type1);
   return type2;
 }
 
@@ -99,7 +92,7 @@ static void resolveArgs(const ParseTNode *node, ParamGather **gather);
 /**
  * @brief helper function for 'resolveExp'
  * @warning may return ERROR type
- * @return a copy of type of function's return type.
+ * @return the type of function's return type.
 */
 static const Type* evalFuncInvocation(const ParseTNode *node) {
   const char *expressions[] = {
@@ -107,26 +100,22 @@ static const Type* evalFuncInvocation(const ParseTNode *node) {
     "ID LP RP"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  const ParseTNode *child = getChildByName(node, "ID");
-  const char *name = child->value.str_value;
+  const ParseTNode *child = getChildByKind(node, S_ID);
+  const char *name = internedStr(child->value.id);
   const int lineNum = child->lineNum;
   if (searchEntireScopeWithName(currentEnv, name) != NULL) {
     error(11, lineNum, "\"%s\" is not a function.\n", name);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
   const Data *data = searchWithName(table->funcs, name);
   if (data == NULL) { // not find function definition
     error(2, lineNum, "Undefined function \"%s\".\n", name);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
   assert(data->kind == FUNC);
   if (i == 0) { // deal with args
     ParamGather *gather = NULL;
-    resolveArgs(getChildByName(node, "Args"), &gather);
+    resolveArgs(getChildByKind(node, S_Args), &gather);
     assert(gather != NULL);
     // reverse gather because it adds from head
     reverseParamGather(&gather);
@@ -138,55 +127,41 @@ static const Type* evalFuncInvocation(const ParseTNode *node) {
     }
     freeParamGather(gather);
   }
-  return deepCopyType(data->function.returnType);
+  return data->function.returnType;
 }
 
 /**
  * @brief helper function for 'resolveExp'
  * @warning may return ERROR type
- * @return a copy of element type in struct.
+ * @return the type of field in struct.
 */
 static const Type* evalStruct(const ParseTNode *node) {
   const char *expressions[] = {
     "Exp DOT ID"
   };
   assert(EXPRESSION_INDEX(node, expressions) == 0);
-  const Type *expType = resolveExp(getChildByName(node, "Exp"));
+  const Type *expType = resolveExp(getChildByKind(node, S_Exp));
   if (expType->kind == ERROR) return expType;
   if (expType->kind != STRUCT) {
-    const int lineNum = getChildByName(node, "DOT")->lineNum;
+    const int lineNum = getChildByKind(node, S_DOT)->lineNum;
     error(13, lineNum, "Illegal use of \".\".\n");
-    freeType((Type *) expType);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
   // get the name of identifier
   const char *name = getStrFrom(node, ID);
-  // loop through the field of struct
-  const structFieldElement *f = expType->structure.fields;
-  while (f != NULL) {
-    if (strcmp(f->name, name) == 0) break;
-    f = f->next;
-  }
+  const structFieldElement *f = findStructField(expType, name);
   if (f == NULL) {
-    const int lineNum = getChildByName(node, "DOT")->lineNum;
+    const int lineNum = getChildByKind(node, S_DOT)->lineNum;
     error(14, lineNum, "Non-existent field \"%s\".\n", name);
-    freeType((Type *) expType);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
-  assert(strcmp(f->name, name) == 0);
-  const Type *copy = deepCopyType(f->elemType);
-  freeType((Type *) expType);
-  return copy;
+  return f->elemType;
 }
 
 /**
  * @brief helper function for 'resolveExp'
  * @warning may return ERROR type
- * @return a copy of element type in struct.
+ * @return the element type of array.
 */
 static const Type* evalArray(const ParseTNode *node) {
   const char *expressions[] = {
@@ -198,34 +173,24 @@ static const Type* evalArray(const ParseTNode *node) {
   if (first->kind == ERROR) return first;
   if (first->kind != ARRAY) {
     error(10, firstExp->lineNum, "is not an array.\n");
-    freeType((Type *) first);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
   const ParseTNode *secondExp = getChild(node, 2);
   const Type *second = resolveExp(secondExp);
   if (second->kind != INT) {
     error(12, secondExp->lineNum, "is not an integer.\n");
-    freeType((Type *) first);
-    freeType((Type *) second);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
-  const Type *rst = deepCopyType(first->array.elemType);
-  freeType((Type *) first);
-  freeType((Type *) second);
-  return rst;
+  return first->array.elemType;
 }
 
 /**
  * @warning may return ERROR type
- * @return a copy of type for this expression
+ * @return the interned type for this expression, nothing is allocated
 */
 static const Type* resolveExp(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Exp") == 0);
+  assert(node->kind == S_Exp);
   const char *expressions[] = {
     [0] = "Exp ASSIGNOP Exp",
     [1] = "Exp AND Exp",
@@ -248,30 +213,24 @@ static const Type* resolveExp(const ParseTNode *node) {
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i <= 7) return evalBinaryOperator(node);
-  if (i == 8) return resolveExp(getChildByName(node, "Exp"));
+  if (i == 8) return resolveExp(getChildByKind(node, S_Exp));
   if (i == 9) {
-    const Type *expType = resolveExp(getChildByName(node, "Exp"));
+    const Type *expType = resolveExp(getChildByKind(node, S_Exp));
     if (expType->kind == ERROR) return expType;
     if (!(expType->kind == INT || expType->kind == FLOAT)) {
-      const int lineNum = getChildByName(node, "MINUS")->lineNum;
+      const int lineNum = getChildByKind(node, S_MINUS)->lineNum;
       error(7, lineNum, "Type mismatched for operands.\n");
-      freeType((Type *) expType);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
     return expType;
   }
   if (i == 10) {
-    const Type *expType = resolveExp(getChildByName(node, "Exp"));
+    const Type *expType = resolveExp(getChildByKind(node, S_Exp));
     if (expType->kind == ERROR) return expType;
     if (expType->kind != INT) {
-      const int lineNum = getChildByName(node, "NOT")->lineNum;
+      const int lineNum = getChildByKind(node, S_NOT)->lineNum;
       error(7, lineNum, "Type mismatched for operands.\n");
-      freeType((Type *) expType);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
     return expType;
   }
@@ -280,17 +239,15 @@ static const Type* resolveExp(const ParseTNode *node) {
   if (i == 14) return evalStruct(node);
   if (i == 15) {
     const char *name = getStrFrom(node, ID);
-    assert(currentEnv->kind == COMPOUND || currentEnv->kind == GLOBAL); // not in struct env
+    assert(scopeKind(currentEnv) == COMPOUND || scopeKind(currentEnv) == GLOBAL); // not in struct env
     const Data *d = searchEntireScopeWithName(currentEnv, name);
     if (d == NULL) {
-      const int lineNum = getChildByName(node, "ID")->lineNum;
+      const int lineNum = getChildByKind(node, S_ID)->lineNum;
       error(1, lineNum, "Undefined variable \"%s\".\n", name);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
     assert(d->kind == VAR);
-    return deepCopyType(d->variable.type);
+    return d->variable.type;
   }
   if (i == 16 || i == 17) return createBasicTypeOfNode(getChild(node, 0));
 }
@@ -298,23 +255,23 @@ static const Type* resolveExp(const ParseTNode *node) {
 // simply gather all arguments, regardless is error or not.
 static void resolveArgs(const ParseTNode *node, ParamGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Args") == 0);
+  assert(node->kind == S_Args);
   const char *expressions[] = {
     "Exp",
     "Exp COMMA Args"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  const Type *expType = resolveExp(getChildByName(node, "Exp"));
+  const Type *expType = resolveExp(getChildByKind(node, S_Exp));
   // temporary data
   Data *data = malloc(sizeof(Data));
   data->kind = VAR;
-  data->name = my_strdup("");
-  data->variable.type = (Type *) expType; // directly pointing to expType, so no need to free
-  const int lineNum = getChildByName(node, "Exp")->lineNum;
+  data->name = internedStr(intern(""));
+  data->variable.type = expType;
+  const int lineNum = getChildByKind(node, S_Exp)->lineNum;
   gatherParamInfo(gather, data, lineNum);
   freeData(data);
   if (i == 1) {
-    resolveArgs(getChildByName(node, "Args"), gather);
+    resolveArgs(getChildByKind(node, S_Args), gather);
   }
 }
 
@@ -324,30 +281,30 @@ static void resolveVarDec(const ParseTNode *node, DecGather **gather);
 */
 static void resolveDec(const ParseTNode *node, DecGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Dec") == 0);
+  assert(node->kind == S_Dec);
   const char *expressions[] = {
     "VarDec",
     "VarDec ASSIGNOP Exp"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  resolveVarDec(getChildByName(node, "VarDec"), gather);
-  if (i == 1 && currentEnv->kind == STRUCTURE) {
-    const int lineNum = getChildByName(node, "ASSIGNOP")->lineNum;
+  resolveVarDec(getChildByKind(node, S_VarDec), gather);
+  if (i == 1 && scopeKind(currentEnv) == STRUCTURE) {
+    const int lineNum = getChildByKind(node, S_ASSIGNOP)->lineNum;
     error(15, lineNum, "initializing a field in structure.\n");
   }
 }
 
 static void resolveDecList(const ParseTNode *node, DecGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"DecList") == 0);
+  assert(node->kind == S_DecList);
   const char *expressions[] = {
     "Dec",
     "Dec COMMA DecList"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  resolveDec(getChildByName(node, "Dec"), gather);
+  resolveDec(getChildByKind(node, S_Dec), gather);
   if (i == 1) {
-    resolveDecList(getChildByName(node, "DecList"), gather);
+    resolveDecList(getChildByKind(node, S_DecList), gather);
   }
 }
 
@@ -357,56 +314,56 @@ static void resolveDecList(const ParseTNode *node, DecGather **gather) {
  * Helper function for 'resolveCompSt'
 */
 static void checkInit(const ParseTNode *CompSt_node) {
-  assert(CompSt_node != NULL && strcmp(CompSt_node->name,"CompSt") == 0);
+  assert(CompSt_node != NULL && CompSt_node->kind == S_CompSt);
   const char *CompSt_expressions[] = {"LC DefList StmtList RC"};
   assert(EXPRESSION_INDEX(CompSt_node, CompSt_expressions) == 0);
-  const ParseTNode *DefList_node = getChildByName(CompSt_node, "DefList");
+  const ParseTNode *DefList_node = getChildByKind(CompSt_node, S_DefList);
   const char *DefList_expressions[] = {
     "",
     "Def DefList"
   };
   while (EXPRESSION_INDEX(DefList_node, DefList_expressions) == 1) {
-    const ParseTNode *Def_node = getChildByName(DefList_node, "Def");
+    const ParseTNode *Def_node = getChildByKind(DefList_node, S_Def);
     const char *Def_expressions[] = {"Specifier DecList SEMI"};
-    assert(matchExprPattern(Def_node,Def_expressions,ARRAY_LEN(Def_expressions)) == 0);
-    const ParseTNode *DecList_node = getChildByName(Def_node, "DecList");
+    assert(EXPRESSION_INDEX(Def_node, Def_expressions) == 0);
+    const ParseTNode *DecList_node = getChildByKind(Def_node, S_DecList);
     const char *DecList_expressions[] = {
       "Dec",
       "Dec COMMA DecList"
     };
     while (1) {
-      const ParseTNode *Dec_node = getChildByName(DecList_node, "Dec");
+      const ParseTNode *Dec_node = getChildByKind(DecList_node, S_Dec);
       const char *Dec_expressions[] = {
         "VarDec",
         "VarDec ASSIGNOP Exp"
       };
       if (EXPRESSION_INDEX(Dec_node, Dec_expressions) == 1) {
-        assert(currentEnv->kind == COMPOUND);
-        const Type *type = resolveExp(getChildByName(Dec_node, "Exp"));
+        assert(scopeKind(currentEnv) == COMPOUND);
+        const Type *type = resolveExp(getChildByKind(Dec_node, S_Exp));
         assert(type != NULL);
         const Type *expect; {
           DecGather *gather = NULL; // get the variable name using dec gather
-          resolveVarDec(getChildByName(Dec_node, "VarDec"), &gather);
+          resolveVarDec(getChildByKind(Dec_node, S_VarDec), &gather);
           assert(gather != NULL && gather->next == NULL); // only get one
-          const Data *d = searchWithName(currentEnv->vMap, gather->name);
+          const Data *d = searchCurrentScopeWithName(currentEnv, gather->name);
           // searching in current scope is enough
           assert(d != NULL && d->kind == VAR);
-          expect = deepCopyType(d->variable.type);
+          expect = d->variable.type;
           freeDecGather(gather);
         }
         // ignore error, because it has been dealt with.
         if (type->kind != ERROR && !typeEqual(expect, type)) {
-          const int lineNum = getChildByName(Dec_node, "ASSIGNOP")->lineNum;
+          const int lineNum = getChildByKind(Dec_node, S_ASSIGNOP)->lineNum;
           error(5, lineNum, "Type mismatched for assignment.\n");
         }
       }
       if (EXPRESSION_INDEX(DecList_node, DecList_expressions) == 0) {
         break;
       }
-      DecList_node = getChildByName(DecList_node, "DecList");
+      DecList_node = getChildByKind(DecList_node, S_DecList);
     }
 
-    DefList_node = getChildByName(DefList_node, "DefList");
+    DefList_node = getChildByKind(DefList_node, S_DefList);
   }
 }
 
@@ -414,32 +371,28 @@ static const Type* resolveSpecifier(const ParseTNode *node);
 
 static void resolveDef(const ParseTNode *node, ParamGather **param_gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Def") == 0);
+  assert(node->kind == S_Def);
   const char *expressions[] = {
     "Specifier DecList SEMI"
   };
   assert(EXPRESSION_INDEX(node, expressions) == 0);
-  const Type *base_type = resolveSpecifier(getChildByName(node, "Specifier"));
-  if (base_type->kind == ERROR) {
-    freeType((Type *) base_type);
-    return;
-  }
+  const Type *base_type = resolveSpecifier(getChildByKind(node, S_Specifier));
+  if (base_type->kind == ERROR) return;
   DecGather *dec_gather = NULL;
-  resolveDecList(getChildByName(node, "DecList"), &dec_gather);
+  resolveDecList(getChildByKind(node, S_DecList), &dec_gather);
   assert(dec_gather != NULL);
   const DecGather *g = dec_gather;
   // loop through dec gather and construct param gather
   while (g != NULL) {
     Data *d = malloc(sizeof(Data));
     d->kind = VAR;
-    d->name = my_strdup(g->name);
-    d->variable.type = (Type *) turnDecGather2Type(g, base_type);
+    d->name = g->name;
+    d->variable.type = turnDecGather2Type(g, base_type);
     gatherParamInfo(param_gather, d, g->lineNum);
     freeData(d);
     g = g->next;
   }
   freeDecGather(dec_gather);
-  freeType((Type *) base_type);
 }
 
 /**
@@ -448,22 +401,22 @@ static void resolveDef(const ParseTNode *node, ParamGather **param_gather) {
 */
 static void resolveDefList(const ParseTNode *node, ParamGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"DefList") == 0);
+  assert(node->kind == S_DefList);
   const char *expressions[] = {
     "",
     "Def DefList"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 0) return;
-  resolveDef(getChildByName(node, "Def"), gather);
-  resolveDefList(getChildByName(node, "DefList"), gather);
+  resolveDef(getChildByKind(node, S_Def), gather);
+  resolveDefList(getChildByKind(node, S_DefList), gather);
 }
 
 static void resolveCompSt(const ParseTNode *node, const Type *returnType);
 
 static void resolveStmt(const ParseTNode *node, const Type *returnType) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Stmt") == 0);
+  assert(node->kind == S_Stmt);
   const char *expressions[] = {
     "Exp SEMI",                    // 0
     "CompSt",                      // 1
@@ -474,19 +427,19 @@ static void resolveStmt(const ParseTNode *node, const Type *returnType) {
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 1) {
-    resolveCompSt(getChildByName(node, "CompSt"), returnType);
+    resolveCompSt(getChildByKind(node, S_CompSt), returnType);
     return;
   }
   // i == 0 do nothing
-  const Type *expType = resolveExp(getChildByName(node, "Exp"));
+  const Type *expType = resolveExp(getChildByKind(node, S_Exp));
   if (i == 2 && (expType->kind == ERROR || !typeEqual(returnType, expType))) {
     // not tolerate error in here
-    const int lineNum = getChildByName(node, "RETURN")->lineNum;
+    const int lineNum = getChildByKind(node, S_RETURN)->lineNum;
     error(8, lineNum, "Type mismatched for return.\n");
   } else if (3 <= i && i <= 5) {
     if (expType->kind != INT) {
       // not tolerate error in here
-      const int lineNum = getChildByName(node, "Exp")->lineNum;
+      const int lineNum = getChildByKind(node, S_Exp)->lineNum;
       error(7, lineNum, "Type mismatched for operands.\n");
     }
     resolveStmt(getChild(node, 4), returnType);
@@ -494,13 +447,12 @@ static void resolveStmt(const ParseTNode *node, const Type *returnType) {
       resolveStmt(getChild(node, 6), returnType);
     }
   }
-  freeType((Type *) expType);
 }
 
 // relay function between 'CompSt' and 'Stmt'
 static void resolveStmtList(const ParseTNode *node, const Type *returnType) {
   assert(node != NULL);
-  assert(strcmp(node->name,"StmtList") == 0);
+  assert(node->kind == S_StmtList);
   const char *expressions[] = {
     "",
     "Stmt StmtList"
@@ -508,8 +460,8 @@ static void resolveStmtList(const ParseTNode *node, const Type *returnType) {
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 0) return;
   // i == 1
-  resolveStmt(getChildByName(node, "Stmt"), returnType);
-  resolveStmtList(getChildByName(node, "StmtList"), returnType);
+  resolveStmt(getChildByKind(node, S_Stmt), returnType);
+  resolveStmtList(getChildByKind(node, S_StmtList), returnType);
 }
 
 /**
@@ -518,15 +470,15 @@ static void resolveStmtList(const ParseTNode *node, const Type *returnType) {
 */
 static void resolveCompSt(const ParseTNode *node, const Type *returnType) {
   assert(node != NULL);
-  assert(strcmp(node->name,"CompSt") == 0);
+  assert(node->kind == S_CompSt);
   const char *expressions[] = {
     "LC DefList StmtList RC"
   };
   assert(EXPRESSION_INDEX(node, expressions) == 0);
   // add another layer of environment
-  currentEnv = newEnvironment(currentEnv, COMPOUND);
+  enterScope(currentEnv, COMPOUND);
   ParamGather *gather = NULL;
-  resolveDefList(getChildByName(node, "DefList"), &gather);
+  resolveDefList(getChildByKind(node, S_DefList), &gather);
   // reverse param gather, because it adds from head
   reverseParamGather(&gather);
   const ParamGather *g = gather;
@@ -534,7 +486,7 @@ static void resolveCompSt(const ParseTNode *node, const Type *returnType) {
   while (g != NULL) {
     const Data *data = g->data;
     assert(data->kind == VAR);
-    if (searchWithName(currentEnv->vMap, data->name) != NULL ||
+    if (searchCurrentScopeWithName(currentEnv, data->name) != NULL ||
         findDefinedStruct(definedStructList, data->name) != NULL) { // haven't defined OR collide with struct name
       error(3, g->lineNum, "Redefined variable \"%s\".\n", data->name);
     } else {
@@ -546,37 +498,33 @@ static void resolveCompSt(const ParseTNode *node, const Type *returnType) {
   checkInit(node);
 
   freeParamGather(gather);
-  resolveStmtList(getChildByName(node, "StmtList"), returnType);
-  revertEnvironment(&currentEnv);
+  resolveStmtList(getChildByKind(node, S_StmtList), returnType);
+  leaveScope(currentEnv);
 }
 
 static void resolveParamDec(const ParseTNode *node, ParamGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"ParamDec") == 0);
+  assert(node->kind == S_ParamDec);
   const char *expressions[] = {
     "Specifier VarDec"
   };
   assert(EXPRESSION_INDEX(node, expressions) == 0);
-  const Type *type = resolveSpecifier(getChildByName(node, "Specifier"));
-  if (type->kind == ERROR) {
-    freeType((Type *) type);
-    return;
-  }
+  const Type *type = resolveSpecifier(getChildByKind(node, S_Specifier));
+  if (type->kind == ERROR) return;
   DecGather *decGather = NULL;
-  resolveVarDec(getChildByName(node, "VarDec"), &decGather);
+  resolveVarDec(getChildByKind(node, S_VarDec), &decGather);
   assert(decGather != NULL);
   assert(decGather->next == NULL); // only gather one variable
   // temporary data
   Data *data = malloc(sizeof(Data));
-  data->name = my_strdup(decGather->name);
+  data->name = decGather->name;
   data->kind = VAR;
-  data->variable.type = (Type *) turnDecGather2Type(decGather, type);
-  const int lineNum = getChildByName(node, "VarDec")->lineNum;
+  data->variable.type = turnDecGather2Type(decGather, type);
+  const int lineNum = getChildByKind(node, S_VarDec)->lineNum;
   gatherParamInfo(gather, data, lineNum);
 
   freeData(data);
   freeDecGather(decGather);
-  freeType((Type *) type); // suppress warning
 }
 
 /**
@@ -585,35 +533,35 @@ static void resolveParamDec(const ParseTNode *node, ParamGather **gather) {
  */
 static int resolveVarList(const ParseTNode *node, ParamGather **gather, const int n) {
   assert(node != NULL);
-  assert(strcmp(node->name,"VarList") == 0);
+  assert(node->kind == S_VarList);
   const char *expressions[] = {
     "ParamDec",
     "ParamDec COMMA VarList"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  resolveParamDec(getChildByName(node, "ParamDec"), gather);
+  resolveParamDec(getChildByKind(node, S_ParamDec), gather);
   if (i == 0) return n;
-  return resolveVarList(getChildByName(node, "VarList"), gather, n + 1);
+  return resolveVarList(getChildByKind(node, S_VarList), gather, n + 1);
 }
 
 /**
  * @brief gather the variable list names and its types and function name
  * @return a number of parameters
- * @note name is a new copy. And guarantee that the sequence of vars is the same as theirs in gather.
+ * @note name is interned. And guarantee that the sequence of vars is the same as theirs in gather.
 */
-static int resolveFunDec(const ParseTNode *node, ParamGather **gather, char **name) {
+static int resolveFunDec(const ParseTNode *node, ParamGather **gather, const char **name) {
   assert(node != NULL);
-  assert(strcmp(node->name,"FunDec") == 0);
+  assert(node->kind == S_FunDec);
   const char *expressions[] = {
     "ID LP VarList RP",
     "ID LP RP"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   assert(*name == NULL); // name should be NULL when passed in
-  *name = my_strdup(getStrFrom(node, ID));
+  *name = getStrFrom(node, ID);
   int num = 0;
   if (i == 0) {
-    num = resolveVarList(getChildByName(node, "VarList"), gather, 1);
+    num = resolveVarList(getChildByKind(node, S_VarList), gather, 1);
   }
   reverseParamGather(gather);
   return num;
@@ -621,7 +569,7 @@ static int resolveFunDec(const ParseTNode *node, ParamGather **gather, char **na
 
 static void resolveVarDec(const ParseTNode *node, DecGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"VarDec") == 0);
+  assert(node->kind == S_VarDec);
   const char *expressions[] = {
     "ID",
     "VarDec LB INT RB"
@@ -637,52 +585,52 @@ static void resolveVarDec(const ParseTNode *node, DecGather **gather) {
     }
     size_list[dimension] = getValFromINT(node);
     dimension++;
-    node = getChildByName(node, "VarDec");
+    node = getChildByKind(node, S_VarDec);
   }
-  const ParseTNode *IDNode = getChildByName(node, "ID");
-  const char *name = IDNode->value.str_value;
+  const ParseTNode *IDNode = getChildByKind(node, S_ID);
+  const char *name = internedStr(IDNode->value.id);
   // change the sequence of size in size_list
   reverseArray(size_list, dimension, sizeof(int));
   gatherDecInfo(gather, name, dimension, size_list, IDNode->lineNum);
 }
 
 /**
- * @return a copy of string.
+ * @return an interned string.
 */
 static const char* resolveTag(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Tag") == 0);
+  assert(node->kind == S_Tag);
   const char *expressions[] = {
     "ID"
   };
   assert(EXPRESSION_INDEX(node, expressions) == 0);
-  return my_strdup(getStrFrom(node, ID));
+  return getStrFrom(node, ID);
 }
 
 /**
  * @brief if is ID get its name; else get a random string.
- * @return a copy of name.
+ * @return an interned name.
 */
 static const char* resolveOptTag(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"OptTag") == 0);
+  assert(node->kind == S_OptTag);
   const char *expressions[] = {
     "",
     "ID"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  if (i == 0) return randomString(5, "-struct");
-  return my_strdup(getStrFrom(node, ID));
+  if (i == 0) return internRandomName("-struct");
+  return getStrFrom(node, ID);
 }
 
 /**
  * @brief construct and retrieve OR simply retrieve struct type
  * @warning may return ERROR type.
- * @return a copy of type.
+ * @return the interned type.
 */
 static const Type* resolveStructSpecifier(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"StructSpecifier") == 0);
+  assert(node->kind == S_StructSpecifier);
   const char *expressions[] = {
     "STRUCT OptTag LC DefList RC",
     "STRUCT Tag"
@@ -690,80 +638,69 @@ static const Type* resolveStructSpecifier(const ParseTNode *node) {
   // use environment to check duplication
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 1) {
-    const char *name = resolveTag(getChildByName(node, "Tag"));
+    const char *name = resolveTag(getChildByKind(node, S_Tag));
     const Type *type = findDefinedStruct(definedStructList, name);
     if (type == NULL) { // not register in defined list
-      const int lineNum = getChildByName(node, "Tag")->lineNum;
+      const int lineNum = getChildByKind(node, S_Tag)->lineNum;
       error(17, lineNum, "Undefined structure \"%s\".\n", name);
-      free((char *) name);
-      Type *t = malloc(sizeof(Type));
-      t->kind = ERROR;
-      return t;
+      return basicType(ERROR);
     }
     assert(type->kind == STRUCT);
-    free((char *) name);
-    return deepCopyType(type);
+    return type;
   }
-  const char *name = resolveOptTag(getChildByName(node, "OptTag"));
+  const char *name = resolveOptTag(getChildByKind(node, S_OptTag));
   if (findDefinedStruct(definedStructList, name) != NULL ||
-      searchWithName(currentEnv->vMap, name) != NULL) {
+      searchCurrentScopeWithName(currentEnv, name) != NULL) {
     // collide with defined struct OR variable name in current env
-    const int lineNum = getChildByName(node, "STRUCT")->lineNum;
+    const int lineNum = getChildByKind(node, S_STRUCT)->lineNum;
     error(16, lineNum, "Duplicated name \"%s\".\n", name);
-    free((char *) name);
-    Type *t = malloc(sizeof(Type));
-    t->kind = ERROR;
-    return t;
+    return basicType(ERROR);
   }
 
-  currentEnv = newEnvironment(currentEnv, STRUCTURE); // mainly for checking duplication
+  enterScope(currentEnv, STRUCTURE); // mainly for checking duplication
   ParamGather *gather = NULL;
-  resolveDefList(getChildByName(node, "DefList"), &gather);
+  resolveDefList(getChildByKind(node, S_DefList), &gather);
   // reverse param gather, because it adds from head
   reverseParamGather(&gather);
 
   const ParamGather *g = gather;
-  Type *struct_type = malloc(sizeof(Type));
-  struct_type->kind = STRUCT;
-  struct_type->structure.struct_name = (char *) name; // directly pointing to name, so no need to free.
-  structFieldElement **f = &struct_type->structure.fields;
+  structFieldElement *fields = NULL;
+  structFieldElement **f = &fields;
   // loop through param gather to construct STRUCT
   while (g != NULL) {
     const Data *data = g->data;
     assert(data->kind == VAR);
-    if (searchWithName(currentEnv->vMap, data->name) != NULL) { // duplicate variable in current field
+    if (searchCurrentScopeWithName(currentEnv, data->name) != NULL) { // duplicate variable in current field
       error(15, g->lineNum, "Redefined field \"%s\".\n", data->name);
       g = g->next;
       continue;
     }
-    *f = malloc(sizeof(structFieldElement));
-    (*f)->name = my_strdup(data->name);
-    (*f)->elemType = (Type *) deepCopyType(data->variable.type);
+    *f = newStructField(data->name, data->variable.type);
     f = &(*f)->next;
-    insert(currentEnv->vMap, (Data *) deepCopyData(data)); // register in struct map
+    bindInScope(currentEnv, data); // register in struct scope, gather outlives it
     g = g->next;
   }
-  *f = NULL;
+  const Type *struct_type = structOf(name, fields);
   addDefinedStruct(&definedStructList, struct_type); // register struct type in defined list
-  revertEnvironment(&currentEnv);
+  leaveScope(currentEnv);
   freeParamGather(gather);
   return struct_type;
 }
 
 /**
  * @warning may return ERROR type.
- * @return a copy of Type
+ * @return the interned type
 */
 static const Type* resolveSpecifier(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"Specifier") == 0);
+  assert(node->kind == S_Specifier);
   const char *expressions[] = {
     "TYPE",
     "StructSpecifier"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  if (i == 0) return createBasicTypeOfNode(getChildByName(node, "TYPE"));
-  return resolveStructSpecifier(getChildByName(node, "StructSpecifier"));
+  if (i == 0) return createBasicTypeOfNode(getChildByKind(node, S_TYPE));
+  return resolveStructSpecifier(getChildByKind(node, S_StructSpecifier));
 }
 
 /**
@@ -771,176 +708,174 @@ static const Type* resolveSpecifier(const ParseTNode *node) {
 */
 static void resolveExtDecList(const ParseTNode *node, DecGather **gather) {
   assert(node != NULL);
-  assert(strcmp(node->name,"ExtDecList") == 0);
+  assert(node->kind == S_ExtDecList);
   const char *expressions[] = {
     "VarDec",
     "VarDec COMMA ExtDecList"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  resolveVarDec(getChildByName(node, "VarDec"), gather);
+  resolveVarDec(getChildByKind(node, S_VarDec), gather);
   assert(*gather != NULL);
-  if (i == 1) resolveExtDecList(getChildByName(node, "ExtDecList"), gather);
+  if (i == 1) resolveExtDecList(getChildByKind(node, S_ExtDecList), gather);
 }
 
 // todo extract into separate functions
 static void resolveExtDef(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name, "ExtDef") == 0);
+  assert(node->kind == S_ExtDef);
   const char *expressions[] = {
     "Specifier SEMI",
     "Specifier ExtDecList SEMI",
     "Specifier FunDec CompSt"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
-  const Type *type = resolveSpecifier(getChildByName(node, "Specifier"));
+  const Type *type = resolveSpecifier(getChildByKind(node, S_Specifier));
   assert(type != NULL);
-  if (type->kind == ERROR || i == 0) {
-    freeType((Type *) type);
-    return;
-  }
+  if (type->kind == ERROR || i == 0) return;
   if (i == 1) {
     DecGather *gather = NULL;
-    resolveExtDecList(getChildByName(node, "ExtDecList"), &gather);
+    resolveExtDecList(getChildByKind(node, S_ExtDecList), &gather);
     // loop through gather
     const DecGather *g = gather;
-    assert(currentEnv != NULL && currentEnv->kind == GLOBAL); // in global environment
+    assert(currentEnv != NULL && scopeKind(currentEnv) == GLOBAL); // in global environment
     while (g != NULL) {
       // check duplication in current(global) environment
-      if (searchWithName(currentEnv->vMap, g->name) != NULL ||
+      if (searchCurrentScopeWithName(currentEnv, g->name) != NULL ||
           findDefinedStruct(definedStructList, g->name) != NULL) {
         error(3, g->lineNum, "Redefined variable \"%s\".\n", g->name);
         g = g->next;
         continue;
       }
       Data *data = malloc(sizeof(Data));
-      data->name = my_strdup(g->name);
+      data->name = g->name;
       data->kind = VAR;
-      data->variable.type = (Type *) turnDecGather2Type(g, type);
+      data->variable.type = turnDecGather2Type(g, type);
 
       INSERT_VAR(data);
       g = g->next;
     }
     freeDecGather(gather);
-    freeType((Type *) type);
     return;
   } // i == 2
   ParamGather *gather = NULL;
-  char *name = NULL;
-  const int argc = resolveFunDec(getChildByName(node, "FunDec"), &gather, &name);
+  const char *name = NULL;
+  const int argc = resolveFunDec(getChildByKind(node, S_FunDec), &gather, &name);
   assert(name != NULL); // function name should be obtained
   assert(table->funcs != NULL);
   if (searchWithName(table->funcs, name) != NULL) {
-    const int lineNum = getChildByName(node, "FunDec")->lineNum;
+    const int lineNum = getChildByKind(node, S_FunDec)->lineNum;
     error(4, lineNum, "Redefined function \"%s\".\n", name);
-    free(name);
     freeParamGather(gather);
-    freeType((Type *) type); // suppress warning
     return;
   }
   Data *func_data = malloc(sizeof(Data));
   func_data->kind = FUNC;
-  func_data->name = name; // directly pointing to name, so no need to free
+  func_data->name = name;
   func_data->function.argc = argc;
-  func_data->function.returnType = (Type *) deepCopyType(type);
+  func_data->function.returnType = type;
   func_data->function.argvTypes = malloc(sizeof(Type *) * argc);
   // loop through paramGather to fill up argvTypes
   const ParamGather *g = gather;
   int j = 0;
   while (g != NULL) {
     assert(g->data->kind == VAR); // all parameters collected should be variables
-    func_data->function.argvTypes[j] = (Type *) deepCopyType(g->data->variable.type);
+    func_data->function.argvTypes[j] = g->data->variable.type;
     j++;
     g = g->next;
   }
   insert(table->funcs, func_data);
-  currentEnv = newEnvironment(currentEnv, COMPOUND);
+  enterScope(currentEnv, COMPOUND);
   // register all parameters in new environment
   g = gather; // loop through paramGather again
   while (g != NULL) {
     const Data *data = g->data;
     assert(data->kind == VAR && currentEnv != NULL);
-    if (searchWithName(currentEnv->vMap, data->name) != NULL ||
+    if (searchCurrentScopeWithName(currentEnv, data->name) != NULL ||
         findDefinedStruct(definedStructList, data->name) != NULL) { // duplication in parameters
       error(3, g->lineNum, "Redefined variable \"%s\".\n", data->name);
       Data *tmp = malloc(sizeof(Data));
       tmp->kind = VAR;
       // generate a random new name, and leave type as it is
-      tmp->variable.type = (Type *) deepCopyType(data->variable.type);
-      tmp->name = (char *) randomString(5, "-param");
+      tmp->variable.type = data->variable.type;
+      tmp->name = internRandomName("-param");
       INSERT_VAR(tmp);
     } else {
       INSERT_VAR(deepCopyData(g->data)); // reminder: copy data
     }
     g = g->next;
   }
-  resolveCompSt(getChildByName(node, "CompSt"), type);
-  revertEnvironment(&currentEnv);
+  resolveCompSt(getChildByKind(node, S_CompSt), type);
+  leaveScope(currentEnv);
   freeParamGather(gather);
-  freeType((Type *) type); // suppress warning
 }
 
 static void resolveExtDefList(const ParseTNode *node) {
   assert(node != NULL);
-  assert(strcmp(node->name,"ExtDefList") == 0);
+  assert(node->kind == S_ExtDefList);
   const char *expressions[] = {
     "",
     "ExtDef ExtDefList"
   };
   const int i = EXPRESSION_INDEX(node, expressions);
   if (i == 1) {
-    resolveExtDef(getChildByName(node, "ExtDef"));
-    resolveExtDefList(getChildByName(node, "ExtDefList"));
+    resolveExtDef(getChildByKind(node, S_ExtDef));
+    resolveExtDefList(getChildByKind(node, S_ExtDefList));
   }
 }
 
 static void initBuiltInFunc() {
   Data *read_d = malloc(sizeof(Data));
   read_d->kind = FUNC;
-  read_d->name = my_strdup("read");
+  read_d->name = internedStr(intern("read"));
   read_d->function.argc = 0;
   // todo notice this!!! guarantee that this can be freed.
   read_d->function.argvTypes = malloc(sizeof(Type *) * 0);
-  read_d->function.returnType = malloc(sizeof(Type));
-  read_d->function.returnType->kind = INT;
+  read_d->function.returnType = basicType(INT);
   insert(table->funcs, read_d);
   Data *write_d = malloc(sizeof(Data));
   write_d->kind = FUNC;
-  write_d->name = my_strdup("write");
+  write_d->name = internedStr(intern("write"));
   write_d->function.argc = 1;
   write_d->function.argvTypes = malloc(sizeof(Type *) * 1);
-  write_d->function.argvTypes[0] = malloc(sizeof(Type));
-  write_d->function.argvTypes[0]->kind = INT;
-  write_d->function.returnType = malloc(sizeof(Type));
-  write_d->function.returnType->kind = INT;
+  write_d->function.argvTypes[0] = basicType(INT);
+  write_d->function.returnType = basicType(INT);
   insert(table->funcs, write_d);
 }
 
-const SymbolTable* buildTable(const ParseTNode *root) {
+const SymbolTable* buildTable(CompilerContext *ctx, const ParseTNode *root) {
   assert(root != NULL);
-  assert(strcmp(root->name,"Program") == 0);
-  char *expressions[] = {
+  bindContext(ctx);
+  assert(root->kind == S_Program);
+  const char *expressions[] = {
     "ExtDefList"
   };
   table = malloc(sizeof(SymbolTable));
-  table->vars = createRedBlackTree();
-  table->funcs = createRedBlackTree();
+  table->vars = createSymbolMap();
+  table->funcs = createSymbolMap();
 
   definedStructList = NULL;
-  currentEnv = newEnvironment(NULL, GLOBAL);
+  currentEnv = createEnvironment();
+  enterScope(currentEnv, GLOBAL);
   assert(EXPRESSION_INDEX(root, expressions) == 0);
   initBuiltInFunc();
-  resolveExtDefList(getChildByName(root, "ExtDefList"));
-  assert(currentEnv->kind == GLOBAL);
+  resolveExtDefList(getChildByKind(root, S_ExtDefList));
+  assert(scopeKind(currentEnv) == GLOBAL);
 
   freeEnvironment(currentEnv);
   freeDefinedStructList(definedStructList);
-  return table;
+  currentEnv = NULL;
+  definedStructList = NULL;
+  SymbolTable *built = table;
+  table = NULL;
+  return built;
 }
 
-void freeTable(SymbolTable *table) {
-  freeRedBlackTree(table->funcs);
-  freeRedBlackTree(table->vars);
-  free(table);
+// the types of current context go along with the table
+void freeTable(SymbolTable *symbols) {
+  freeSymbolMap(symbols->funcs);
+  freeSymbolMap(symbols->vars);
+  free(symbols);
+  freeTypeTable();
 }
 
 #ifdef SYMBOL_test
@@ -9,11 +9,11 @@
 
 // proj 3 add this! guarantee that no duplication in name.
 typedef struct SymbolTable {
-  RedBlackTree *vars;
-  RedBlackTree *funcs;
+  SymbolMap *vars;
+  SymbolMap *funcs;
 } SymbolTable;
 
-const SymbolTable* buildTable(const ParseTNode *root);
+const SymbolTable* buildTable(CompilerContext *ctx, const ParseTNode *root);
 void freeTable(SymbolTable *table);
 
 #endif
@@ -0,0 +1,77 @@
+"""
+End-to-end benchmark: compile generated programs of growing size and
+report the throughput (lines/s) of every phase, using the JSON lines of
+`-ftime-report=json`. A phase whose throughput drops as the size grows
+is the one going superlinear.
+
+usage: python3 bench.py COMPILER [--sizes 1000,10000,100000,1000000] [--timeout SEC] [--json FILE]
+"""
+import argparse
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+from gen import generate
+
+PHASES = ['parse', 'buildTable', 'compile', 'optimize', 'printMIPS', 'free', 'total']
+
+
+def run(compiler, lines, timeout, workdir):
+    """@return the report of every phase, keyed by phase name; None if it didn't finish"""
+    source = workdir / f'bench{lines}.cmm'
+    source.write_text(generate(lines))
+    lines = len(source.read_text().splitlines())
+    # a LOCAL build dumps the parse tree and IR into test/out
+    (workdir / 'test' / 'out').mkdir(parents=True, exist_ok=True)
+    try:
+        proc = subprocess.run([compiler, '-ftime-report=json', source.name, source.stem + '.s'],
+                              cwd=workdir, stdin=subprocess.DEVNULL, capture_output=True,
+                              text=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        print(f'{lines} lines: timed out after {timeout}s', file=sys.stderr)
+        return lines, None
+    reports = {}
+    for line in proc.stderr.splitlines():
+        if line.startswith('{'):
+            report = json.loads(line)
+            report['lines'] = lines
+            reports[report['phase']] = report
+    if proc.returncode != 0 or 'total' not in reports:
+        print(f'{lines} lines: compiler failed ({proc.returncode})', file=sys.stderr)
+        print(proc.stderr[-2000:], file=sys.stderr)
+        return lines, None
+    return lines, reports
+
+
+def main():
+    parser = argparse.ArgumentParser(description='benchmark every phase of the compiler')
+    parser.add_argument('compiler', help='path to the compiler executable')
+    parser.add_argument('--sizes', default='1000,10000,100000,1000000',
+                        help='comma separated program sizes in lines')
+    parser.add_argument('--timeout', type=float, default=1800, help='seconds for each size')
+    parser.add_argument('--json', help='also append the raw reports to this JSON lines file')
+    opt = parser.parse_args()
+    compiler = str(Path(opt.compiler).resolve())
+
+    print(f'{"lines":>9} ' + ' '.join(f'{p:>12}' for p in PHASES) + '   (lines/s)')
+    with tempfile.TemporaryDirectory() as tmp:
+        for size in (int(s) for s in opt.sizes.split(',')):
+            lines, reports = run(compiler, size, opt.timeout, Path(tmp))
+            if reports is None:
+                continue
+            row = []
+            for phase in PHASES:
+                wall_ms = reports[phase]['wall_ms'] if phase in reports else 0
+                row.append(f'{lines / wall_ms * 1e3:12.0f}' if wall_ms > 0 else f'{"-":>12}')
+            print(f'{lines:>9} ' + ' '.join(row), flush=True)
+            if opt.json:
+                with open(opt.json, 'a') as out:
+                    for phase in PHASES:
+                        if phase in reports:
+                            out.write(json.dumps(reports[phase]) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,134 @@
+"""
+Generate a valid C-- program of roughly the requested number of lines.
+
+The program is made of many functions, each with a wide parameter list,
+local arrays, long expression chains and loops/branches nested to a given
+depth. A function only calls the ones defined before it, and every name is
+prefixed by its function, since the symbol table keeps variables by name.
+The program is only meant to be compiled: indices and loops are unchecked.
+
+usage: python3 gen.py LINES [--seed N] [--depth N] [--args N] [--expr N] [--array N] > out.cmm
+"""
+import argparse
+import random
+import sys
+
+
+class Generator:
+    def __init__(self, rng, depth, args, expr, array):
+        self.rng = rng
+        self.depth = depth
+        self.args = args
+        self.expr = expr
+        self.array = array
+        self.lines = []
+        self.funcs = []  # (name, argc) of defined functions
+
+    def emit(self, level, text):
+        self.lines.append('  ' * level + text)
+
+    def atom(self, scalars):
+        r = self.rng.random()
+        if r < 0.3:
+            return str(self.rng.randint(0, 99))
+        if r < 0.4:
+            return f'{self.arr}[{self.rng.choice(scalars)} - {self.rng.choice(scalars)}]'
+        if r < 0.45:
+            return f'{self.mat}[{self.rng.randint(0, 7)}][{self.rng.choice(scalars)}]'
+        return self.rng.choice(scalars)
+
+    def expression(self, scalars, length):
+        """a long left-leaning chain, with a few parenthesized groups"""
+        exp = self.atom(scalars)
+        for _ in range(length - 1):
+            op = self.rng.choice('+-*+-')
+            term = self.atom(scalars)
+            if self.rng.random() < 0.15:
+                term = f'({term} {self.rng.choice("+-")} {self.atom(scalars)})'
+            exp = f'{exp} {op} {term}'
+        return exp
+
+    def condition(self, scalars):
+        relop = self.rng.choice(['<', '<=', '>', '>=', '==', '!='])
+        cond = f'{self.rng.choice(scalars)} {relop} {self.atom(scalars)}'
+        if self.rng.random() < 0.3:
+            cond = f'{cond} && {self.rng.choice(scalars)} != {self.rng.randint(0, 9)}'
+        return cond
+
+    def call(self, scalars):
+        name, argc = self.rng.choice(self.funcs)
+        args = ', '.join(self.atom(scalars) for _ in range(argc))
+        return f'{name}({args})'
+
+    def statements(self, level, scalars, depth):
+        for _ in range(self.rng.randint(2, 4)):
+            target = self.rng.choice(scalars)
+            r = self.rng.random()
+            if depth > 0 and r < 0.25:
+                self.emit(level, f'while ({self.condition(scalars)}) {{')
+                self.statements(level + 1, scalars, depth - 1)
+                self.emit(level + 1, f'{target} = {target} + 1;')
+                self.emit(level, '}')
+            elif depth > 0 and r < 0.45:
+                self.emit(level, f'if ({self.condition(scalars)}) {{')
+                self.statements(level + 1, scalars, depth - 1)
+                self.emit(level, '} else {')
+                self.statements(level + 1, scalars, depth - 1)
+                self.emit(level, '}')
+            elif self.funcs and r < 0.6:
+                self.emit(level, f'{target} = {self.call(scalars)};')
+            elif r < 0.7:
+                index = f'{self.rng.choice(scalars)} - {self.rng.choice(scalars)}'
+                self.emit(level, f'{self.arr}[{index}] = {self.expression(scalars, 3)};')
+            else:
+                length = self.rng.randint(self.expr // 2 + 1, self.expr)
+                self.emit(level, f'{target} = {self.expression(scalars, length)};')
+
+    def function(self, index):
+        name = f'f{index}'
+        argc = self.rng.randint(1, self.args)
+        params = [f'{name}_a{i}' for i in range(argc)]
+        scalars = params + [f'{name}_v{i}' for i in range(4)]
+        self.arr, self.mat = f'{name}_arr', f'{name}_mat'
+        self.emit(0, f'int {name}({", ".join("int " + p for p in params)}) {{')
+        self.emit(1, f'int {name}_v0 = 0, {name}_v1 = 1, {name}_v2, {name}_v3;')
+        self.emit(1, f'int {self.arr}[{self.array}], {self.mat}[8][{self.array}];')
+        self.emit(1, f'{name}_v2 = {params[0]};')
+        self.emit(1, f'{name}_v3 = {params[-1]};')
+        self.statements(1, scalars, self.depth)
+        self.emit(1, f'return {self.expression(scalars, 3)};')
+        self.emit(0, '}')
+        self.funcs.append((name, argc))
+
+    def program(self, lines):
+        index = 0
+        while len(self.lines) < lines - 6:
+            self.function(index)
+            index += 1
+        scalars = ['m_r', 'm_i']
+        self.arr, self.mat = 'm_arr', 'm_mat'
+        self.emit(0, 'int main() {')
+        self.emit(1, f'int m_r = 0, m_i = read(), m_arr[{self.array}], m_mat[8][{self.array}];')
+        for name, argc in self.funcs[-4:]:
+            args = ', '.join(self.atom(scalars) for _ in range(argc))
+            self.emit(1, f'm_r = m_r + {name}({args});')
+        self.emit(1, 'write(m_r);')
+        self.emit(1, 'return 0;')
+        self.emit(0, '}')
+        return '\n'.join(self.lines) + '\n'
+
+
+def generate(lines, seed=0, depth=3, args=8, expr=12, array=64):
+    return Generator(random.Random(seed), depth, args, expr, array).program(lines)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='generate a synthetic C-- program')
+    parser.add_argument('lines', type=int, help='the approximate number of lines')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--depth', type=int, default=3, help='nesting depth of while/if')
+    parser.add_argument('--args', type=int, default=8, help='the most parameters of a function')
+    parser.add_argument('--expr', type=int, default=12, help='the longest expression chain')
+    parser.add_argument('--array', type=int, default=64, help='the length of local arrays')
+    opt = parser.parse_args()
+    sys.stdout.write(generate(opt.lines, opt.seed, opt.depth, opt.args, opt.expr, opt.array))
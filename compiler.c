@@ -0,0 +1,73 @@
+#ifdef LOCAL
+#include <Compile.h>
+#include <IR.h>
+#include <Morph.h>
+#include <Optimize.h>
+#include <ParseTree.h>
+#include <SymbolTable.h>
+#else
+#include "ParseTree.h"
+#include "SymbolTable.h"
+#include "Compile.h"
+#include "IR.h"
+#include "Optimize.h"
+#include "Morph.h"
+#endif
+#include "compiler.h"
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
+extern int parseBuffer(CompilerContext *ctx, const char *src, size_t len);
+
+// the phases after a successful semantic check, whose output goes to memory streams
+static void generate(CompilerContext *ctx, const SymbolTable *table, CompileOutput *output) {
+  CodeList *list = compile(ctx, getRoot(), table);
+  Block *block = optimize(ctx, list);
+
+  FILE *ir = open_memstream(&output->ir, &output->ir_len);
+  FILE *mips = open_memstream(&output->mips, &output->mips_len);
+  assert(ir != NULL && mips != NULL);
+  printCodeList(ir, list);
+  printMIPS(ctx, mips, block, ALLOC_FIFO);
+  fclose(ir);
+  fclose(mips);
+
+  freeBlock(block);
+  freeCodeList(list);
+}
+
+/**
+ * @brief compile len bytes of C-- source, src needn't end with '\0'.
+ * nothing is generated once an error is found, as the later phases assume a valid program.
+ * @return 0 if the assembly was generated.
+ * @note output is always filled, release it with `freeCompileOutput`.
+ */
+int compileBuffer(const char *src, const size_t len, CompileOutput *output) {
+  assert(src != NULL || len == 0);
+  *output = (CompileOutput){.ir = NULL, .mips = NULL};
+  FILE *diagnostics = open_memstream(&output->diagnostics, &output->diagnostics_len);
+  assert(diagnostics != NULL);
+  CompilerContext *ctx = createContext();
+  ctx->diagnostics = diagnostics;
+
+  if (parseBuffer(ctx, src, len) == 0 && ctx->error_cnt == 0) {
+    const SymbolTable *table = buildTable(ctx, getRoot());
+    if (ctx->error_cnt == 0) generate(ctx, table, output);
+    freeTable((SymbolTable *) table);
+  }
+  output->error_cnt = ctx->error_cnt;
+  freeContext(ctx);
+  fclose(diagnostics);
+  return output->mips == NULL;
+}
+
+void freeCompileOutput(CompileOutput *output) {
+  free(output->ir);
+  free(output->mips);
+  free(output->diagnostics);
+  *output = (CompileOutput){.ir = NULL, .mips = NULL};
+}
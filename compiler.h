@@ -0,0 +1,20 @@
+#ifndef COMPILER__H
+#define COMPILER__H
+#include <stddef.h>
+
+/* the compiler as a library: source in memory, IR and assembly out in memory.
+ * nothing touches the file system, and every call has a context of its own,
+ * so it may be called from several threads at once. */
+
+typedef struct {
+  char *ir;           // the optimized IR, NULL if there were errors
+  char *mips;         // the MIPS assembly, NULL if there were errors
+  char *diagnostics;  // every error reported, "" if none
+  size_t ir_len, mips_len, diagnostics_len;
+  int error_cnt;
+} CompileOutput;
+
+int compileBuffer(const char *src, size_t len, CompileOutput *output);
+void freeCompileOutput(CompileOutput *output);
+
+#endif
@@ -1,6 +1,10 @@
+// clock_gettime, getline and open_memstream are POSIX, not C99
+#define _POSIX_C_SOURCE 200809L
+
 #ifdef LOCAL
 #include <Compile.h>
 #include <IR.h>
+#include <IRFile.h>
 #include <Morph.h>
 #include <Optimize.h>
 #include <ParseTree.h>
@@ -10,70 +14,488 @@
 #include "SymbolTable.h"
 #include "Compile.h"
 #include "IR.h"
+#include "IRFile.h"
 #include "Optimize.h"
 #include "Morph.h"
 #endif
 
-#ifdef PARSER_DEBUG
-extern int yydebug;
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
 #endif
 
 // Declare the external variables and functions
-extern int yylineno;
-extern void yyrestart(FILE *input_file);
-extern int yyparse();
-extern void printParseTRoot();
-extern void printChunk(const char *file_name, const Chunk *sentinel);
+extern int parseFile(CompilerContext *ctx, FILE *in);
+extern void printBlock(const Block *block);
+
+// the register allocator of every file (--regalloc)
+static Allocator allocator = ALLOC_FIFO;
+
+///// Phase report (-ftime-report) ///////////////////////////
 
-void rewind(FILE *f) {
-  yylineno = 1;
-  yyrestart(f);
+#define MAX_PHASE_NUM 8
+
+static enum { REPORT_NONE, REPORT_TEXT, REPORT_JSON } report_mode = REPORT_NONE;
+
+typedef struct {
+  const char *name;
+  double wall_ms, cpu_ms;
+  AllocStats before, after; // `after.peak` is the peak of this phase only
+  long rss_kb;              // the peak resident set size of process, after this phase
+} Phase;
+
+// the phases of one compilation, every file of a batch has its own
+typedef struct {
+  Phase phases[MAX_PHASE_NUM];
+  int phase_cnt;
+} PhaseReport;
+
+static double clockMs(const clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
 }
 
-int parse() {
-#ifdef PARSER_DEBUG
-    yydebug = 1;
-#endif
-  return yyparse();
+// the cpu time and allocations are those of the calling thread, which runs the whole compilation
+static void beginPhase(PhaseReport *report, const char *name) {
+  if (report_mode == REPORT_NONE) return;
+  assert(report->phase_cnt < MAX_PHASE_NUM);
+  report->phases[report->phase_cnt].name = name;
+  resetAllocPeak();
+  report->phases[report->phase_cnt].before = allocStats();
+  report->phases[report->phase_cnt].cpu_ms = clockMs(CLOCK_THREAD_CPUTIME_ID);
+  report->phases[report->phase_cnt].wall_ms = clockMs(CLOCK_MONOTONIC);
 }
 
-int main(const int argc, char **argv) {
-  if (argc != 3) {
-    DEBUG_INFO("Arguments should be input test file and **output** file.\n");
-    return 1;
+static void endPhase(PhaseReport *report) {
+  if (report_mode == REPORT_NONE) return;
+  Phase *phase = &report->phases[report->phase_cnt];
+  phase->wall_ms = clockMs(CLOCK_MONOTONIC) - phase->wall_ms;
+  phase->cpu_ms = clockMs(CLOCK_THREAD_CPUTIME_ID) - phase->cpu_ms;
+  phase->after = allocStats();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  phase->rss_kb = usage.ru_maxrss;
+  report->phase_cnt++;
+}
+
+// run `stmt` as a phase of the report
+#define PHASE(report, name, stmt) do { beginPhase(report, name); stmt; endPhase(report); } while (false)
+
+static void printJsonString(FILE *out, const char *str) {
+  fputc('"', out);
+  for (; *str; ++str) {
+    if (either(*str, '"', '\\')) fputc('\\', out);
+    if ((unsigned char) *str < 0x20) fprintf(out, "\\u%04x", *str);
+    else fputc(*str, out);
   }
-  FILE *f = fopen(argv[1], "r");
-  if (!f) {
-    perror(argv[1]);
-    return 1;
+  fputc('"', out);
+}
+
+/**
+ * @brief print every phase, the last line sums them up.
+ * in json mode, each line is an object, so that the lines of many runs can be concatenated.
+ */
+static void printPhaseReport(FILE *out, const char *file_name, const PhaseReport *report) {
+  const int phase_cnt = report->phase_cnt;
+  if (report_mode == REPORT_NONE || phase_cnt == 0) return;
+  if (report_mode == REPORT_TEXT) {
+    fprintf(out, "Phase report for %s:\n", file_name);
+    fprintf(out, " %-12s %10s %10s %10s %12s %12s %10s\n",
+            "phase", "wall(ms)", "cpu(ms)", "allocs", "bytes", "peak", "rss(KB)");
   }
-  rewind(f);
-  const int rst = parse();
-  if (rst != 0) return 0;
-  const ParseTNode *root = getRoot();
+  double wall_ms = 0, cpu_ms = 0;
+  size_t peak = 0;
+  for (int i = 0; i <= phase_cnt; ++i) {
+    const bool total = i == phase_cnt;
+    const char *name = total ? "total" : report->phases[i].name;
+    const AllocStats before = report->phases[total ? 0 : i].before;
+    const AllocStats after = report->phases[total ? phase_cnt - 1 : i].after;
+    if (!total) {
+      wall_ms += report->phases[i].wall_ms;
+      cpu_ms += report->phases[i].cpu_ms;
+      if (after.peak > peak) peak = after.peak;
+    }
+    const double wall = total ? wall_ms : report->phases[i].wall_ms;
+    const double cpu = total ? cpu_ms : report->phases[i].cpu_ms;
+    const size_t allocs = after.allocs - before.allocs;
+    const size_t bytes = after.bytes - before.bytes;
+    const size_t phase_peak = total ? peak : after.peak;
+    const long rss_kb = report->phases[total ? phase_cnt - 1 : i].rss_kb;
+    if (report_mode == REPORT_TEXT) {
+      fprintf(out, " %-12s %10.3f %10.3f %10zu %12zu %12zu %10ld\n",
+              name, wall, cpu, allocs, bytes, phase_peak, rss_kb);
+      continue;
+    }
+    fprintf(out, "{\"file\":");
+    printJsonString(out, file_name);
+    fprintf(out, ",\"phase\":\"%s\",\"wall_ms\":%.3f,\"cpu_ms\":%.3f,"
+            "\"allocs\":%zu,\"alloc_bytes\":%zu,\"peak_bytes\":%zu,\"rss_kb\":%ld}\n",
+            name, wall, cpu, allocs, bytes, phase_peak, rss_kb);
+  }
+}
+
+///// Compilation of one file ////////////////////////////////
+
+typedef enum { COMPILED, SOURCE_ERROR, IO_FAILURE } CompileStatus;
+
+static const char *status_names[] = {"ok", "errors", "io failure"};
 
 #ifdef LOCAL
-  // Redirect stdout to the output file
-  if (freopen("test/out/out.txt", "w", stdout) == NULL) {
-    perror("Something wrong while redirecting stdout.\n");
-    return 1;
+// the debug dumps of a single file
+static FILE* openDump(const char *file_name) {
+  FILE *f = fopen(file_name, "w");
+  if (f == NULL) {
+    perror(file_name);
+    exit(EXIT_FAILURE);
   }
-  printParseTRoot();
-  // redirect stdout to terminal
-  freopen("/dev/tty", "w", stdout);
+  return f;
+}
 #endif
 
-  const SymbolTable *table = buildTable(root);
-  const Chunk *chunk = compile(root, table);
-  Block *block = optimize(chunk);
+/**
+ * @brief optimize list and write its assembly to out_file, then release everything of ctx.
+ * @param table NULL if list was loaded from an IR file
+ */
+static CompileStatus generate(CompilerContext *ctx, CodeList *list, const SymbolTable *table,
+                              const char *out_file, FILE *diagnostics, PhaseReport *report,
+                              const bool dump) {
+  Block *block;
+  PHASE(report, "optimize", block = optimize(ctx, list));
 #ifdef LOCAL
-  printChunk("test/out/out.ir", chunk);
+  if (dump) {
+    FILE *ir = openDump("test/out/out.ir");
+    printCodeList(ir, list);
+    fclose(ir);
+    printBlock(block);
+  }
 #endif
-  printMIPS(argv[2], block);
+  FILE *out = fopen(out_file, "w");
+  const bool writable = out != NULL;
+  if (writable) {
+    PHASE(report, "printMIPS", {
+          printMIPS(ctx, out, block, allocator);
+          fclose(out);
+          });
+  } else {
+    fprintf(diagnostics, "%s: %s\n", out_file, strerror(errno));
+  }
+
+  PHASE(report, "free", {
+        freeBlock(block);
+        freeCodeList(list);
+        if (table != NULL) freeTable((SymbolTable *) table);
+        freeContext(ctx);
+        });
+  return writable ? COMPILED : IO_FAILURE;
+}
+
+// @return false if the binary IR can't be written to ir_file
+static bool saveCodeList(CompilerContext *ctx, const CodeList *list, const char *ir_file,
+                         FILE *diagnostics) {
+  FILE *f = fopen(ir_file, "wb");
+  bool saved = f != NULL && writeCodeList(ctx, f, list) == 0;
+  if (f != NULL && fclose(f) != 0) saved = false;
+  if (!saved) fprintf(diagnostics, "%s: %s\n", ir_file, strerror(errno));
+  return saved;
+}
+
+/**
+ * @brief compile in_file to out_file with a context of its own, reporting errors to diagnostics.
+ * nothing is generated once an error is found, the later phases assume a valid program.
+ * @param ir_file if not NULL, also write the binary IR there before it is optimized
+ * @param dump also write the parse tree and IR to test/out, only for a single file.
+ */
+static CompileStatus compileFile(const char *in_file, const char *out_file, const char *ir_file,
+                                 FILE *diagnostics, PhaseReport *report, const bool dump) {
+  FILE *f = fopen(in_file, "r");
+  if (!f) {
+    fprintf(diagnostics, "%s: %s\n", in_file, strerror(errno));
+    return IO_FAILURE;
+  }
+  CompilerContext *ctx = createContext();
+  ctx->diagnostics = diagnostics;
+  int rst;
+  PHASE(report, "parse", rst = parseFile(ctx, f));
+  fclose(f);
+  if (rst != 0 || ctx->error_cnt > 0) {
+    freeContext(ctx);
+    return SOURCE_ERROR;
+  }
+  const ParseTNode *root = getRoot();
 
-  freeBlock(block);
-  freeChunk(chunk);
-  freeTable((SymbolTable *) table);
-  cleanParseTree();
+#ifdef LOCAL
+  if (dump) {
+    FILE *tree = openDump("test/out/out.txt");
+    printParseTree(tree, root);
+    fclose(tree);
+  }
+#endif
+
+  const SymbolTable *table;
+  PHASE(report, "buildTable", table = buildTable(ctx, root));
+  if (ctx->error_cnt > 0) {
+    freeTable((SymbolTable *) table);
+    freeContext(ctx);
+    return SOURCE_ERROR;
+  }
+  CodeList *list;
+  PHASE(report, "compile", list = compile(ctx, root, table));
+  bool saved = true;
+  if (ir_file != NULL)
+    PHASE(report, "writeIR", saved = saveCodeList(ctx, list, ir_file, diagnostics));
+  const CompileStatus status = generate(ctx, list, table, out_file, diagnostics, report, dump);
+  return saved ? status : IO_FAILURE;
+}
+
+// generate out_file from the IR in_file, binary or text, the front end is skipped entirely
+static CompileStatus generateFromIR(const char *in_file, const char *out_file,
+                                    FILE *diagnostics, PhaseReport *report, const bool dump) {
+  CompilerContext *ctx = createContext();
+  ctx->diagnostics = diagnostics;
+  CodeList *list;
+  PHASE(report, "loadIR", list = loadCodeList(ctx, in_file));
+  if (list == NULL) {
+    freeContext(ctx);
+    return IO_FAILURE;
+  }
+  return generate(ctx, list, NULL, out_file, diagnostics, report, dump);
+}
+
+///// Batch mode (--batch) ///////////////////////////////////
+
+typedef struct {
+  char *in_file, *out_file;
+  CompileStatus status;
+  double wall_ms;
+  char *diagnostics, *report; // the output of the worker, printed in the order of jobs
+  size_t diagnostics_len, report_len;
+  bool done;
+} Job;
+
+/* workers take the next job until none is left, and the main thread prints
+ * the jobs in order as soon as each is done, so the output doesn't depend
+ * on how many workers there are. */
+static struct {
+  Job *jobs;
+  size_t cnt, capacity;
+  atomic_size_t next;
+  pthread_mutex_t lock;
+  pthread_cond_t finished;
+} batch = {.lock = PTHREAD_MUTEX_INITIALIZER, .finished = PTHREAD_COND_INITIALIZER};
+
+// @param out_file if NULL, replace the extension of in_file with `.s`
+static void addJob(const char *in_file, const char *out_file) {
+  if (batch.cnt >= batch.capacity) {
+    batch.capacity = batch.capacity == 0 ? 64 : batch.capacity * 2;
+    batch.jobs = realloc(batch.jobs, sizeof(Job) * batch.capacity);
+    assert(batch.jobs != NULL);
+  }
+  Job *job = &batch.jobs[batch.cnt++];
+  *job = (Job){.in_file = my_strdup(in_file)};
+  if (out_file != NULL) {
+    job->out_file = my_strdup(out_file);
+    return;
+  }
+  const char *dot = strrchr(in_file, '.');
+  const char *slash = strrchr(in_file, '/');
+  const size_t stem_len = dot != NULL && (slash == NULL || dot > slash)
+                            ? (size_t) (dot - in_file) : strlen(in_file);
+  const size_t size = stem_len + sizeof(".s");
+  job->out_file = malloc(size);
+  assert(job->out_file != NULL);
+  snprintf(job->out_file, size, "%.*s.s", (int) stem_len, in_file);
+}
+
+static int compareJob(const void *a, const void *b) {
+  return strcmp(((const Job *) a)->in_file, ((const Job *) b)->in_file);
+}
+
+/**
+ * @brief a directory gives every `.cmm` file in it, in the order of names, each compiled next to itself.
+ * any other file lists a job per line: the input, then optionally the output.
+ * empty lines and lines starting with '#' are skipped.
+ * @return 0 if succeeded
+ */
+static int loadJobs(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    perror(path);
+    return 1;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+      perror(path);
+      return 1;
+    }
+    const struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      const size_t len = strlen(entry->d_name);
+      if (len <= 4 || strcmp(entry->d_name + len - 4, ".cmm") != 0) continue;
+      const size_t size = strlen(path) + len + 2;
+      char *in_file = malloc(size);
+      assert(in_file != NULL);
+      snprintf(in_file, size, "%s/%s", path, entry->d_name);
+      addJob(in_file, NULL);
+      free(in_file);
+    }
+    closedir(dir);
+    qsort(batch.jobs, batch.cnt, sizeof(Job), compareJob);
+    return 0;
+  }
+  FILE *list = fopen(path, "r");
+  if (list == NULL) {
+    perror(path);
+    return 1;
+  }
+  char *line = NULL;
+  size_t size = 0;
+  while (getline(&line, &size, list) != -1) {
+    char *in_file = NULL, *out_file = NULL;
+    const int n = sscanf(line, "%ms %ms", &in_file, &out_file);
+    if (n >= 1 && in_file[0] != '#') addJob(in_file, n == 2 ? out_file : NULL);
+    free(in_file);
+    free(out_file);
+  }
+  free(line);
+  fclose(list);
   return 0;
 }
+
+static void* batchWorker(void *arg) {
+  (void) arg;
+  size_t i;
+  while ((i = atomic_fetch_add(&batch.next, 1)) < batch.cnt) {
+    Job *job = &batch.jobs[i];
+    FILE *diagnostics = open_memstream(&job->diagnostics, &job->diagnostics_len);
+    FILE *report_out = open_memstream(&job->report, &job->report_len);
+    assert(diagnostics != NULL && report_out != NULL);
+    PhaseReport report = {.phase_cnt = 0};
+    const double start = clockMs(CLOCK_MONOTONIC);
+    job->status = compileFile(job->in_file, job->out_file, NULL, diagnostics, &report, false);
+    job->wall_ms = clockMs(CLOCK_MONOTONIC) - start;
+    printPhaseReport(report_out, job->in_file, &report);
+    fclose(diagnostics);
+    fclose(report_out);
+
+    pthread_mutex_lock(&batch.lock);
+    job->done = true;
+    pthread_cond_broadcast(&batch.finished);
+    pthread_mutex_unlock(&batch.lock);
+  }
+  return NULL;
+}
+
+/**
+ * @brief compile every job on a pool of worker_cnt threads.
+ * the diagnostics of each file go to stdout, its timing to stderr, both in the order of jobs.
+ * @return 0 if every file was compiled
+ */
+static int runBatch(int worker_cnt) {
+  if (worker_cnt > (int) batch.cnt) worker_cnt = (int) batch.cnt;
+  pthread_t *workers = malloc(sizeof(pthread_t) * (worker_cnt > 0 ? worker_cnt : 1));
+  const double start = clockMs(CLOCK_MONOTONIC);
+  for (int i = 0; i < worker_cnt; ++i) {
+    if (pthread_create(&workers[i], NULL, batchWorker, NULL) != 0) {
+      DEBUG_INFO("fail to create worker thread.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  size_t failed = 0;
+  for (size_t i = 0; i < batch.cnt; ++i) {
+    Job *job = &batch.jobs[i];
+    pthread_mutex_lock(&batch.lock);
+    while (!job->done) pthread_cond_wait(&batch.finished, &batch.lock);
+    pthread_mutex_unlock(&batch.lock);
+    fwrite(job->diagnostics, 1, job->diagnostics_len, stdout);
+    fflush(stdout);
+    fwrite(job->report, 1, job->report_len, stderr);
+    if (report_mode != REPORT_JSON) {
+      fprintf(stderr, "%s -> %s: %s, %.3f ms\n",
+              job->in_file, job->out_file, status_names[job->status], job->wall_ms);
+    }
+    failed += job->status != COMPILED;
+    free(job->diagnostics);
+    free(job->report);
+    free(job->in_file);
+    free(job->out_file);
+  }
+  for (int i = 0; i < worker_cnt; ++i) pthread_join(workers[i], NULL);
+  const double wall_ms = clockMs(CLOCK_MONOTONIC) - start;
+  if (report_mode != REPORT_JSON) {
+    fprintf(stderr, "batch: %zu files, %zu failed, %.3f ms on %d threads (%.1f files/s)\n",
+            batch.cnt, failed, wall_ms, worker_cnt, wall_ms > 0 ? batch.cnt / wall_ms * 1e3 : 0);
+  }
+  free(workers);
+  free(batch.jobs);
+  return failed != 0;
+}
+
+int main(const int argc, char **argv) {
+  const char *files[2];
+  int file_cnt = 0;
+  const char *batch_path = NULL;
+  const char *ir_file = NULL;
+  bool from_ir = false;
+  long worker_cnt = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-ftime-report") == 0) {
+      report_mode = REPORT_TEXT;
+    } else if (strcmp(argv[i], "-ftime-report=json") == 0) {
+      report_mode = REPORT_JSON;
+    } else if (strcmp(argv[i], "--emit-ir") == 0 && i + 1 < argc) {
+      ir_file = argv[++i];
+    } else if (strcmp(argv[i], "--from-ir") == 0) {
+      from_ir = true;
+    } else if (strcmp(argv[i], "--regalloc=fifo") == 0) {
+      allocator = ALLOC_FIFO;
+    } else if (strcmp(argv[i], "--regalloc=linear") == 0) {
+      allocator = ALLOC_LINEAR_SCAN;
+    } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batch_path = argv[++i];
+    } else if (strncmp(argv[i], "-j", 2) == 0) {
+      const char *num = argv[i][2] != '\0' ? argv[i] + 2 : i + 1 < argc ? argv[++i] : "";
+      worker_cnt = isInteger(num) ? strtol(num, NULL, 10) : 0;
+      if (worker_cnt <= 0) {
+        file_cnt = -1;
+        break;
+      }
+    } else if (argv[i][0] == '-' || file_cnt == 2) {
+      file_cnt = -1;
+      break;
+    } else {
+      files[file_cnt++] = argv[i];
+    }
+  }
+  if (batch_path != NULL && file_cnt == 0) {
+    if (loadJobs(batch_path) != 0) return 1;
+    return runBatch(worker_cnt > 0 ? (int) worker_cnt : 1);
+  }
+  if (file_cnt != 2) {
+    DEBUG_INFO("Arguments should be input test file and **output** file, "
+               "optionally with --emit-ir <binary IR file>, or --from-ir if the input is binary or text IR; "
+               "or --batch with a directory or a list of files, optionally with -j <threads>; "
+               "both optionally with -ftime-report[=json] and --regalloc=fifo|linear.\n");
+    return 1;
+  }
+  PhaseReport report = {.phase_cnt = 0};
+  const CompileStatus status = from_ir
+                                 ? generateFromIR(files[0], files[1], stdout, &report, true)
+                                 : compileFile(files[0], files[1], ir_file, stdout, &report, true);
+  printPhaseReport(stderr, files[0], &report);
+  return status == IO_FAILURE;
+}
+
+#undef MAX_PHASE_NUM
+#undef PHASE
@@ -4,26 +4,31 @@
 #else
   #include "ParseTree.h"
 #endif
+  typedef void *yyscan_t;
 }
 %{
-  #ifdef LOCAL
-    #include "lex.yy.h"
-    #include "ParseTree/ParseTree.h"
-  #else
-    #include "lex.yy.c"
-  #endif
-
   #ifdef PARSER_DEBUG
     #undef  YYDEBUG
     #define YYDEBUG 1
   #endif
-
-  void yyerror(char* msg);
-  extern ParseTNode *root; // Root of the AST
 %}
+%code {
+  #include <limits.h>
+  #ifdef LOCAL
+    #include "lex.yy.h"
+  #else
+    // lex.yy.c is included at the end, its macros would clash with the pure parser
+    int yylex(YYSTYPE *yylval_param, YYLTYPE *yylloc_param, yyscan_t yyscanner);
+  #endif
 
+  void yyerror(YYLTYPE *loc, yyscan_t scanner, const char *msg);
+}
+
+%define api.pure full
 %define api.value.type {ParseTNode*}
 %locations
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner}
 
 /* declared tokens */
 /* %token <node> INT FLOAT TYPE ID */
@@ -52,34 +57,35 @@
 %%
 /* High-level Definitions */
 Program : ExtDefList {
-            root = createParseTNode("Program", @$.first_line, 0);
-            addChild(root, $1);
+            $$ = createParseTNode(S_Program, P_Program, @$.first_line);
+            addChild($$, $1);
+            currentContext()->root = $$;
         }
         ;
 
 ExtDefList : /* empty */ {
-                $$ = createParseTNode("ExtDefList", @$.first_line, 0);
+                $$ = createParseTNode(S_ExtDefList, P_ExtDefList_Empty, @$.first_line);
             }
            | ExtDef ExtDefList {
-                $$ = createParseTNode("ExtDefList", @$.first_line, 0);
+                $$ = createParseTNode(S_ExtDefList, P_ExtDefList, @$.first_line);
                 addChild($$, $1);
                 addChild($$, $2);
             }
            ;
 
 ExtDef : Specifier ExtDecList SEMI {
-            $$ = createParseTNode("ExtDef", @$.first_line, 0);
+            $$ = createParseTNode(S_ExtDef, P_ExtDef_Var, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
-            addChild($$, createParseTNode("SEMI", @3.first_line, 1));
+            addChild($$, createParseTNode(S_SEMI, P_NONE, @3.first_line));
         }
        | Specifier SEMI {
-            $$ = createParseTNode("ExtDef", @$.first_line, 0);
+            $$ = createParseTNode(S_ExtDef, P_ExtDef_Struct, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("SEMI", @2.first_line, 1));
+            addChild($$, createParseTNode(S_SEMI, P_NONE, @2.first_line));
         }
        | Specifier FunDec CompSt {
-            $$ = createParseTNode("ExtDef", @$.first_line, 0);
+            $$ = createParseTNode(S_ExtDef, P_ExtDef_Func, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
             addChild($$, $3);
@@ -87,101 +93,101 @@ ExtDef : Specifier ExtDecList SEMI {
        ;
 
 ExtDecList : VarDec {
-                $$ = createParseTNode("ExtDecList", @$.first_line, 0);
+                $$ = createParseTNode(S_ExtDecList, P_ExtDecList_VarDec, @$.first_line);
                 addChild($$, $1);
             }
            | VarDec COMMA ExtDecList {
-                $$ = createParseTNode("ExtDecList", @$.first_line, 0);
+                $$ = createParseTNode(S_ExtDecList, P_ExtDecList, @$.first_line);
                 addChild($$, $1);
-                addChild($$, createParseTNode("COMMA", @2.first_line, 1));
+                addChild($$, createParseTNode(S_COMMA, P_NONE, @2.first_line));
                 addChild($$, $3);
             }
            ;
 
 /* Specifiers */
 Specifier : TYPE {
-                $$ = createParseTNode("Specifier", @$.first_line, 0);
+                $$ = createParseTNode(S_Specifier, P_Specifier_TYPE, @$.first_line);
                 addChild($$, $1);
             }
           | StructSpecifier {
-                $$ = createParseTNode("Specifier", @$.first_line, 0);
+                $$ = createParseTNode(S_Specifier, P_Specifier_Struct, @$.first_line);
                 addChild($$, $1);
             }
           ;
 
 StructSpecifier : STRUCT OptTag LC DefList RC {
-                    $$ = createParseTNode("StructSpecifier", @$.first_line, 0);
-                    addChild($$, createParseTNode("STRUCT", @1.first_line, 1));
+                    $$ = createParseTNode(S_StructSpecifier, P_StructSpecifier_Def, @$.first_line);
+                    addChild($$, createParseTNode(S_STRUCT, P_NONE, @1.first_line));
                     addChild($$, $2);
-                    addChild($$, createParseTNode("LC", @3.first_line, 1));
+                    addChild($$, createParseTNode(S_LC, P_NONE, @3.first_line));
                     addChild($$, $4);
-                    addChild($$, createParseTNode("RC", @5.first_line, 1));
+                    addChild($$, createParseTNode(S_RC, P_NONE, @5.first_line));
                 }
                 | STRUCT Tag {
-                    $$ = createParseTNode("StructSpecifier", @$.first_line, 0);
-                    addChild($$, createParseTNode("STRUCT", @1.first_line, 1));
+                    $$ = createParseTNode(S_StructSpecifier, P_StructSpecifier_Tag, @$.first_line);
+                    addChild($$, createParseTNode(S_STRUCT, P_NONE, @1.first_line));
                     addChild($$, $2);
                 }
                 ;
 
 OptTag : /* empty */ {
-            $$ = createParseTNode("OptTag", @$.first_line, 0);
+            $$ = createParseTNode(S_OptTag, P_OptTag_Empty, @$.first_line);
         }
        | ID {
-            $$ = createParseTNode("OptTag", @$.first_line, 0);
+            $$ = createParseTNode(S_OptTag, P_OptTag_ID, @$.first_line);
             addChild($$, $1);
         }
        ;
 
 Tag : ID {
-        $$ = createParseTNode("Tag", @$.first_line, 0);
+        $$ = createParseTNode(S_Tag, P_Tag_ID, @$.first_line);
         addChild($$, $1);
     }
     ;
 
 /* Declarators */
 VarDec : ID {
-            $$ = createParseTNode("VarDec", @$.first_line, 0);
+            $$ = createParseTNode(S_VarDec, P_VarDec_ID, @$.first_line);
             addChild($$, $1);
         }
        | VarDec LB INT RB {
-            $$ = createParseTNode("VarDec", @$.first_line, 0);
+            $$ = createParseTNode(S_VarDec, P_VarDec_Array, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LB", @2.first_line, 1));
+            addChild($$, createParseTNode(S_LB, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RB", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RB, P_NONE, @4.first_line));
         }
        ;
 
 FunDec : ID LP VarList RP {
-            $$ = createParseTNode("FunDec", @$.first_line, 0);
+            $$ = createParseTNode(S_FunDec, P_FunDec_Params, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RP", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @4.first_line));
         }
        | ID LP RP {
-            $$ = createParseTNode("FunDec", @$.first_line, 0);
+            $$ = createParseTNode(S_FunDec, P_FunDec_Empty, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
-            addChild($$, createParseTNode("RP", @3.first_line, 1));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
+            addChild($$, createParseTNode(S_RP, P_NONE, @3.first_line));
         }
        ;
 
 VarList : ParamDec COMMA VarList {
-            $$ = createParseTNode("VarList", @$.first_line, 0);
+            $$ = createParseTNode(S_VarList, P_VarList, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("COMMA", @2.first_line, 1));
+            addChild($$, createParseTNode(S_COMMA, P_NONE, @2.first_line));
             addChild($$, $3);
      }
         | ParamDec {
-            $$ = createParseTNode("VarList", @$.first_line, 0);
+            $$ = createParseTNode(S_VarList, P_VarList_ParamDec, @$.first_line);
             addChild($$, $1);
         }
         ;
 
 ParamDec : Specifier VarDec {
-            $$ = createParseTNode("ParamDec", @$.first_line, 0);
+            $$ = createParseTNode(S_ParamDec, P_ParamDec, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
         }
@@ -190,228 +196,280 @@ ParamDec : Specifier VarDec {
 /* Statements */
 /* variables can only be declared at the beginning of CompSt */
 CompSt : LC DefList StmtList RC {
-            $$ = createParseTNode("CompSt", @$.first_line, 0);
-            addChild($$, createParseTNode("LC", @1.first_line, 1));
+            $$ = createParseTNode(S_CompSt, P_CompSt, @$.first_line);
+            addChild($$, createParseTNode(S_LC, P_NONE, @1.first_line));
             addChild($$, $2);
             addChild($$, $3);
-            addChild($$, createParseTNode("RC", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RC, P_NONE, @4.first_line));
         }
        ;
 
 StmtList : /* empty */ {
-            $$ = createParseTNode("StmtList", @$.first_line, 0);
+            $$ = createParseTNode(S_StmtList, P_StmtList_Empty, @$.first_line);
         }
          | Stmt StmtList {
-            $$ = createParseTNode("StmtList", @$.first_line, 0);
+            $$ = createParseTNode(S_StmtList, P_StmtList, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
         }
          ;
 
 Stmt : Exp SEMI {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
+            $$ = createParseTNode(S_Stmt, P_Stmt_Exp, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("SEMI", @2.first_line, 1));
+            addChild($$, createParseTNode(S_SEMI, P_NONE, @2.first_line));
         }
      | CompSt {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
+            $$ = createParseTNode(S_Stmt, P_Stmt_CompSt, @$.first_line);
             addChild($$, $1);
         }
      | RETURN Exp SEMI {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
-            addChild($$, createParseTNode("RETURN", @1.first_line, 1));
+            $$ = createParseTNode(S_Stmt, P_Stmt_Return, @$.first_line);
+            addChild($$, createParseTNode(S_RETURN, P_NONE, @1.first_line));
             addChild($$, $2);
-            addChild($$, createParseTNode("SEMI", @3.first_line, 1));
+            addChild($$, createParseTNode(S_SEMI, P_NONE, @3.first_line));
         }
      | IF LP Exp RP Stmt %prec INFERIOR_ELSE {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
-            addChild($$, createParseTNode("IF", @1.first_line, 1));
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
+            $$ = createParseTNode(S_Stmt, P_Stmt_If, @$.first_line);
+            addChild($$, createParseTNode(S_IF, P_NONE, @1.first_line));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RP", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @4.first_line));
             addChild($$, $5);
         }
      | IF LP Exp RP Stmt ELSE Stmt {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
-            addChild($$, createParseTNode("IF", @1.first_line, 1));
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
+            $$ = createParseTNode(S_Stmt, P_Stmt_IfElse, @$.first_line);
+            addChild($$, createParseTNode(S_IF, P_NONE, @1.first_line));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RP", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @4.first_line));
             addChild($$, $5);
-            addChild($$, createParseTNode("ELSE", @6.first_line, 1));
+            addChild($$, createParseTNode(S_ELSE, P_NONE, @6.first_line));
             addChild($$, $7);
         }
      | WHILE LP Exp RP Stmt {
-            $$ = createParseTNode("Stmt", @$.first_line, 0);
-            addChild($$, createParseTNode("WHILE", @1.first_line, 1));
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
+            $$ = createParseTNode(S_Stmt, P_Stmt_While, @$.first_line);
+            addChild($$, createParseTNode(S_WHILE, P_NONE, @1.first_line));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RP", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @4.first_line));
             addChild($$, $5);
         }
      ;
 
 /* Local Definitions */
 DefList : /* empty */ {
-            $$ = createParseTNode("DefList", @$.first_line, 0);
+            $$ = createParseTNode(S_DefList, P_DefList_Empty, @$.first_line);
         }
         | Def DefList {
-            $$ = createParseTNode("DefList", @$.first_line, 0);
+            $$ = createParseTNode(S_DefList, P_DefList, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
         }
         ;
 
 Def : Specifier DecList SEMI {
-            $$ = createParseTNode("Def", @$.first_line, 0);
+            $$ = createParseTNode(S_Def, P_Def, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
-            addChild($$, createParseTNode("SEMI", @3.first_line, 1));
+            addChild($$, createParseTNode(S_SEMI, P_NONE, @3.first_line));
         }
     ;
 
 DecList : Dec {
-            $$ = createParseTNode("DecList", @$.first_line, 0);
+            $$ = createParseTNode(S_DecList, P_DecList_Dec, @$.first_line);
             addChild($$, $1);
         }
         | Dec COMMA DecList {
-            $$ = createParseTNode("DecList", @$.first_line, 0);
+            $$ = createParseTNode(S_DecList, P_DecList, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("COMMA", @2.first_line, 1));
+            addChild($$, createParseTNode(S_COMMA, P_NONE, @2.first_line));
             addChild($$, $3);
         }
         ;
 
 Dec : VarDec {
-            $$ = createParseTNode("Dec", @$.first_line, 0);
+            $$ = createParseTNode(S_Dec, P_Dec_VarDec, @$.first_line);
             addChild($$, $1);
         }
     | VarDec ASSIGNOP Exp {
-            $$ = createParseTNode("Dec", @$.first_line, 0);
+            $$ = createParseTNode(S_Dec, P_Dec_Assign, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("ASSIGNOP", @2.first_line, 1));
+            addChild($$, createParseTNode(S_ASSIGNOP, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     ;
 
 /* Expressions */
 Exp : Exp ASSIGNOP Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_ASSIGNOP, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("ASSIGNOP", @2.first_line, 1));
+            addChild($$, createParseTNode(S_ASSIGNOP, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp AND Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_AND, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("AND", @2.first_line, 1));
+            addChild($$, createParseTNode(S_AND, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp OR Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_OR, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("OR", @2.first_line, 1));
+            addChild($$, createParseTNode(S_OR, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp RELOP Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_RELOP, @$.first_line);
             addChild($$, $1);
             addChild($$, $2);
             addChild($$, $3);
         }
     | Exp PLUS Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_PLUS, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("PLUS", @2.first_line, 1));
+            addChild($$, createParseTNode(S_PLUS, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp MINUS Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_MINUS, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("MINUS", @2.first_line, 1));
+            addChild($$, createParseTNode(S_MINUS, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp STAR Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_STAR, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("STAR", @2.first_line, 1));
+            addChild($$, createParseTNode(S_STAR, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | Exp DIV Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_DIV, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("DIV", @2.first_line, 1));
+            addChild($$, createParseTNode(S_DIV, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | LP Exp RP {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
-            addChild($$, createParseTNode("LP", @1.first_line, 1));
+            $$ = createParseTNode(S_Exp, P_Exp_Paren, @$.first_line);
+            addChild($$, createParseTNode(S_LP, P_NONE, @1.first_line));
             addChild($$, $2);
-            addChild($$, createParseTNode("RP", @3.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @3.first_line));
         }
     | MINUS Exp %prec UMINUS {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
-            addChild($$, createParseTNode("MINUS", @1.first_line, 1));
+            $$ = createParseTNode(S_Exp, P_Exp_Neg, @$.first_line);
+            addChild($$, createParseTNode(S_MINUS, P_NONE, @1.first_line));
             addChild($$, $2);
         }
     | NOT Exp {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
-            addChild($$, createParseTNode("NOT", @1.first_line, 1));
+            $$ = createParseTNode(S_Exp, P_Exp_NOT, @$.first_line);
+            addChild($$, createParseTNode(S_NOT, P_NONE, @1.first_line));
             addChild($$, $2);
         }
     | ID LP Args RP {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_Call, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RP", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RP, P_NONE, @4.first_line));
         }
     | ID LP RP {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_CallEmpty, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LP", @2.first_line, 1));
-            addChild($$, createParseTNode("RP", @3.first_line, 1));
+            addChild($$, createParseTNode(S_LP, P_NONE, @2.first_line));
+            addChild($$, createParseTNode(S_RP, P_NONE, @3.first_line));
         }
     | Exp LB Exp RB {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_Index, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("LB", @2.first_line, 1));
+            addChild($$, createParseTNode(S_LB, P_NONE, @2.first_line));
             addChild($$, $3);
-            addChild($$, createParseTNode("RB", @4.first_line, 1));
+            addChild($$, createParseTNode(S_RB, P_NONE, @4.first_line));
         }
     | Exp DOT ID {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_DOT, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("DOT", @2.first_line, 1));
+            addChild($$, createParseTNode(S_DOT, P_NONE, @2.first_line));
             addChild($$, $3);
         }
     | ID {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_ID, @$.first_line);
             addChild($$, $1);
         }
     | INT {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_INT, @$.first_line);
             addChild($$, $1);
         }
     | FLOAT {
-            $$ = createParseTNode("Exp", @$.first_line, 0);
+            $$ = createParseTNode(S_Exp, P_Exp_FLOAT, @$.first_line);
             addChild($$, $1);
         }
     ;
 
 Args : Exp COMMA Args {
-            $$ = createParseTNode("Args", @$.first_line, 0);
+            $$ = createParseTNode(S_Args, P_Args, @$.first_line);
             addChild($$, $1);
-            addChild($$, createParseTNode("COMMA", @2.first_line, 1));
+            addChild($$, createParseTNode(S_COMMA, P_NONE, @2.first_line));
             addChild($$, $3);
         }
      | Exp {
-            $$ = createParseTNode("Args", @$.first_line, 0);
+            $$ = createParseTNode(S_Args, P_Args_Exp, @$.first_line);
             addChild($$, $1);
         }
      ;
 
 %%
-void yyerror(char* msg) {
-    fprintf(stdout, "Error type B at Line %d: %s around \"%s\".\n", yylineno, msg, yytext);
+#ifndef LOCAL
+#include "lex.yy.c"
+#endif
+
+void yyerror(YYLTYPE *loc, yyscan_t scanner, const char *msg) {
+    CompilerContext *ctx = yyget_extra(scanner);
+    ctx->error_cnt++;
+    fprintf(ctx->diagnostics, "Error type B at Line %d: %s around \"%s\".\n",
+            yyget_lineno(scanner), msg, yyget_text(scanner));
+}
+
+static yyscan_t createScanner(CompilerContext *ctx) {
+    yyscan_t scanner;
+    if (yylex_init_extra(ctx, &scanner) != 0) {
+        DEBUG_INFO("fail to initialize the scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+    return scanner;
+}
+
+// parse with scanner, which is released afterwards
+static int runParser(CompilerContext *ctx, yyscan_t scanner) {
+    bindContext(ctx);
+#ifdef PARSER_DEBUG
+    yydebug = 1;
+#endif
+    const int rst = yyparse(scanner);
+    yylex_destroy(scanner);
+    return rst;
+}
+
+/**
+ * @brief parse the whole file into the parse tree of ctx, with a scanner of its own.
+ * @return 0 if succeeded, as `yyparse`
+ */
+int parseFile(CompilerContext *ctx, FILE *in) {
+    yyscan_t scanner = createScanner(ctx);
+    yyset_in(in, scanner);
+    return runParser(ctx, scanner);
+}
+
+/**
+ * @brief parse len bytes of source in memory, as `parseFile`. src needn't end with '\0',
+ * the scanner works on a copy of its own.
+ */
+int parseBuffer(CompilerContext *ctx, const char *src, const size_t len) {
+    if (len > INT_MAX) {
+        ctx->error_cnt++;
+        fprintf(ctx->diagnostics, "The source of %zu bytes is too large.\n", len);
+        return 1;
+    }
+    yyscan_t scanner = createScanner(ctx);
+    yy_scan_bytes(src, (int) len, scanner);
+    return runParser(ctx, scanner);
 }
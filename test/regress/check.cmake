@@ -0,0 +1,63 @@
+# compile PROGRAM with COMPILER into OUTPUT, passing the lines of the .args file
+# next to PROGRAM, if any, as options. then check the assembly:
+#   every label a jump or a branch goes to is defined,
+#   every line of the .expect file next to PROGRAM, if any, matches somewhere,
+#   or, written as `at most N: <regex>`, matches no more than N lines.
+# run as `cmake -DCOMPILER=... -DPROGRAM=... -DOUTPUT=... -P check.cmake`
+cmake_minimum_required(VERSION 3.20)
+
+get_filename_component(dir ${OUTPUT} DIRECTORY)
+# the compiler dumps the parse tree and the IR to test/out of the working directory
+file(MAKE_DIRECTORY ${dir}/test/out)
+string(REGEX REPLACE "\\.cmm$" ".args" args_file ${PROGRAM})
+set(args "")
+if (EXISTS ${args_file})
+    file(STRINGS ${args_file} args)
+endif ()
+execute_process(COMMAND ${COMPILER} ${args} ${PROGRAM} ${OUTPUT}
+                WORKING_DIRECTORY ${dir}
+                RESULT_VARIABLE status
+                OUTPUT_QUIET
+                )
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "${PROGRAM}: the compiler exits with ${status}")
+endif ()
+
+file(STRINGS ${OUTPUT} lines)
+set(defined "")
+set(targets "")
+foreach (line IN LISTS lines)
+    if (line MATCHES "^([A-Za-z_][A-Za-z0-9_]*):")
+        list(APPEND defined ${CMAKE_MATCH_1})
+    elseif (line MATCHES "^[ \t]*(j|beq|bne|bgt|blt|bge|ble)[ \t].*[ \t,](label[0-9]+)[ \t]*$")
+        list(APPEND targets ${CMAKE_MATCH_2})
+    endif ()
+endforeach ()
+foreach (target IN LISTS targets)
+    if (NOT target IN_LIST defined)
+        message(FATAL_ERROR "${PROGRAM}: ${target} is jumped to but never defined")
+    endif ()
+endforeach ()
+
+string(REGEX REPLACE "\\.cmm$" ".expect" expect ${PROGRAM})
+if (EXISTS ${expect})
+    file(READ ${OUTPUT} text)
+    file(STRINGS ${expect} patterns)
+    foreach (pattern IN LISTS patterns)
+        if (pattern MATCHES "^at most ([0-9]+): (.*)$")
+            set(limit ${CMAKE_MATCH_1})
+            set(regex "${CMAKE_MATCH_2}")
+            set(count 0)
+            foreach (line IN LISTS lines)
+                if (line MATCHES "${regex}")
+                    math(EXPR count "${count} + 1")
+                endif ()
+            endforeach ()
+            if (count GREATER limit)
+                message(FATAL_ERROR "${PROGRAM}: ${count} lines match \"${regex}\", at most ${limit} expected")
+            endif ()
+        elseif (NOT text MATCHES "${pattern}")
+            message(FATAL_ERROR "${PROGRAM}: nothing matches \"${pattern}\"")
+        endif ()
+    endforeach ()
+endif ()
@@ -0,0 +1,19 @@
+#ifndef COUNTED_ALLOC__H
+#define COUNTED_ALLOC__H
+
+#ifdef LOCAL
+#include <utils.h>
+#else
+#include "utils.h"
+#endif
+
+/* route malloc, calloc, realloc and free of a source file of the project through the
+ * accounting allocator in utils.h. the macros rewrite everything after them, so include
+ * this header after every other one, and never from a header or from generated code. */
+
+#define malloc(size) countedMalloc(size)
+#define calloc(num, size) countedCalloc(num, size)
+#define realloc(ptr, size) countedRealloc(ptr, size)
+#define free(ptr) countedFree(ptr)
+
+#endif
@@ -1,4 +1,5 @@
 #include <ctype.h>
+#include <malloc.h>
 #include <time.h>
 #ifdef LOCAL
 #include <utils.h>
@@ -6,6 +7,12 @@
 #include "utils.h"
 #endif
 
+#ifdef LOCAL
+#include <CountedAlloc.h>
+#else
+#include "CountedAlloc.h"
+#endif
+
 // utility to duplicate a string
 char* my_strdup(const char *src) {
   if (src == NULL) return NULL;
@@ -34,14 +41,26 @@ const char* randomString(const int len, const char *suffix) {
   return str;
 }
 
+// report to the diagnostics of the current context
 void error(const int type, const int lineNum, const char *message, ...) {
-  printf("Error type %d at Line %d: ", type, lineNum);
+  CompilerContext *ctx = currentContext();
+  FILE *out = stdout;
+  if (ctx != NULL) {
+    out = ctx->diagnostics;
+    ctx->error_cnt++;
+  }
+  fprintf(out, "Error type %d at Line %d: ", type, lineNum);
   va_list arg;
   va_start(arg, message);
-  vprintf(message, arg);
+  vfprintf(out, message, arg);
   va_end(arg);
 }
 
+const char *const relopNames[] = {
+  [REL_EQ] = "==", [REL_NE] = "!=", [REL_LT] = "<",
+  [REL_LE] = "<=", [REL_GT] = ">", [REL_GE] = ">=",
+};
+
 /**
  * @brief turn int to string
  * @note remember to free.
@@ -156,3 +175,295 @@ void shuffleArray(void *base, const size_t len, const size_t size) {
     SWAP(array + i * size, array+ j * size, size);
   }
 }
+
+///// Arena ////////////////////////////////////////////////
+
+// the strictest alignment of a scalar (max_align_t is C11 only)
+typedef union {
+  long double ld;
+  long long ll;
+  void *ptr;
+} ArenaAlign;
+
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t capacity, used;
+  ArenaAlign data[]; // keep the payload aligned for any type
+} ArenaChunk;
+
+struct Arena {
+  ArenaChunk *head;  // the chunk currently being bumped
+  size_t chunk_size; // default capacity of a new chunk
+};
+
+#define ALIGN_UP(n) (((n) + sizeof(ArenaAlign) - 1) & ~(sizeof(ArenaAlign) - 1))
+
+static ArenaChunk* newArenaChunk(const size_t capacity, ArenaChunk *next) {
+  ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + capacity);
+  if (chunk == NULL) {
+    DEBUG_INFO("fail to allocate arena chunk.\n");
+    exit(EXIT_FAILURE);
+  }
+  chunk->next = next;
+  chunk->capacity = capacity;
+  chunk->used = 0;
+  return chunk;
+}
+
+/**
+ * @param chunk_size the capacity of each chunk, oversized requests get a chunk of their own
+ */
+Arena* createArena(const size_t chunk_size) {
+  assert(chunk_size > 0);
+  Arena *arena = malloc(sizeof(Arena));
+  assert(arena != NULL);
+  arena->chunk_size = ALIGN_UP(chunk_size);
+  arena->head = newArenaChunk(arena->chunk_size, NULL);
+  return arena;
+}
+
+/**
+ * @brief bump `size` bytes out of the arena
+ * @note the memory is neither zeroed nor individually freeable.
+ */
+void* arenaAlloc(Arena *arena, size_t size) {
+  assert(arena != NULL);
+  size = ALIGN_UP(size == 0 ? 1 : size);
+  ArenaChunk *chunk = arena->head;
+  if (chunk->used + size > chunk->capacity) {
+    const size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+    chunk = arena->head = newArenaChunk(capacity, chunk);
+  }
+  void *p = (char *) chunk->data + chunk->used;
+  chunk->used += size;
+  return p;
+}
+
+// duplicate a string into the arena
+char* arenaStrdup(Arena *arena, const char *src) {
+  if (src == NULL) return NULL;
+  const size_t len = strlen(src) + 1;
+  char *dest = arenaAlloc(arena, len);
+  memcpy(dest, src, len);
+  return dest;
+}
+
+void freeArena(Arena *arena) {
+  if (arena == NULL) return;
+  ArenaChunk *chunk = arena->head;
+  while (chunk != NULL) {
+    ArenaChunk *tmp = chunk;
+    chunk = chunk->next;
+    free(tmp);
+  }
+  free(arena);
+}
+
+#undef ALIGN_UP
+
+///// Compiler context ///////////////////////////////////
+
+static _Thread_local CompilerContext *bound_context = NULL;
+
+CompilerContext* createContext() {
+  CompilerContext *ctx = calloc(1, sizeof(CompilerContext));
+  assert(ctx != NULL);
+  ctx->diagnostics = stdout;
+  return ctx;
+}
+
+/**
+ * @brief release the interner and the parse tree of context
+ * @note the type table is released along with the symbol table, by `freeTable`.
+ */
+void freeContext(CompilerContext *ctx) {
+  if (ctx == NULL) return;
+  assert(ctx->types == NULL);
+  CompilerContext *previous = bound_context;
+  bound_context = ctx;
+  freeInterner();
+  freeArena(ctx->parse_arena);
+  bound_context = previous == ctx ? NULL : previous;
+  free(ctx);
+}
+
+// the following phases on this thread work on ctx
+void bindContext(CompilerContext *ctx) {
+  bound_context = ctx;
+}
+
+CompilerContext* currentContext() {
+  return bound_context;
+}
+
+///// Interner /////////////////////////////////////////////
+
+#define INTERNER_INIT_SLOTS 256
+
+/* strings live in an arena and never move, so the pointer handed out
+ * by `internedStr` stays valid until `freeInterner` */
+struct Interner {
+  Arena *arena;
+  const char **strs; // id -> string
+  uint32_t *hashes;  // id -> hash of string
+  int cnt, capacity;
+  InternId *slots;   // open addressing, -1 marks an empty slot
+  size_t slot_cnt;   // always a power of two
+};
+
+// FNV-1a
+uint32_t hashString(const char *str) {
+  uint32_t h = 2166136261u;
+  while (*str) {
+    h ^= (unsigned char) *str++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static struct Interner* currentInterner() {
+  CompilerContext *ctx = currentContext();
+  if (ctx == NULL) {
+    DEBUG_INFO("No compiler context is bound to this thread.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (ctx->interner == NULL) ctx->interner = calloc(1, sizeof(struct Interner));
+  return ctx->interner;
+}
+
+static void growInternerSlots(struct Interner *interner) {
+  free(interner->slots);
+  interner->slot_cnt = interner->slot_cnt == 0 ? INTERNER_INIT_SLOTS : interner->slot_cnt * 2;
+  interner->slots = malloc(sizeof(InternId) * interner->slot_cnt);
+  assert(interner->slots != NULL);
+  memset(interner->slots, -1, sizeof(InternId) * interner->slot_cnt);
+  const size_t mask = interner->slot_cnt - 1;
+  for (InternId id = 0; id < interner->cnt; ++id) {
+    size_t i = interner->hashes[id] & mask;
+    while (interner->slots[i] != -1) i = (i + 1) & mask;
+    interner->slots[i] = id;
+  }
+}
+
+/**
+ * @brief look up the string, store it if it hasn't been seen before
+ * @return the dense id of the string, equal strings always get the same id
+ */
+InternId intern(const char *str) {
+  assert(str != NULL);
+  struct Interner *interner = currentInterner();
+  // keep the load factor under 1/2
+  if ((size_t) interner->cnt * 2 >= interner->slot_cnt) growInternerSlots(interner);
+
+  const uint32_t h = hashString(str);
+  const size_t mask = interner->slot_cnt - 1;
+  size_t i = h & mask;
+  while (interner->slots[i] != -1) {
+    const InternId id = interner->slots[i];
+    if (interner->hashes[id] == h && strcmp(interner->strs[id], str) == 0)
+      return id;
+    i = (i + 1) & mask;
+  }
+
+  if (interner->cnt >= interner->capacity) {
+    interner->capacity = interner->capacity == 0 ? 64 : interner->capacity * 2;
+    interner->strs = realloc(interner->strs, sizeof(char *) * interner->capacity);
+    interner->hashes = realloc(interner->hashes, sizeof(uint32_t) * interner->capacity);
+    assert(interner->strs != NULL && interner->hashes != NULL);
+  }
+  if (interner->arena == NULL) interner->arena = createArena(16 * 1024);
+  const InternId id = interner->cnt++;
+  interner->strs[id] = arenaStrdup(interner->arena, str);
+  interner->hashes[id] = h;
+  interner->slots[i] = id;
+  return id;
+}
+
+// @return the interned string, no copy.
+const char* internedStr(const InternId id) {
+  const struct Interner *interner = currentInterner();
+  assert(0 <= id && id < interner->cnt);
+  return interner->strs[id];
+}
+
+int internedCount() {
+  return currentInterner()->cnt;
+}
+
+void freeInterner() {
+  CompilerContext *ctx = currentContext();
+  if (ctx == NULL || ctx->interner == NULL) return;
+  struct Interner *interner = ctx->interner;
+  freeArena(interner->arena);
+  free(interner->strs);
+  free(interner->hashes);
+  free(interner->slots);
+  free(interner);
+  ctx->interner = NULL;
+}
+
+#undef INTERNER_INIT_SLOTS
+
+///// Accounting allocator /////////////////////////////////
+
+// from here on, use the allocator of libc itself
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+/* every thread counts its own allocations, so that each compilation of a batch,
+ * which runs from start to end on one thread, is measured alone */
+static _Thread_local AllocStats alloc_stats;
+
+static void countAlloc(void *ptr) {
+  if (ptr == NULL) return;
+  const size_t size = malloc_usable_size(ptr);
+  alloc_stats.allocs++;
+  alloc_stats.bytes += size;
+  alloc_stats.live += size;
+  if (alloc_stats.live > alloc_stats.peak) alloc_stats.peak = alloc_stats.live;
+}
+
+static void countFree(void *ptr) {
+  if (ptr == NULL) return;
+  const size_t size = malloc_usable_size(ptr);
+  alloc_stats.frees++;
+  // memory from libc was never counted in, don't let live wrap around
+  alloc_stats.live = alloc_stats.live > size ? alloc_stats.live - size : 0;
+}
+
+void* countedMalloc(const size_t size) {
+  void *ptr = malloc(size);
+  countAlloc(ptr);
+  return ptr;
+}
+
+void* countedCalloc(const size_t num, const size_t size) {
+  void *ptr = calloc(num, size);
+  countAlloc(ptr);
+  return ptr;
+}
+
+void* countedRealloc(void *ptr, const size_t size) {
+  countFree(ptr);
+  void *new_ptr = realloc(ptr, size);
+  // a failed realloc leaves the old block in place
+  countAlloc(new_ptr == NULL && size != 0 ? ptr : new_ptr);
+  return new_ptr;
+}
+
+void countedFree(void *ptr) {
+  countFree(ptr);
+  free(ptr);
+}
+
+// @return the counters of the calling thread
+AllocStats allocStats() {
+  return alloc_stats;
+}
+
+// start a new peak from what is in use now
+void resetAllocPeak() {
+  alloc_stats.peak = alloc_stats.live;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -27,6 +28,12 @@
 
 #define RESIZE(capacity) (capacity) = ((capacity) + ((capacity) >> 1))
 
+// sets of small non-negative integers, kept in words of 64 bits
+#define BIT_WORDS(n) (((n) + 63) / 64)
+#define SET_BIT(set, i) ((set)[(i) >> 6] |= (uint64_t) 1 << ((i) & 63))
+#define CLEAR_BIT(set, i) ((set)[(i) >> 6] &= ~((uint64_t) 1 << ((i) & 63)))
+#define TEST_BIT(set, i) ((bool) ((set)[(i) >> 6] >> ((i) & 63) & 1))
+
 /**
  * @brief swap the contents which are pointed by `a` and `b` respectively, int a
  * byte-to-byte way
@@ -60,5 +67,64 @@ void removeDuplicates(void *base, size_t *len, size_t size, __compar_fn_t cmp);
 int findInArray(const void *key, bool is_sorted, const void *base, size_t len,
                 size_t size, __compar_fn_t cmp);
 void shuffleArray(void *base, size_t len, size_t size);
+uint32_t hashString(const char *str);
+
+// relational operators, from the RELOP token down to the branches of MIPS
+typedef enum {
+  REL_EQ, REL_NE, REL_LT, REL_LE, REL_GT, REL_GE,
+} Relop;
+
+extern const char *const relopNames[];
+
+// bump allocator, every block is released at once by `freeArena`
+typedef struct Arena Arena;
+
+Arena* createArena(size_t chunk_size);
+void* arenaAlloc(Arena *arena, size_t size);
+char* arenaStrdup(Arena *arena, const char *src);
+void freeArena(Arena *arena);
+
+/* everything one compilation owns beyond a single phase. each phase binds the
+ * context to the calling thread, so that several files can be compiled one
+ * after another, or on several threads at once. */
+typedef struct CompilerContext {
+  FILE *diagnostics;          // where errors are reported, stdout by default
+  int error_cnt;              // lexical, syntax and semantic errors reported so far
+  struct Interner *interner;  // created on the first `intern`
+  Arena *parse_arena;         // every node of the parse tree
+  struct ParseTNode *root;
+  struct TypeTable *types;    // created on the first array or struct type
+} CompilerContext;
+
+CompilerContext* createContext();
+void freeContext(CompilerContext *ctx);
+void bindContext(CompilerContext *ctx);
+CompilerContext* currentContext();
+
+// string interner of the current context, each distinct string is stored once
+typedef int InternId;
+
+InternId intern(const char *str);
+const char* internedStr(InternId id);
+int internedCount();
+void freeInterner();
+
+/* accounting allocator, every allocation made through the functions below, or the
+ * macros of CountedAlloc.h, is counted by the thread that made it.
+ * the counters only read `malloc_usable_size`, so memory from libc (strdup, asprintf)
+ * can still be released by the counted `free`. */
+typedef struct {
+  size_t allocs;     // calls of malloc, calloc and realloc
+  size_t frees;
+  size_t bytes;      // allocated in total
+  size_t live, peak; // currently in use, and the most ever since the last `resetAllocPeak`
+} AllocStats;
+
+void* countedMalloc(size_t size);
+void* countedCalloc(size_t num, size_t size);
+void* countedRealloc(void *ptr, size_t size);
+void countedFree(void *ptr);
+AllocStats allocStats();
+void resetAllocPeak();
 
 #endif